@@ -0,0 +1,187 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <Benchmark.hpp>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <thread>
+#include <lang/Json.hpp>
+
+namespace Logic {
+static double getSeconds(const chrono::steady_clock::time_point &start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Extrapolates the time of a run from the last two measured ones, assuming that it grows exponentially with the
+// number of variables. That holds for most of the truth table operations, and is a safe overestimate for the rest.
+static double predictSeconds(const BenchmarkResult &previous, const BenchmarkResult &last, const unsigned numVariables) {
+    const double growth = last.secondsPerIteration / previous.secondsPerIteration;
+    if (growth <= 1) {
+        return last.secondsPerIteration;
+    }
+    const double exponent = (double) (numVariables - last.numVariables) / (double) (last.numVariables - previous.numVariables);
+    return last.secondsPerIteration * pow(growth, exponent);
+}
+
+static BenchmarkResult measure(const Benchmark &benchmark, const unsigned numVariables, const double minTime) {
+    BenchmarkRun run = benchmark.setup(numVariables);
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.numVariables = numVariables;
+    result.skipped = false;
+    result.iterations = 0;
+
+    const auto start = chrono::steady_clock::now();
+    double elapsed;
+    do {
+        run();
+        ++result.iterations;
+        elapsed = getSeconds(start);
+    } while (elapsed < minTime);
+
+    result.secondsPerIteration = elapsed / (double) result.iterations;
+    result.rowsPerSecond = benchmark.rows(numVariables) / result.secondsPerIteration;
+    result.bytesPerSecond = benchmark.bytes(numVariables) / result.secondsPerIteration;
+    return result;
+}
+
+static BenchmarkResult getSkippedResult(const Benchmark &benchmark, const unsigned numVariables) {
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.numVariables = numVariables;
+    result.skipped = true;
+    result.iterations = 0;
+    result.secondsPerIteration = 0;
+    result.rowsPerSecond = 0;
+    result.bytesPerSecond = 0;
+    return result;
+}
+
+vector<BenchmarkResult> runBenchmarks(const vector<Benchmark> &benchmarks, const BenchmarkOptions &options, ostream &progress) {
+    vector<BenchmarkResult> results;
+    for (const Benchmark &benchmark : benchmarks) {
+        if (benchmark.name.find(options.filter) == string::npos) {
+            continue;
+        }
+
+        vector<BenchmarkResult> measured;
+        bool tooSlow = false;
+        for (unsigned numVariables = options.minVariables; numVariables <= options.maxVariables; numVariables += options.step) {
+            if (!tooSlow && measured.size() >= 2) {
+                tooSlow = predictSeconds(measured[measured.size() - 2], measured.back(), numVariables) > options.maxRunTime;
+            }
+
+            BenchmarkResult result = tooSlow ? getSkippedResult(benchmark, numVariables) : measure(benchmark, numVariables, options.minTime);
+            if (!result.skipped) {
+                measured.push_back(result);
+                tooSlow = result.secondsPerIteration > options.maxRunTime;
+            }
+
+            progress << result << endl;
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+
+string getSiValue(const double value) {
+    static const char *prefixes[] = { "", "k", "M", "G", "T" };
+    size_t prefix = 0;
+    double scaled = value;
+    while (scaled >= 1000 && prefix < sizeof(prefixes) / sizeof(prefixes[0]) - 1) {
+        scaled /= 1000;
+        ++prefix;
+    }
+    stringstream out;
+    out << fixed << setprecision(2) << scaled << ' ' << prefixes[prefix];
+    return out.str();
+}
+
+string getDuration(const double seconds) {
+    static const char *units[] = { "s", "ms", "us", "ns" };
+    size_t unit = 0;
+    double scaled = seconds;
+    while (scaled < 1 && unit < sizeof(units) / sizeof(units[0]) - 1) {
+        scaled *= 1000;
+        ++unit;
+    }
+    stringstream out;
+    out << fixed << setprecision(2) << scaled << ' ' << units[unit];
+    return out.str();
+}
+
+ostream &operator<<(ostream &os, const BenchmarkResult &result) {
+    os << left << setw(32) << result.name << right << setw(3) << result.numVariables << " variables: ";
+    if (result.skipped) {
+        os << "skipped, too slow";
+        return os;
+    }
+
+    os << result.iterations << " iterations, "
+       << getDuration(result.secondsPerIteration) << "/iteration, "
+       << getSiValue(result.rowsPerSecond) << "rows/s, "
+       << getSiValue(result.bytesPerSecond) << "B/s";
+    return os;
+}
+
+static string getTimestamp() {
+    const time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    return timestamp;
+}
+
+void writeJsonContext(ostream &os) {
+    os << "  \"context\": {"
+       << "\"timestamp\": " << toJson(getTimestamp())
+#ifdef __VERSION__
+       << ", \"compiler\": " << toJson(string(__VERSION__))
+#endif
+#ifdef NDEBUG
+       << ", \"assertions\": false"
+#else
+       << ", \"assertions\": true"
+#endif
+       << ", \"hardware_threads\": " << thread::hardware_concurrency()
+       << "}," << endl;
+}
+
+void writeJson(const vector<BenchmarkResult> &results, ostream &os) {
+    os << "{" << endl;
+    writeJsonContext(os);
+    os << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult &result = results[i];
+        os << (i == 0 ? "" : ",") << endl
+           << "    {\"name\": " << toJson(result.name)
+           << ", \"variables\": " << result.numVariables
+           << ", \"skipped\": " << (result.skipped ? "true" : "false");
+        if (!result.skipped) {
+            os << setprecision(6)
+               << ", \"iterations\": " << result.iterations
+               << ", \"ns_per_iteration\": " << result.secondsPerIteration * 1e9
+               << ", \"rows_per_second\": " << result.rowsPerSecond
+               << ", \"bytes_per_second\": " << result.bytesPerSecond;
+        }
+        os << "}";
+    }
+    os << endl << "  ]" << endl << "}" << endl;
+}
+}
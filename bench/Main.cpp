@@ -0,0 +1,166 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <Benchmark.hpp>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <core/Utils.hpp>
+#include <core/TruthTableTypes.hpp>
+#include <algorithm>
+#include <dirent.h>
+
+using namespace Logic;
+
+static void printHelp() {
+    cout << "usage: logic_bench [options]" << endl;
+    cout << "  Runs the microbenchmarks, sweeping over the numbers of variables, or the script benchmarks" << endl;
+    cout << "  options:" << endl;
+    cout << "      --scripts path             : runs the Logic scripts in the directory (or the single script file) through" << endl;
+    cout << "                                   the interpreter, instead of the microbenchmarks" << endl;
+    cout << "      --variables min:max[:step] : the numbers of variables to sweep. Defaults to 4:28:4" << endl;
+    cout << "      --filter name              : only runs the benchmarks (or scripts) with a name containing this" << endl;
+    cout << "      --min-time seconds         : the minimum time spent measuring each benchmark for a number of variables," << endl;
+    cout << "                                   or each script. Defaults to 0.2" << endl;
+    cout << "      --max-run-time seconds     : skips the rest of a benchmark's sweep once a single run takes, or is" << endl;
+    cout << "                                   predicted to take, longer than this. Defaults to 2" << endl;
+    cout << "      --json path                : writes the results as JSON to the file, or to stdout if it's -" << endl;
+    cout << "      -h, --help                 : print this usage info" << endl;
+}
+
+static unsigned parseUnsigned(const string &value) {
+    size_t parsed;
+    const unsigned long result = stoul(value, &parsed);
+    if (parsed != value.length()) {
+        throw invalid_argument("Not a number: " + value);
+    }
+    return (unsigned) result;
+}
+
+static double parsePositiveDouble(const string &value) {
+    size_t parsed;
+    const double result = stod(value, &parsed);
+    if (parsed != value.length() || result <= 0) {
+        throw invalid_argument("Not a positive number: " + value);
+    }
+    return result;
+}
+
+static void parseVariables(const string &value, BenchmarkOptions &options) {
+    const vector<string> parts = split(value, ':');
+    if (parts.size() < 2 || parts.size() > 3) {
+        throw invalid_argument("Expected min:max[:step], but got: " + value);
+    }
+    options.minVariables = parseUnsigned(parts[0]);
+    options.maxVariables = parseUnsigned(parts[1]);
+    options.step = parts.size() == 3 ? parseUnsigned(parts[2]) : 1;
+    // The Conditions benchmark needs a variable left over
+    if (options.minVariables < 2 || options.maxVariables > MAX_NUM_VARIABLES || options.minVariables > options.maxVariables || options.step == 0) {
+        throw invalid_argument("Expected 2 <= min <= max <= " + to_string(MAX_NUM_VARIABLES) + ", and step > 0");
+    }
+}
+
+// The files in the directory in the order of their names, or the path itself if it's not a directory
+static vector<string> getScriptPaths(const string &path) {
+    DIR *directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        return { path };
+    }
+
+    vector<string> paths;
+    while (const dirent *entry = readdir(directory)) {
+        const string name = entry->d_name;
+        if (name.front() != '.') {
+            paths.push_back(path + "/" + name);
+        }
+    }
+    closedir(directory);
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+static int writeResults(const string &jsonPath, function<void(ostream &)> writeJson) {
+    if (jsonPath == "-") {
+        writeJson(cout);
+    } else if (!jsonPath.empty()) {
+        ofstream json(jsonPath);
+        if (!json) {
+            cerr << "ERROR: Couldn't open " << jsonPath << endl;
+            return 1;
+        }
+        writeJson(json);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    BenchmarkOptions options;
+    string jsonPath;
+    string scriptsPath;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const string option = argv[i];
+            if (option == "-h" || option == "--help") {
+                printHelp();
+                return 0;
+            }
+            if (i + 1 == argc) {
+                throw invalid_argument("Expected a value for " + option);
+            }
+
+            const string value = argv[++i];
+            if (option == "--variables") {
+                parseVariables(value, options);
+            } else if (option == "--filter") {
+                options.filter = value;
+            } else if (option == "--min-time") {
+                options.minTime = parsePositiveDouble(value);
+            } else if (option == "--max-run-time") {
+                options.maxRunTime = parsePositiveDouble(value);
+            } else if (option == "--scripts") {
+                scriptsPath = value;
+            } else if (option == "--json") {
+                jsonPath = value;
+            } else {
+                throw invalid_argument("Unknown option: " + option);
+            }
+        }
+    } catch (const exception &ex) {
+        cerr << "ERROR: " << ex.what() << endl;
+        printHelp();
+        return 1;
+    }
+
+    // Keep stdout clean for the JSON
+    ostream &progress = jsonPath == "-" ? cerr : cout;
+
+    if (!scriptsPath.empty()) {
+        vector<ScriptBenchmarkResult> results;
+        try {
+            results = runScriptBenchmarks(getScriptPaths(scriptsPath), options, progress);
+        } catch (const exception &ex) {
+            cerr << "ERROR: " << ex.what() << endl;
+            return 1;
+        }
+        return writeResults(jsonPath, [&](ostream &os) { writeJson(results, os); });
+    }
+
+    vector<Benchmark> benchmarks;
+    registerCoreBenchmarks(benchmarks);
+    const vector<BenchmarkResult> results = runBenchmarks(benchmarks, options, progress);
+    return writeResults(jsonPath, [&](ostream &os) { writeJson(results, os); });
+}
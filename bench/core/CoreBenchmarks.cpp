@@ -0,0 +1,207 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <Benchmark.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <core/Operators.hpp>
+#include <algorithm>
+#include <memory>
+
+namespace Logic {
+static double getRows(const unsigned numVariables) {
+    return pow(2, numVariables);
+}
+
+// Bytes of a truth table at a bit per row
+static double getTableBytes(const unsigned numVariables) {
+    return getRows(numVariables) / 8;
+}
+
+static vector<string> getVariables(const unsigned from, const unsigned to) {
+    vector<string> variables;
+    for (unsigned i = from; i < to; ++i) {
+        variables.push_back("v" + to_string(i));
+    }
+    return variables;
+}
+
+static TruthTable getRandomTable(const vector<string> &variables, uint64_t seed) {
+    TruthTable table(variables);
+    for (TruthTableUInt i = 0; i < table.size(); ++i) {
+        // xorshift64
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        table[i] = (seed & 1) == 1;
+    }
+    return table;
+}
+
+// The operands have disjoint halves of the variables
+static Benchmark getDisjointBinaryOperatorBenchmark(const string &name, const shared_ptr<BinaryOperator> &_operator) {
+    return {
+        name + "/disjoint",
+        [=](const unsigned numVariables) -> BenchmarkRun {
+            const BooleanFunction first(getRandomTable(getVariables(0, numVariables / 2), 1));
+            const BooleanFunction second(getRandomTable(getVariables(numVariables / 2, numVariables), 2));
+            return [=]() { keep((*_operator)(first, second)); };
+        },
+        getRows,
+        [](const unsigned numVariables) {
+            return getTableBytes(numVariables / 2) + getTableBytes(numVariables - numVariables / 2) + getTableBytes(numVariables);
+        }
+    };
+}
+
+// The operands have the same variables, in the reverse order of each other
+static Benchmark getSharedBinaryOperatorBenchmark(const string &name, const shared_ptr<BinaryOperator> &_operator) {
+    return {
+        name + "/shared",
+        [=](const unsigned numVariables) -> BenchmarkRun {
+            vector<string> variables = getVariables(0, numVariables);
+            const BooleanFunction first(getRandomTable(variables, 1));
+            reverse(variables.begin(), variables.end());
+            const BooleanFunction second(getRandomTable(variables, 2));
+            return [=]() { keep((*_operator)(first, second)); };
+        },
+        getRows,
+        [](const unsigned numVariables) {
+            return 3 * getTableBytes(numVariables);
+        }
+    };
+}
+
+static Benchmark getUnaryOperatorBenchmark(const string &name, const shared_ptr<UnaryOperator> &_operator, function<double(unsigned)> rows, function<double(unsigned)> bytes) {
+    return {
+        name,
+        [=](const unsigned numVariables) -> BenchmarkRun {
+            const BooleanFunction in(getRandomTable(getVariables(0, numVariables), 1));
+            return [=]() { keep((*_operator)(in)); };
+        },
+        rows,
+        bytes
+    };
+}
+
+void registerCoreBenchmarks(vector<Benchmark> &benchmarks) {
+    benchmarks.push_back({
+        "TruthTable/construct",
+        [](const unsigned numVariables) -> BenchmarkRun {
+            const vector<string> variables = getVariables(0, numVariables);
+            return [=]() { keep(getRandomTable(variables, 1)); };
+        },
+        getRows,
+        getTableBytes
+    });
+
+    benchmarks.push_back(getDisjointBinaryOperatorBenchmark("And", make_shared<And>()));
+    benchmarks.push_back(getDisjointBinaryOperatorBenchmark("Or", make_shared<Or>()));
+    benchmarks.push_back(getDisjointBinaryOperatorBenchmark("Xor", make_shared<Xor>()));
+    benchmarks.push_back(getSharedBinaryOperatorBenchmark("And", make_shared<And>()));
+    benchmarks.push_back(getSharedBinaryOperatorBenchmark("Or", make_shared<Or>()));
+    benchmarks.push_back(getSharedBinaryOperatorBenchmark("Xor", make_shared<Xor>()));
+
+    benchmarks.push_back(getUnaryOperatorBenchmark("Not", make_shared<Not>(), getRows, [](const unsigned numVariables) {
+        return 2 * getTableBytes(numVariables);
+    }));
+    // Conditions on the least significant variable
+    benchmarks.push_back(getUnaryOperatorBenchmark("Conditions", shared_ptr<UnaryOperator>(new Conditions({ { "v0", true } })), getRows, [](const unsigned numVariables) {
+        return getTableBytes(numVariables) + getTableBytes(numVariables - 1);
+    }));
+    // Quantifiers on the least significant variables, which are packed within the words
+    benchmarks.push_back(getUnaryOperatorBenchmark("Exists", make_shared<Exists>(vector<string>({ "v0", "v1" })), getRows, [](const unsigned numVariables) {
+        return getTableBytes(numVariables) + getTableBytes(numVariables - 2);
+    }));
+    benchmarks.push_back(getUnaryOperatorBenchmark("Forall", make_shared<Forall>(vector<string>({ "v0" })), getRows, [](const unsigned numVariables) {
+        return getTableBytes(numVariables) + getTableBytes(numVariables - 1);
+    }));
+    // A single row lookup
+    const auto single = [](const unsigned numVariables) {
+        UNUSED(numVariables);
+        return 1.0;
+    };
+    benchmarks.push_back(getUnaryOperatorBenchmark("Index", make_shared<Index>(1), single, [=](const unsigned numVariables) {
+        return single(numVariables) / 8;
+    }));
+
+    benchmarks.push_back({
+        "operator==",
+        [](const unsigned numVariables) -> BenchmarkRun {
+            vector<string> variables = getVariables(0, numVariables);
+            const BooleanFunction first(getRandomTable(variables, 1));
+            // The same function with its variables in the reverse order, so that every row needs to be compared
+            TruthTable reversed(vector<string>(variables.rbegin(), variables.rend()));
+            for (TruthTableUInt i = 0; i < reversed.size(); ++i) {
+                TruthTableUInt j = 0;
+                for (unsigned bit = 0; bit < numVariables; ++bit) {
+                    j |= ((i >> bit) & 1) << (numVariables - bit - 1);
+                }
+                reversed[j] = first.getTruthTable()[i];
+            }
+            const BooleanFunction second(reversed);
+            return [=]() { keep(first == second); };
+        },
+        getRows,
+        [](const unsigned numVariables) {
+            return 2 * getTableBytes(numVariables);
+        }
+    });
+
+    benchmarks.push_back({
+        "getMinterms",
+        [](const unsigned numVariables) -> BenchmarkRun {
+            const TruthTable table = getRandomTable(getVariables(0, numVariables), 1);
+            return [=]() { keep(table.getMinterms()); };
+        },
+        getRows,
+        getTableBytes
+    });
+
+    benchmarks.push_back({
+        "operator<<",
+        [](const unsigned numVariables) -> BenchmarkRun {
+            const BooleanFunction function(getRandomTable(getVariables(0, numVariables), 1));
+            return [=]() {
+                NullBuffer buffer;
+                ostream out(&buffer);
+                out << function;
+            };
+        },
+        getRows,
+        getTableBytes
+    });
+
+    benchmarks.push_back({
+        "BooleanFunctionParser/parse",
+        [](const unsigned numVariables) -> BenchmarkRun {
+            // v0 & v1 | v2 ^ v3 & v4 ...
+            static const vector<string> operators({ AND_OPERATOR, OR_OPERATOR, XOR_OPERATOR });
+            const vector<string> variables = getVariables(0, numVariables);
+            string function = variables[0];
+            for (size_t i = 1; i < variables.size(); ++i) {
+                function += " " + operators[(i - 1) % operators.size()] + " " + variables[i];
+            }
+            return [=]() { keep(BooleanFunctionParser().parse(function)); };
+        },
+        getRows,
+        // Every operator reads its operands and writes a table twice as large, up to the result
+        [](const unsigned numVariables) {
+            return 3 * getTableBytes(numVariables);
+        }
+    });
+}
+}
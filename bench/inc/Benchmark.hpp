@@ -0,0 +1,124 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <core/Utils.hpp>
+
+using namespace std;
+
+namespace Logic {
+// A single timed run of a benchmark. The setup of its inputs happens before, and isn't timed.
+typedef function<void()> BenchmarkRun;
+
+struct Benchmark {
+    string name;
+    // Prepares the inputs for the given number of variables, and returns the run that's timed
+    function<BenchmarkRun(unsigned)> setup;
+    // The number of truth table rows that a run produces or consumes, for the given number of variables
+    function<double(unsigned)> rows;
+    // The number of bytes that a run reads and writes, for the given number of variables. Truth table values count
+    // as a bit per row, regardless of how they're stored.
+    function<double(unsigned)> bytes;
+};
+
+struct BenchmarkOptions {
+    // The numbers of variables swept for every benchmark: min, min + step, ..., up to max
+    unsigned minVariables = 4;
+    unsigned maxVariables = 28;
+    unsigned step = 4;
+    // Only the benchmarks with a name containing this are run
+    string filter;
+    // The minimum time spent running a benchmark for a number of variables, in seconds
+    double minTime = 0.2;
+    // A benchmark's sweep stops when a run takes, or is predicted to take, longer than this many seconds
+    double maxRunTime = 2.0;
+};
+
+struct BenchmarkResult {
+    string name;
+    unsigned numVariables;
+    // Skipped because a run would take longer than BenchmarkOptions::maxRunTime
+    bool skipped;
+    uint64_t iterations;
+    double secondsPerIteration;
+    double rowsPerSecond;
+    double bytesPerSecond;
+};
+
+// The latencies of the executions of a command, in nanoseconds
+struct LatencySummary {
+    uint64_t count;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+struct ScriptBenchmarkResult {
+    string name;
+    uint64_t iterations;
+    double secondsPerIteration;
+    // Including the statements nested in the blocks of the other statements
+    double statementsPerSecond;
+    // By the command name, as written in the script
+    map<string, LatencySummary> commandLatencies;
+    // The peak resident set size of the whole process so far, so it never decreases from one script to the next
+    long peakRssKiB;
+};
+
+void registerCoreBenchmarks(vector<Benchmark> &benchmarks);
+
+// Runs the benchmarks, and writes a line about each result to progress as it's available
+vector<BenchmarkResult> runBenchmarks(const vector<Benchmark> &benchmarks, const BenchmarkOptions &options, ostream &progress);
+ostream &operator<<(ostream &os, const BenchmarkResult &result);
+void writeJson(const vector<BenchmarkResult> &results, ostream &os);
+
+// Runs the scripts at the paths through the Interpreter, with the output discarded
+vector<ScriptBenchmarkResult> runScriptBenchmarks(const vector<string> &paths, const BenchmarkOptions &options, ostream &progress);
+ostream &operator<<(ostream &os, const ScriptBenchmarkResult &result);
+void writeJson(const vector<ScriptBenchmarkResult> &results, ostream &os);
+
+void writeJsonContext(ostream &os);
+string getDuration(const double seconds);
+string getSiValue(const double value);
+
+// A stream buffer that discards everything written to it
+class NullBuffer : public streambuf {
+protected:
+    virtual int overflow(int c) override {
+        return c;
+    }
+
+    virtual streamsize xsputn(const char *s, streamsize n) override {
+        UNUSED(s);
+        return n;
+    }
+};
+
+// Keeps the compiler from optimizing away the computation of the value
+template <typename T>
+void keep(const T &value) {
+    __asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+}
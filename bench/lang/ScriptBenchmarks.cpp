@@ -0,0 +1,173 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <Benchmark.hpp>
+#include <lang/Interpreter.hpp>
+#include <lang/Json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+
+namespace Logic {
+// Collects the latencies of the commands. The scripts are executed without a thread pool, so this is only called from
+// a single thread.
+class LatencyRecorder : public CommandObserver {
+public:
+    virtual void onCommandExecuted(const string &command, const chrono::steady_clock::duration &elapsed) override {
+        latencies[command].push_back((double) chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+        ++statements;
+    }
+
+    map<string, vector<double>> latencies;
+    uint64_t statements = 0;
+};
+
+// The nearest-rank percentile of the sorted values
+static double getPercentile(const vector<double> &sorted, const double percentile) {
+    const size_t rank = (size_t) ceil(percentile / 100 * (double) sorted.size());
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+static LatencySummary summarize(vector<double> &latencies) {
+    sort(latencies.begin(), latencies.end());
+    LatencySummary summary;
+    summary.count = latencies.size();
+    summary.p50 = getPercentile(latencies, 50);
+    summary.p90 = getPercentile(latencies, 90);
+    summary.p99 = getPercentile(latencies, 99);
+    summary.max = latencies.back();
+    return summary;
+}
+
+static long getPeakRssKiB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    // In kilobytes on Linux
+    return usage.ru_maxrss;
+}
+
+static string getScriptName(const string &path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+static ScriptBenchmarkResult runScript(const string &path, const string &code, const double minTime) {
+    DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+    NullBuffer buffer;
+    ostream out(&buffer);
+    LatencyRecorder recorder;
+
+    ScriptBenchmarkResult result;
+    result.name = getScriptName(path);
+    result.iterations = 0;
+
+    const auto start = chrono::steady_clock::now();
+    double elapsed;
+    do {
+        Runtime runtime;
+        stringstream in(code);
+        Interpreter interpreter(runtime, dispatchTable, in, out, false);
+        interpreter.setCommandObserver(&recorder);
+        try {
+            interpreter.run();
+        } catch (const exception &ex) {
+            throw runtime_error(path + ": " + ex.what());
+        }
+        ++result.iterations;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < minTime);
+
+    result.secondsPerIteration = elapsed / (double) result.iterations;
+    result.statementsPerSecond = (double) recorder.statements / elapsed;
+    for (auto &latencies : recorder.latencies) {
+        result.commandLatencies[latencies.first] = summarize(latencies.second);
+    }
+    result.peakRssKiB = getPeakRssKiB();
+    return result;
+}
+
+vector<ScriptBenchmarkResult> runScriptBenchmarks(const vector<string> &paths, const BenchmarkOptions &options, ostream &progress) {
+    vector<ScriptBenchmarkResult> results;
+    for (const string &path : paths) {
+        if (getScriptName(path).find(options.filter) == string::npos) {
+            continue;
+        }
+
+        ifstream file(path);
+        if (!file) {
+            throw runtime_error("Couldn't open " + path);
+        }
+        stringstream code;
+        code << file.rdbuf();
+
+        results.push_back(runScript(path, code.str(), options.minTime));
+        progress << results.back() << endl;
+    }
+    return results;
+}
+
+ostream &operator<<(ostream &os, const ScriptBenchmarkResult &result) {
+    os << result.name << ": " << result.iterations << " iterations, "
+       << getDuration(result.secondsPerIteration) << "/iteration, "
+       << getSiValue(result.statementsPerSecond) << "statements/s, peak RSS " << result.peakRssKiB << " KiB" << endl;
+    for (const auto &command : result.commandLatencies) {
+        const LatencySummary &summary = command.second;
+        os << "    " << left << setw(10) << command.first << right << setw(9) << summary.count << " executions,"
+           << " p50 " << getDuration(summary.p50 / 1e9)
+           << ", p90 " << getDuration(summary.p90 / 1e9)
+           << ", p99 " << getDuration(summary.p99 / 1e9)
+           << ", max " << getDuration(summary.max / 1e9) << endl;
+    }
+    return os;
+}
+
+void writeJson(const vector<ScriptBenchmarkResult> &results, ostream &os) {
+    os << "{" << endl;
+    writeJsonContext(os);
+    os << "  \"scripts\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ScriptBenchmarkResult &result = results[i];
+        os << (i == 0 ? "" : ",") << endl
+           << setprecision(6)
+           << "    {\"name\": " << toJson(result.name)
+           << ", \"iterations\": " << result.iterations
+           << ", \"ns_per_iteration\": " << result.secondsPerIteration * 1e9
+           << ", \"statements_per_second\": " << result.statementsPerSecond
+           << ", \"peak_rss_kib\": " << result.peakRssKiB
+           << ", \"commands\": {";
+        bool first = true;
+        for (const auto &command : result.commandLatencies) {
+            const LatencySummary &summary = command.second;
+            os << (first ? "" : ", ") << toJson(command.first) << ": {"
+               << "\"count\": " << summary.count
+               << ", \"p50_ns\": " << summary.p50
+               << ", \"p90_ns\": " << summary.p90
+               << ", \"p99_ns\": " << summary.p99
+               << ", \"max_ns\": " << summary.max << "}";
+            first = false;
+        }
+        os << "}}";
+    }
+    os << endl << "  ]" << endl << "}" << endl;
+}
+}
@@ -0,0 +1,35 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+namespace Logic {
+// Frames larger than this are rejected, so that a bad peer can't make the reader allocate arbitrary amounts of memory
+constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+// Reads a 4 byte big endian length followed by that many bytes of payload from the file descriptor. Returns false if
+// the descriptor is closed or fails before a whole frame is read, or if the frame is larger than MAX_FRAME_SIZE.
+bool readFrame(const int fd, string &payload);
+
+// Writes the payload with its 4 byte big endian length. Returns false without writing anything if the payload is larger
+// than MAX_FRAME_SIZE, and false if the descriptor fails.
+bool writeFrame(const int fd, const string &payload);
+}
@@ -19,7 +19,13 @@
 #include <memory>
 #include <lang/Runtime.hpp>
 #include <lang/DispatchTable.hpp>
+#include <app/Workspaces.hpp>
+#include <condition_variable>
 #include <istream>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <string>
 
 using namespace std;
 
@@ -47,6 +53,16 @@ struct CodeExecutionModeConfig {
     const bool terminateOnFailure;
     const bool ownCodeStream;
     const bool printPrompts;
+    // Independent statements and subexpressions are evaluated concurrently if > 1
+    const size_t numThreads;
+    // Collects the stats shown by the 'stats' command, and prints them to stderr at the end
+    const bool profile;
+    // If not empty, the spans of the execution are written to this file as a Chrome trace at the end
+    const string tracePath;
+    // The bytes that the workspace and an evaluation can take together. See Runtime::setMaxMemory().
+    const uint64_t maxMemory;
+    // Removes the variables that the evaluated functions don't depend on. See EvaluationOptions::reduceSupport.
+    const bool reduceSupport;
 };
 
 class CodeExecutionMode : public Mode {
@@ -65,5 +81,72 @@ private:
     istream *codeStream;
 };
 
+// Executes many scripts concurrently, each in its own workspace. The outputs are printed in the order of the scripts,
+// and the errors after their scripts' output. Returns 1 if any of the scripts failed.
+class BatchMode : public Mode {
+public:
+    BatchMode(const size_t numJobs, const vector<string> &&paths, const uint64_t maxMemory, ostream &out, ostream &err)
+        : numJobs(numJobs), paths(paths), maxMemory(maxMemory), out(out), err(err) {
+    }
+
+    virtual int run() override;
+
+private:
+    const size_t numJobs;
+    const vector<string> paths;
+    // Per script
+    const uint64_t maxMemory;
+    ostream &out;
+    ostream &err;
+};
+
+/**
+ * Listens on a Unix domain socket, and executes the scripts sent by the clients in named workspaces that stay resident
+ * for the lifetime of the server. Every message is framed as a 4 byte big endian length followed by the payload.
+ * A request's payload is the workspace name, a '\n', and the code. A response's payload is a status line ("OK", or
+ * "ERROR: <message>"), followed by the output of the script. A connection can be used for any number of requests.
+ * At most maxConnections connections are served at a time; the next ones wait in the socket's backlog.
+ */
+class ServerMode : public Mode {
+public:
+    ServerMode(const string &&socketPath, const uint64_t maxMemory, const size_t maxConnections = 64)
+        : socketPath(socketPath), workspaces(maxMemory), maxConnections(maxConnections) {
+    }
+
+    virtual int run() override;
+
+private:
+    const string socketPath;
+    Workspaces workspaces;
+    const size_t maxConnections;
+    mutex connectionsMutex;
+    condition_variable connectionClosed;
+    size_t numConnections = 0;
+
+    void serve(const int connection);
+};
+
+/**
+ * Reads one JSON request per line from stdin, and writes one JSON response per line to stdout, in the same order.
+ * A request is {"id": <any>, "script": <code>, "workspace": <name>, "format": "text" | "json"}, where only the
+ * script is required. The requests are executed concurrently on a pool of threads, except for the ones for the same
+ * workspace, which are executed in the order they were read. Without a workspace, a script gets a new empty one.
+ * A response to a bad request has the request's id, if it could be read.
+ */
+class JsonLinesMode : public Mode {
+public:
+    JsonLinesMode(const size_t numThreads, const uint64_t maxMemory, istream &in, ostream &out)
+        : numThreads(numThreads), workspaces(maxMemory), in(in), out(out) {
+    }
+
+    virtual int run() override;
+
+private:
+    const size_t numThreads;
+    Workspaces workspaces;
+    istream &in;
+    ostream &out;
+};
+
 unique_ptr<Mode> getMode(const int argc, const char * const *argv);
 }
@@ -0,0 +1,76 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <lang/Runtime.hpp>
+#include <lang/DispatchTable.hpp>
+
+using namespace std;
+
+namespace Logic {
+struct ScriptResult {
+    string output;
+    // Empty if the script succeeded
+    string error;
+};
+
+// Executes a script in the runtime, and captures its output and error (if any)
+ScriptResult executeScript(istream &code, Runtime &runtime, DispatchTable &dispatchTable);
+
+/**
+ * Named workspaces that stay resident across the requests of a long running mode.
+ * Scripts can be executed concurrently in different workspaces; the ones in the same workspace are serialized.
+ */
+class Workspaces {
+public:
+    // Every workspace's memory is limited to maxMemory bytes. See Runtime::setMaxMemory().
+    Workspaces(const uint64_t maxMemory = numeric_limits<uint64_t>::max())
+        : maxMemory(maxMemory), dispatchTable(createDispatchTableWithAllCommands()) {
+    }
+
+    // Executes the code in the named workspace, creating it if it doesn't exist. Like in the interactive mode, the
+    // changes made by the statements before a failure are kept.
+    ScriptResult execute(const string &workspaceName, const string &code, const OutputFormat format = OutputFormat::Text);
+
+    DispatchTable &getDispatchTable() {
+        return dispatchTable;
+    }
+
+    uint64_t getMaxMemory() const {
+        return maxMemory;
+    }
+
+private:
+    struct Workspace {
+        mutex lock;
+        Runtime runtime;
+    };
+
+    Workspace &getWorkspace(const string &workspaceName);
+
+    const uint64_t maxMemory;
+    DispatchTable dispatchTable;
+    mutex workspacesMutex;
+    unordered_map<string, unique_ptr<Workspace>> workspaces;
+};
+}
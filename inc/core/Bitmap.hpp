@@ -0,0 +1,49 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <core/BooleanFunction.hpp>
+#include <core/ThreadPool.hpp>
+#include <stdint.h>
+
+using namespace std;
+
+namespace Logic {
+struct BitmapEvaluationResult {
+    // 8 times the size of the columns in bytes
+    uint64_t numRecords;
+    // The number of records the function is true at
+    uint64_t count;
+};
+
+/**
+ * Evaluates the function at every record of a dataset stored as bitmap files, and writes the results as a bitmap file at
+ * outputPath. In a bitmap file, the bit (i % 8) of the byte (i / 8) is the value at the record i. columns maps every
+ * variable of the function (and optionally, others) to its column's file, and all of them must have the same size.
+ *
+ * The columns are memory mapped, and evaluated 64 records at a time with bitwise operations on the words of the columns,
+ * so only the pages being read have to be in memory; the dataset may be bigger than it. If threadPool is not null, the
+ * chunks of the records are evaluated concurrently on it.
+ *
+ * Throws invalid_argument if a variable isn't bound, no column is (for a constant function) or the sizes of the columns
+ * differ, and runtime_error if a file can't be mapped.
+ */
+BitmapEvaluationResult evaluateBitmaps(const BooleanFunction &function, const unordered_map<string, string> &columns,
+                                       const string &outputPath, ThreadPool *threadPool = nullptr);
+}
@@ -38,6 +38,9 @@ public:
     bool &getConstantValue();
     bool getConstantValue() const;
 
+    // The bytes held by the truth table. 0 for a constant value function.
+    uint64_t getMemoryUsage() const;
+
 private:
     TruthTable *table;
     bool *constValue;
@@ -49,4 +52,8 @@ private:
 ostream &operator<<(ostream &os, const BooleanFunction &function);
 bool operator==(const BooleanFunction &left, const BooleanFunction &right);
 
+// The same function without the variables that it doesn't depend on, keeping the others in the same order. A constant
+// value function, if it depends on none of them.
+BooleanFunction reduceSupport(const BooleanFunction &function);
+
 }
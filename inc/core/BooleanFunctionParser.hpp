@@ -19,6 +19,8 @@
 #include <string>
 #include <core/Operators.hpp>
 #include <core/BooleanFunction.hpp>
+#include <core/Expression.hpp>
+#include <memory>
 #include <stack>
 #include <functional>
 
@@ -41,6 +43,9 @@ private:
 
 class BooleanFunctionParser {
 public:
+    BooleanFunctionParser(const EvaluationOptions &options = EvaluationOptions()) : options(options) {
+    }
+
     /**
      * Parses a string boolean function into a BooleanFunction object.
      * Note: You should always use parenthesis to specify the operator precedence, because there is no agreed upon
@@ -54,5 +59,12 @@ public:
 
     // The lookup function will be used for resolving variables stating with '$'
     BooleanFunction parse(const string &function, std::function<const BooleanFunction& (const string&)> lookupFunction) const;
+
+    // Compiles the function into an expression tree without evaluating it. The functions returned by the lookup
+    // function are referenced (not copied) by the expression, so they must outlive it.
+    unique_ptr<Expression> compile(const string &function, std::function<const BooleanFunction& (const string&)> lookupFunction) const;
+
+private:
+    const EvaluationOptions options;
 };
 }
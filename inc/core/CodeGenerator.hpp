@@ -0,0 +1,38 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <core/BooleanFunction.hpp>
+
+using namespace std;
+
+namespace Logic {
+/**
+ * Generates the source of a self-contained C99 file defining the function with the given name, and a bit-sliced
+ * variant of it, <name>_64, that evaluates it at 64 assignments at once: the bit i of its result is the function's value
+ * at the bit i of each variable. Both take the variables in the order of the truth table.
+ *
+ * The function of the few variables whose straight-line bitwise expression would take more operations than looking up
+ * the line in the truth table is implemented as a lookup in a packed table. The rest of the functions, and the
+ * bit-sliced variant, are straight-line bitwise expressions: the table's Shannon expansion, with the cofactors that
+ * are equal (or complements) shared between the variables.
+ *
+ * The variables that are C keywords, or collide with the names used by the generated code are suffixed with '_'.
+ */
+string generateC(const BooleanFunction &function, const string &name);
+}
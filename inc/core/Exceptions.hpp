@@ -64,4 +64,16 @@ public:
     BooleanFunctionNotFoundException(const string &message) : LogicException(message) {
     }
 };
-}
\ No newline at end of file
+
+class MemoryLimitExceededException : public LogicException {
+public:
+    MemoryLimitExceededException(const string &message) : LogicException(message) {
+    }
+};
+
+class WorkLimitExceededException : public LogicException {
+public:
+    WorkLimitExceededException(const string &message) : LogicException(message) {
+    }
+};
+}
@@ -0,0 +1,360 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/BooleanFunction.hpp>
+#include <core/FusedOperation.hpp>
+#include <core/Operators.hpp>
+#include <core/TruthTableTypes.hpp>
+
+using namespace std;
+
+namespace Logic {
+class ThreadPool;
+class Profiler;
+class Tracer;
+
+struct EvaluationOptions {
+    // If not null, the independent operands of the big enough binary operations are evaluated concurrently on this pool
+    ThreadPool *threadPool = nullptr;
+    // The minimum number of lines in the result of a binary operation for its operands to be evaluated concurrently
+    TruthTableUInt forkThreshold = ((TruthTableUInt) 1) << 16;
+    // If not null, every operator evaluation is recorded in this profiler
+    Profiler *profiler = nullptr;
+    // If not null, every parse and operator evaluation is traced as a span in this tracer
+    Tracer *tracer = nullptr;
+    // The bytes that an evaluation may allocate at its peak. Parsing fails before evaluating anything bigger.
+    uint64_t memoryBudget = numeric_limits<uint64_t>::max();
+    // The lines that a scan a block at a time (see findLine()) may evaluate. It fails once it's evaluated this many
+    // with no line found yet. The default takes at most about 7 s: estimateDuration() of 2^28 lines at 25 ns per line.
+    TruthTableUInt workBudget = ((TruthTableUInt) 1) << 28;
+    // If set, the compiled conditions are applied on the leaves instead of the evaluated expressions. See Optimizer.hpp
+    bool pushDownConditions = true;
+    // If set, the compiled chains of And, Or and Xor are regrouped to keep the intermediate tables small. See Optimizer.hpp
+    bool reorderChains = true;
+    // If set, the compiled Not, And, Or and Xor operators are fused into single operations. See Optimizer.hpp
+    bool fuseOperators = true;
+    // If set, the variables that a parsed function doesn't depend on are removed from it. See reduceSupport().
+    bool reduceSupport = false;
+};
+
+/**
+ * A compiled Boolean function expression. The leaves are Boolean functions, and the other nodes are operators applied
+ * on their child expressions. The variables of every node's result are known without evaluating it.
+ */
+class Expression {
+public:
+    virtual ~Expression() {
+    }
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const = 0;
+
+    virtual bool isLeaf() const {
+        return false;
+    }
+
+    // The variables of the result, in the order they'd appear in its truth table. Empty if the result is a constant.
+    const vector<string> &getVariables() const {
+        return variables;
+    }
+
+    // The number of lines in the truth table of the result (1 for a constant). Saturates at the max TruthTableUInt.
+    TruthTableUInt size() const;
+
+    // The bytes that the values of the result take. Saturates at the max uint64_t.
+    uint64_t getResultMemoryUsage() const;
+
+    // The bytes that the values of a block of the result take, with up to these many lines. See evaluateBlock().
+    uint64_t getBlockMemoryUsage(const TruthTableUInt blockSize) const;
+
+    // An upper bound of the bytes held at once while evaluating this expression, including its result. The functions
+    // at the leaves are counted as the copies they're evaluated to. Saturates at the max uint64_t.
+    virtual uint64_t estimatePeakMemoryUsage() const = 0;
+
+    // The truth table lines that this node reads and writes, excluding the ones of the nodes under it. Saturates.
+    virtual TruthTableUInt estimateWork() const = 0;
+
+    // The same, including the nodes under it
+    virtual TruthTableUInt estimateTotalWork() const = 0;
+
+    // The time that it takes to process these many truth table lines, at the throughput measured by logic_bench
+    static chrono::nanoseconds estimateDuration(const TruthTableUInt work);
+
+    // A human readable description of this node alone, like "And" or "$f"
+    virtual string getDescription() const = 0;
+
+    // The value of the result on the line with the given values of its variables. Only the operators that can't be
+    // evaluated on a single line evaluate their whole truth tables. See evaluate(expression, assignment).
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const = 0;
+
+    // Same as estimatePeakMemoryUsage(), for evaluateAt()
+    virtual uint64_t estimatePointPeakMemoryUsage() const = 0;
+
+    // Same as estimateTotalWork(), for evaluateAt()
+    virtual TruthTableUInt estimatePointWork() const = 0;
+
+    // The number of lines of the result that are 1. The operators whose operands share no variables (like "a & !b")
+    // count them from the operands' counts, without evaluating their results. See count(expression, options).
+    virtual TruthTableUInt count(const EvaluationOptions &options) const = 0;
+
+    // Same as estimatePeakMemoryUsage(), for count()
+    virtual uint64_t estimateCountPeakMemoryUsage() const = 0;
+
+    // The lines of the result with the given values of some of its variables (the values may include others), as a
+    // function of the rest of its variables: a block of its truth table. Only the same blocks of the nodes under it are
+    // evaluated, except for the operators that can't be evaluated on a block. See findLine().
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const = 0;
+
+    // Same as estimatePeakMemoryUsage(), for evaluateBlock(), on the blocks of up to these many lines
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const = 0;
+
+protected:
+    Expression(const vector<string> &variables) : variables(variables) {
+    }
+
+private:
+    const vector<string> variables;
+};
+
+class FunctionExpression : public Expression {
+public:
+    FunctionExpression(const BooleanFunction &function);
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePeakMemoryUsage() const override;
+    virtual TruthTableUInt estimateWork() const override;
+    virtual TruthTableUInt estimateTotalWork() const override;
+    virtual string getDescription() const override;
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePointPeakMemoryUsage() const override;
+    virtual TruthTableUInt estimatePointWork() const override;
+    virtual TruthTableUInt count(const EvaluationOptions &options) const override;
+    virtual uint64_t estimateCountPeakMemoryUsage() const override;
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const override;
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const override;
+
+    virtual bool isLeaf() const override {
+        return true;
+    }
+
+    const BooleanFunction &getFunction() const {
+        return function;
+    }
+
+private:
+    const BooleanFunction function;
+};
+
+// A named function that's owned by someone else (like a workspace). The function must outlive the expression.
+class FunctionReferenceExpression : public Expression {
+public:
+    FunctionReferenceExpression(const string &name, const BooleanFunction &function);
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePeakMemoryUsage() const override;
+    virtual TruthTableUInt estimateWork() const override;
+    virtual TruthTableUInt estimateTotalWork() const override;
+    virtual string getDescription() const override;
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePointPeakMemoryUsage() const override;
+    virtual TruthTableUInt estimatePointWork() const override;
+    virtual TruthTableUInt count(const EvaluationOptions &options) const override;
+    virtual uint64_t estimateCountPeakMemoryUsage() const override;
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const override;
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const override;
+
+    virtual bool isLeaf() const override {
+        return true;
+    }
+
+    const string &getName() const {
+        return name;
+    }
+
+    const BooleanFunction &getFunction() const {
+        return function;
+    }
+
+private:
+    const string name;
+    const BooleanFunction &function;
+};
+
+class UnaryOperatorExpression : public Expression {
+public:
+    // Throws if the operator can't be applied on the operand's result, like a condition on a variable it doesn't have.
+    // See UnaryOperator::validate().
+    UnaryOperatorExpression(unique_ptr<UnaryOperator> _operator, unique_ptr<Expression> operand);
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePeakMemoryUsage() const override;
+    virtual TruthTableUInt estimateWork() const override;
+    virtual TruthTableUInt estimateTotalWork() const override;
+    virtual string getDescription() const override;
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePointPeakMemoryUsage() const override;
+    virtual TruthTableUInt estimatePointWork() const override;
+    virtual TruthTableUInt count(const EvaluationOptions &options) const override;
+    virtual uint64_t estimateCountPeakMemoryUsage() const override;
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const override;
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const override;
+
+    const UnaryOperator &getOperator() const {
+        return *_operator;
+    }
+
+    // Whether only a single line of the operand is evaluated, because the result is a constant, like "f[3]"
+    bool isPointEvaluated() const;
+
+    const Expression &getOperand() const {
+        return *operand;
+    }
+
+    // Takes the operator and the operand out, for rewriting the tree. This expression can't be used afterwards.
+    void release(unique_ptr<UnaryOperator> &_operator, unique_ptr<Expression> &operand);
+
+private:
+    unique_ptr<UnaryOperator> _operator;
+    unique_ptr<Expression> operand;
+
+    bool isCountedFromOperand() const;
+};
+
+class BinaryOperatorExpression : public Expression {
+public:
+    BinaryOperatorExpression(unique_ptr<BinaryOperator> _operator, unique_ptr<Expression> first, unique_ptr<Expression> second);
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePeakMemoryUsage() const override;
+    virtual TruthTableUInt estimateWork() const override;
+    virtual TruthTableUInt estimateTotalWork() const override;
+    virtual string getDescription() const override;
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePointPeakMemoryUsage() const override;
+    virtual TruthTableUInt estimatePointWork() const override;
+    virtual TruthTableUInt count(const EvaluationOptions &options) const override;
+    virtual uint64_t estimateCountPeakMemoryUsage() const override;
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const override;
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const override;
+
+    const BinaryOperator &getOperator() const {
+        return *_operator;
+    }
+
+    const Expression &getFirst() const {
+        return *first;
+    }
+
+    const Expression &getSecond() const {
+        return *second;
+    }
+
+    // See UnaryOperatorExpression::release()
+    void release(unique_ptr<BinaryOperator> &_operator, unique_ptr<Expression> &first, unique_ptr<Expression> &second);
+
+private:
+    unique_ptr<BinaryOperator> _operator;
+    unique_ptr<Expression> first;
+    unique_ptr<Expression> second;
+
+    bool isCountedFromOperands() const;
+    bool isEquality() const;
+};
+
+// Several operators applied on the operands at once, without intermediate tables. See FusedOperation.
+class FusedOperatorExpression : public Expression {
+public:
+    FusedOperatorExpression(FusedOperation operation, vector<unique_ptr<Expression>> operands);
+
+    virtual BooleanFunction evaluate(const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePeakMemoryUsage() const override;
+    virtual TruthTableUInt estimateWork() const override;
+    virtual TruthTableUInt estimateTotalWork() const override;
+    virtual string getDescription() const override;
+    virtual bool evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const override;
+    virtual uint64_t estimatePointPeakMemoryUsage() const override;
+    virtual TruthTableUInt estimatePointWork() const override;
+    virtual TruthTableUInt count(const EvaluationOptions &options) const override;
+    virtual uint64_t estimateCountPeakMemoryUsage() const override;
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const override;
+    virtual uint64_t estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const override;
+
+    const FusedOperation &getOperation() const {
+        return operation;
+    }
+
+    const vector<unique_ptr<Expression>> &getOperands() const {
+        return operands;
+    }
+
+private:
+    FusedOperation operation;
+    vector<unique_ptr<Expression>> operands;
+
+    bool isCountedFromOperands() const;
+};
+
+/**
+ * The value of the expression's result on the line with the given values of its variables. Walks the expression
+ * once, evaluating a single line of every node, instead of their whole truth tables, except for the operators that
+ * can't be evaluated on a single line (like "=="). Throws an invalid_argument if a variable has no value.
+ */
+bool evaluate(const Expression &expression, const VariableAssignment &assignment, const EvaluationOptions &options = EvaluationOptions());
+
+/**
+ * The number of lines of the expression's result that are 1 (for a constant, 1 or 0): the number of assignments of its
+ * variables that satisfy it. The tables that have to be evaluated are counted with a popcount of their words, and the
+ * big ones concurrently, if the options have a thread pool. Throws a MemoryLimitExceededException if they wouldn't fit
+ * in the options' memory budget.
+ */
+TruthTableUInt count(const Expression &expression, const EvaluationOptions &options = EvaluationOptions());
+
+/**
+ * Looks for a line of the expression's result with the given value, without evaluating its whole truth table: the
+ * result is evaluated a block of lines at a time, in the order of its lines (and a few blocks at once, if the options
+ * have a thread pool), stopping at the first block that has one. Returns whether there's such a line, and if so, sets
+ * line to the values of the result's variables on the first one. Throws a MemoryLimitExceededException if the blocks
+ * wouldn't fit in the options' memory budget, and a WorkLimitExceededException if the blocks within the options' work
+ * budget have no such line, but there are more.
+ */
+bool findLine(const Expression &expression, const bool value, VariableAssignment &line, const EvaluationOptions &options = EvaluationOptions());
+
+// Whether some assignment of the expression's variables satisfies it, setting witness to the first one. See findLine().
+bool isSatisfiable(const Expression &expression, VariableAssignment &witness, const EvaluationOptions &options = EvaluationOptions());
+
+// Whether every assignment satisfies it, setting counterexample to the first one that doesn't, if not. See findLine().
+bool isTautology(const Expression &expression, VariableAssignment &counterexample, const EvaluationOptions &options = EvaluationOptions());
+
+/**
+ * Whether the results of the expressions are equal, as with the == operator: they have the same variables, and the
+ * same value on every line. Rather than evaluating both whole, they're evaluated a block of lines at a time, as in
+ * findLine(), up to the first block where they differ. If they differ there, and counterexample isn't null, it's set
+ * to the values of the variables on the first line they differ at, and it fails the same way within the options'
+ * budgets. The == operator is evaluated this way too.
+ */
+bool equals(const Expression &first, const Expression &second, VariableAssignment *counterexample = nullptr,
+            const EvaluationOptions &options = EvaluationOptions());
+
+// An upper bound of the bytes held at once by equals()
+uint64_t estimateEqualsPeakMemoryUsage(const Expression &first, const Expression &second);
+}
@@ -0,0 +1,93 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <core/BooleanFunction.hpp>
+#include <core/Operators.hpp>
+
+using namespace std;
+
+namespace Logic {
+class CombinedOperandReader;
+
+/**
+ * A tree of word-wise operators, like "!(a & b) | c", applied on its operands at once. The result is written in a
+ * single pass over its lines, 64 at a time, without allocating the intermediate truth tables. The leaves are the
+ * indices of the operands, which must be numbered in the order they appear in the tree (from left to right), so that
+ * the result's variables are the same as applying the operators one at a time.
+ */
+class FusedOperation {
+public:
+    // A leaf, that reads the operand with this index
+    FusedOperation(const size_t operand);
+
+    FusedOperation(unique_ptr<BoolTransformationUnaryOperator> _operator, FusedOperation operand);
+    FusedOperation(unique_ptr<CombinatoryBinaryOperator> _operator, vector<FusedOperation> operands);
+
+    // Doesn't own the operator, which must outlive the operation
+    FusedOperation(const CombinatoryBinaryOperator &_operator, vector<FusedOperation> operands);
+
+    FusedOperation(FusedOperation &&rhs) = default;
+    FusedOperation &operator=(FusedOperation &&rhs) = default;
+
+    BooleanFunction operator()(const vector<const BooleanFunction *> &operands) const;
+
+    // The value of the result on a single line, where operand returns the value of the operand with the given index on
+    // that line. Only reads the operands that the result depends on.
+    bool evaluateAt(const function<bool (const size_t)> &operand) const;
+
+    // The number of lines of the result that are 1, where operand returns the number of lines that are 1, and of all
+    // the lines of the operand with the given index. The operands must share no variables.
+    TruthTableUInt count(const function<pair<TruthTableUInt, TruthTableUInt> (const size_t)> &operand) const;
+
+    // The variables of the result of applying this on functions with the given variables
+    static vector<string> getResultVariables(const vector<vector<string>> &operands);
+
+    bool isLeaf() const {
+        return unaryOperator == nullptr && binaryOperator == nullptr;
+    }
+
+    // The number of operators in the tree
+    size_t getNumOperators() const;
+
+    // The name of the root operator, followed by the ones of the operators under it, if any, like "Or(Not, _)". The
+    // operands are shown as "_".
+    string getName() const;
+
+    // Same as getName()
+    string getDescription() const {
+        return getName();
+    }
+
+private:
+    unique_ptr<BoolTransformationUnaryOperator> ownedUnaryOperator;
+    unique_ptr<CombinatoryBinaryOperator> ownedBinaryOperator;
+    const BoolTransformationUnaryOperator *unaryOperator;
+    const CombinatoryBinaryOperator *binaryOperator;
+    size_t operand;
+    vector<FusedOperation> operands;
+
+    uint64_t operateWords(vector<CombinedOperandReader> &readers, const TruthTableUInt firstLine, const unsigned numLines) const;
+    uint64_t operateLine(const function<bool (const size_t)> &operand) const;
+    pair<TruthTableUInt, TruthTableUInt> countLines(const function<pair<TruthTableUInt, TruthTableUInt> (const size_t)> &operand) const;
+};
+}
@@ -0,0 +1,87 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
+#include <core/Utils.hpp>
+
+using namespace std;
+
+namespace Logic {
+enum HardwareCounter {
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    NUM_HARDWARE_COUNTERS
+};
+
+struct HardwareCounterValues {
+    uint64_t values[NUM_HARDWARE_COUNTERS] = {};
+    // A counter may be missing even if the others are there, e.g. on a VM without a PMU for the caches
+    bool available[NUM_HARDWARE_COUNTERS] = {};
+
+    bool any() const;
+    HardwareCounterValues operator-(const HardwareCounterValues &rhs) const;
+    // Sums the values, and keeps the counters available in either
+    HardwareCounterValues &operator+=(const HardwareCounterValues &rhs);
+};
+
+/**
+ * The CPU's performance counters for the calling thread, through Linux's perf_event_open. Unavailable on the other
+ * platforms, and when the kernel doesn't allow them (see /proc/sys/kernel/perf_event_paranoid).
+ */
+class HardwareCounters {
+public:
+    // Opened on the thread's first call, and closed when the thread exits
+    static HardwareCounters &forCurrentThread();
+
+    bool isAvailable() const;
+    // Why the counters are unavailable, if they are
+    const string &getError() const {
+        return error;
+    }
+
+    // The counts since the counters were opened, scaled up if the kernel had to multiplex them
+    HardwareCounterValues read() const;
+
+    ~HardwareCounters();
+
+private:
+    int leader;
+    int fds[NUM_HARDWARE_COUNTERS];
+    // The counters in the order that the kernel reports their values
+    int order[NUM_HARDWARE_COUNTERS];
+    int numOpened;
+    string error;
+
+    HardwareCounters();
+
+    HardwareCounters(const HardwareCounters &rhs) : leader(-1), numOpened(0) {
+        UNUSED(rhs);
+        throw runtime_error("Copying HardwareCounters object not allowed.");
+    }
+
+    HardwareCounters &operator=(const HardwareCounters &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying HardwareCounters object not allowed.");
+    }
+};
+}
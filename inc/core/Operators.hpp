@@ -16,15 +16,19 @@
 
 #pragma once
 
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <core/BooleanFunction.hpp>
 #include <core/TruthTable.hpp>
+#include <core/Utils.hpp>
 
 using namespace std;
 
 namespace Logic {
+class FusedOperation;
+
 static const string NOT_OPERATOR("!");
 static const string AND_OPERATOR("&");
 static const string OR_OPERATOR("|");
@@ -39,6 +43,8 @@ static const string EQUALS_REGEX("[=]{2}");
 // check for the INDEX_REGEX first
 static const string INDEX_REGEX("[\\[]{1}[\\s]*([\\d]+)[\\s]*[\\]]{1}");
 static const string CONDITIONS_REGEX("[\\[]{1}[\\s]*(.+?)[\\s]*[\\]]{1}");
+static const string EXISTS_REGEX("exists[\\s]*[\\[]{1}[\\s]*(.+?)[\\s]*[\\]]{1}");
+static const string FORALL_REGEX("forall[\\s]*[\\[]{1}[\\s]*(.+?)[\\s]*[\\]]{1}");
 static const vector<string> OPERATOR_REGEXES({
                                           NOT_REGEX,
                                           AND_REGEX,
@@ -46,11 +52,93 @@ static const vector<string> OPERATOR_REGEXES({
                                           XOR_REGEX,
                                           EQUALS_REGEX,
                                           INDEX_REGEX,
-                                          CONDITIONS_REGEX });
+                                          CONDITIONS_REGEX,
+                                          EXISTS_REGEX,
+                                          FORALL_REGEX });
 
 class UnaryOperator {
 public:
     virtual BooleanFunction operator()(const BooleanFunction &in) const = 0;
+
+    // The variables of the result of applying this operator on a function with the given variables, in the order that
+    // they'd appear in the result's truth table. An empty list stands for a constant value function.
+    virtual vector<string> getResultVariables(const vector<string> &variables) const {
+        return variables;
+    }
+
+    // A human readable name of the operator type, for diagnostics
+    virtual string getName() const {
+        return "UnaryOperator";
+    }
+
+    // The name, along with the parameters of this operator, if any
+    virtual string getDescription() const {
+        return getName();
+    }
+
+    // The number of truth table lines this operator allocates for its own bookkeeping (excluding the result), when
+    // applied on a function with the given variables. Used for estimating the memory of an evaluation.
+    virtual TruthTableUInt estimateScratchSize(const vector<string> &variables) const {
+        UNUSED(variables);
+        return 0;
+    }
+
+    // Throws the exception that applying this operator on any function with the given variables would, if any. Checked
+    // when an expression is built, so that it fails the same way on every evaluation path, even the ones that don't
+    // evaluate the operand.
+    virtual void validate(const vector<string> &variables) const {
+        UNUSED(variables);
+    }
+
+    // Whether evaluateAt() is supported
+    virtual bool canEvaluateAt() const {
+        return false;
+    }
+
+    // The value of the result on the line with the given values of its variables, without the operand's whole truth
+    // table. operand returns the operand's value on the line with the given values of the operand's variables.
+    virtual bool evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const {
+        UNUSED(assignment);
+        UNUSED(operandVariables);
+        UNUSED(operand);
+        throw logic_error(getName() + " cannot be evaluated on a single line");
+    }
+
+    // The most lines of the operand that evaluateAt() reads, when applied on a function with the given variables
+    virtual TruthTableUInt estimatePointReads(const vector<string> &variables) const {
+        UNUSED(variables);
+        return 1;
+    }
+
+    // Whether evaluateBlock() is supported
+    virtual bool canEvaluateBlock() const {
+        return false;
+    }
+
+    // The lines of the result with the given values of some of its variables, as a function of the others, without the
+    // operand's whole truth table. operand returns the same for the operand. The values may include other variables.
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const {
+        UNUSED(values);
+        UNUSED(operandVariables);
+        UNUSED(operand);
+        throw logic_error(getName() + " cannot be evaluated on a block of lines");
+    }
+
+    // Whether count() is supported
+    virtual bool canCount() const {
+        return false;
+    }
+
+    // The number of lines of the result that are 1, without the operand's truth table, from the number of the
+    // operand's lines that are 1, and of all its lines
+    virtual TruthTableUInt count(const TruthTableUInt operandCount, const TruthTableUInt operandSize) const {
+        UNUSED(operandCount);
+        UNUSED(operandSize);
+        throw logic_error(getName() + " cannot be counted without the truth table");
+    }
+
     virtual ~UnaryOperator() {
     }
 };
@@ -58,6 +146,77 @@ public:
 class BinaryOperator {
 public:
     virtual BooleanFunction operator()(const BooleanFunction &first, const BooleanFunction &second) const = 0;
+
+    // See UnaryOperator::getResultVariables()
+    virtual vector<string> getResultVariables(const vector<string> &first, const vector<string> &second) const = 0;
+
+    // See UnaryOperator::getName()
+    virtual string getName() const {
+        return "BinaryOperator";
+    }
+
+    // See UnaryOperator::getDescription()
+    virtual string getDescription() const {
+        return getName();
+    }
+
+    // See UnaryOperator::estimateScratchSize()
+    virtual TruthTableUInt estimateScratchSize(const vector<string> &first, const vector<string> &second) const {
+        UNUSED(first);
+        UNUSED(second);
+        return 0;
+    }
+
+    // If true, the operands of a chain of this operator can be evaluated in any order and grouping
+    virtual bool isAssociativeAndCommutative() const {
+        return false;
+    }
+
+    // See UnaryOperator::canEvaluateAt()
+    virtual bool canEvaluateAt() const {
+        return false;
+    }
+
+    // See UnaryOperator::evaluateAt(). The assignment has the values of both the operands' variables.
+    virtual bool evaluateAt(const VariableAssignment &assignment, const function<bool (const VariableAssignment &)> &first,
+                            const function<bool (const VariableAssignment &)> &second) const {
+        UNUSED(assignment);
+        UNUSED(first);
+        UNUSED(second);
+        throw logic_error(getName() + " cannot be evaluated on a single line");
+    }
+
+    // See UnaryOperator::canEvaluateBlock()
+    virtual bool canEvaluateBlock() const {
+        return false;
+    }
+
+    // See UnaryOperator::evaluateBlock()
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values,
+                                          const function<BooleanFunction (const VariableAssignment &)> &first,
+                                          const function<BooleanFunction (const VariableAssignment &)> &second) const {
+        UNUSED(values);
+        UNUSED(first);
+        UNUSED(second);
+        throw logic_error(getName() + " cannot be evaluated on a block of lines");
+    }
+
+    // See UnaryOperator::canCount()
+    virtual bool canCount() const {
+        return false;
+    }
+
+    // See UnaryOperator::count(). Only for the operands that share no variables, so that every line of the result is
+    // a pair of lines of the operands.
+    virtual TruthTableUInt count(const TruthTableUInt firstCount, const TruthTableUInt firstSize,
+                                 const TruthTableUInt secondCount, const TruthTableUInt secondSize) const {
+        UNUSED(firstCount);
+        UNUSED(firstSize);
+        UNUSED(secondCount);
+        UNUSED(secondSize);
+        throw logic_error(getName() + " cannot be counted without the truth table");
+    }
+
     virtual ~BinaryOperator() {
     }
 };
@@ -66,15 +225,59 @@ class BoolTransformationUnaryOperator : public UnaryOperator {
 public:
     virtual BooleanFunction operator()(const BooleanFunction &in) const;
 
+    virtual bool canEvaluateAt() const {
+        return true;
+    }
+
+    virtual bool evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const {
+        UNUSED(operandVariables);
+        return operate(operand(assignment));
+    }
+
+    virtual bool canEvaluateBlock() const {
+        return true;
+    }
+
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const {
+        UNUSED(operandVariables);
+        return (*this)(operand(values));
+    }
+
+    virtual bool canCount() const {
+        return true;
+    }
+
+    virtual TruthTableUInt count(const TruthTableUInt operandCount, const TruthTableUInt operandSize) const {
+        return (operate(true) ? operandCount : 0) + (operate(false) ? operandSize - operandCount : 0);
+    }
+
 private:
     virtual bool operate(const bool in) const = 0;
+
+    // Transforms the lowest numLines values packed in the word. Only the lowest numLines bits of the result are used.
+    // Applies operate() to every value, unless overridden.
+    virtual uint64_t operateWord(const uint64_t in, const unsigned numLines) const;
+
+    friend class FusedOperation;
 };
 
 class Not : public BoolTransformationUnaryOperator {
+public:
+    virtual string getName() const {
+        return "Not";
+    }
+
 private:
     virtual bool operate(const bool in) const {
         return !in;
     }
+
+    virtual uint64_t operateWord(const uint64_t in, const unsigned numLines) const {
+        UNUSED(numLines);
+        return ~in;
+    }
 };
 
 class Equals : public BinaryOperator {
@@ -82,37 +285,135 @@ public:
     virtual BooleanFunction operator()(const BooleanFunction &first, const BooleanFunction &second) const {
         return first == second;
     }
+
+    virtual vector<string> getResultVariables(const vector<string> &first, const vector<string> &second) const {
+        UNUSED(first);
+        UNUSED(second);
+        return {};
+    }
+
+    virtual string getName() const {
+        return "Equals";
+    }
 };
 
 class CombinatoryBinaryOperator : public BinaryOperator {
 public:
     virtual BooleanFunction operator()(const BooleanFunction &first, const BooleanFunction &second) const;
+    virtual vector<string> getResultVariables(const vector<string> &first, const vector<string> &second) const;
+
+    virtual bool isAssociativeAndCommutative() const {
+        return true;
+    }
+
+    virtual bool canEvaluateAt() const {
+        return true;
+    }
+
+    virtual bool evaluateAt(const VariableAssignment &assignment, const function<bool (const VariableAssignment &)> &first,
+                            const function<bool (const VariableAssignment &)> &second) const;
+
+    virtual bool canEvaluateBlock() const {
+        return true;
+    }
+
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values,
+                                          const function<BooleanFunction (const VariableAssignment &)> &first,
+                                          const function<BooleanFunction (const VariableAssignment &)> &second) const {
+        return (*this)(first(values), second(values));
+    }
+
+    virtual bool canCount() const {
+        return true;
+    }
+
+    virtual TruthTableUInt count(const TruthTableUInt firstCount, const TruthTableUInt firstSize,
+                                 const TruthTableUInt secondCount, const TruthTableUInt secondSize) const;
+
+    /**
+     * Same as applying this operator on the operands from left to right (or in any order and grouping, for an
+     * associative and commutative operator), but in a single pass over the result's lines, without any intermediate
+     * tables. The result's variables are the ones of the operands, in the order they're first seen.
+     */
+    BooleanFunction operator()(const vector<const BooleanFunction *> &operands) const;
+
+    // See operator()(const vector<const BooleanFunction *> &)
+    vector<string> getResultVariables(const vector<vector<string>> &operands) const;
 
 private:
-    TruthTable combineColumnsWithSameVariables(const TruthTableBuilder &rawBuilder) const;
-    TruthTableBuilder combineTables(const BooleanFunction &first, const BooleanFunction &second) const;
     virtual bool operate(const bool first, const bool second) const = 0;
+
+    // Combines the lowest numLines values packed in the words. Only the lowest numLines bits of the result are used.
+    // Applies operate() to every pair of values, unless overridden.
+    virtual uint64_t operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const;
+
+    // Whether applying this operator on the word and any other word always results in the same word, like an And
+    // on all 0s. Lets a chain stop early.
+    virtual bool isAbsorbing(const uint64_t word) const {
+        UNUSED(word);
+        return false;
+    }
+
+    friend class FusedOperation;
 };
 
 class Or : public CombinatoryBinaryOperator {
+public:
+    virtual string getName() const {
+        return "Or";
+    }
+
 private:
     virtual bool operate(const bool first, const bool second) const {
         return first || second;
     }
+
+    virtual uint64_t operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const {
+        UNUSED(numLines);
+        return first | second;
+    }
+
+    virtual bool isAbsorbing(const uint64_t word) const {
+        return word == ~(uint64_t) 0;
+    }
 };
 
 class And : public CombinatoryBinaryOperator {
+public:
+    virtual string getName() const {
+        return "And";
+    }
+
 private:
     virtual bool operate(const bool first, const bool second) const {
         return first && second;
     }
+
+    virtual uint64_t operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const {
+        UNUSED(numLines);
+        return first & second;
+    }
+
+    virtual bool isAbsorbing(const uint64_t word) const {
+        return word == 0;
+    }
 };
 
 class Xor : public CombinatoryBinaryOperator {
+public:
+    virtual string getName() const {
+        return "Xor";
+    }
+
 private:
     virtual bool operate(const bool first, const bool second) const {
         return first != second;
     }
+
+    virtual uint64_t operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const {
+        UNUSED(numLines);
+        return first ^ second;
+    }
 };
 
 class Index : public UnaryOperator {
@@ -121,6 +422,30 @@ public:
     }
 
     virtual BooleanFunction operator()(const BooleanFunction &in) const;
+
+    virtual vector<string> getResultVariables(const vector<string> &variables) const {
+        UNUSED(variables);
+        return {};
+    }
+
+    virtual string getName() const {
+        return "Index";
+    }
+
+    virtual string getDescription() const {
+        return getName() + "[" + to_string(index) + "]";
+    }
+
+    virtual void validate(const vector<string> &variables) const;
+
+    virtual bool canEvaluateAt() const {
+        return true;
+    }
+
+    // Reads the index-th line of the operand, regardless of the assignment, since the result is a constant
+    virtual bool evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const;
+
 private:
     const TruthTableUInt index;
 };
@@ -131,11 +456,118 @@ public:
     }
 
     virtual BooleanFunction operator()(const BooleanFunction &in) const;
+    virtual vector<string> getResultVariables(const vector<string> &variables) const;
+    virtual TruthTableUInt estimateScratchSize(const vector<string> &variables) const;
+
+    virtual string getName() const {
+        return "Conditions";
+    }
+
+    virtual string getDescription() const;
+    virtual void validate(const vector<string> &variables) const;
+
+    virtual bool canEvaluateAt() const {
+        return true;
+    }
+
+    virtual bool evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const;
+
+    virtual bool canEvaluateBlock() const {
+        return true;
+    }
+
+    // Adds the conditions to the values, so only the operand's lines that meet them are evaluated
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const;
+
+    const vector<pair<string, bool>> &getConditions() const {
+        return conditions;
+    }
 
 private:
     const vector<pair<string, bool>> conditions;
 };
 
+// Quantifies the variables out of the operand, by combining its cofactors on them. The variables that the operand
+// doesn't have are left out, since it doesn't depend on them.
+class Quantifier : public UnaryOperator {
+public:
+    Quantifier(const vector<string> &variables) : variables(variables) {
+    }
+
+    // Combines the cofactors a word at a time, in a single pass over the operand's table
+    virtual BooleanFunction operator()(const BooleanFunction &in) const;
+    virtual vector<string> getResultVariables(const vector<string> &variables) const;
+    virtual string getDescription() const;
+
+    virtual bool canEvaluateAt() const {
+        return true;
+    }
+
+    // Evaluates the operand on the line with every value of the quantified variables, until one decides the result
+    virtual bool evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const;
+    virtual TruthTableUInt estimatePointReads(const vector<string> &variables) const;
+
+    virtual bool canEvaluateBlock() const {
+        return true;
+    }
+
+    // Same as evaluateAt(), a block at a time
+    virtual BooleanFunction evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const;
+
+    const vector<string> &getQuantifiedVariables() const {
+        return variables;
+    }
+
+private:
+    // The value of a cofactor that decides the result on its own: 1 for exists, and 0 for forall. The cofactors are
+    // combined with an Or, or an And, respectively.
+    virtual bool getDecidingValue() const = 0;
+
+    // Combines the values of two cofactors, packed in words
+    uint64_t combineWords(const uint64_t first, const uint64_t second) const {
+        return getDecidingValue() ? first | second : first & second;
+    }
+
+    // The operand's variables that are quantified, in the operand's order
+    vector<string> getQuantifiedOperandVariables(const vector<string> &operandVariables) const;
+
+    const vector<string> variables;
+};
+
+class Exists : public Quantifier {
+public:
+    Exists(const vector<string> &variables) : Quantifier(variables) {
+    }
+
+    virtual string getName() const {
+        return "Exists";
+    }
+
+private:
+    virtual bool getDecidingValue() const {
+        return true;
+    }
+};
+
+class Forall : public Quantifier {
+public:
+    Forall(const vector<string> &variables) : Quantifier(variables) {
+    }
+
+    virtual string getName() const {
+        return "Forall";
+    }
+
+private:
+    virtual bool getDecidingValue() const {
+        return false;
+    }
+};
+
 bool isKnownPrefixUnaryOperator(const string &_operator);
 bool isKnownSuffixUnaryOperator(const string &_operator);
 bool isKnownUnaryOperator(const string &_operator);
@@ -0,0 +1,54 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <memory>
+#include <core/Expression.hpp>
+
+using namespace std;
+
+namespace Logic {
+/**
+ * Rewrites the chains of an associative and commutative operator, like "a & b & c & d", so that the operands sharing
+ * the most variables are combined first, and the intermediate truth tables stay small. A chain is made of the
+ * operands joined by the same operator, as grouped by the parser, so the precedence between the different operators
+ * is kept. A chain is only rewritten if that's estimated to be cheaper, and keeps the order of the result's variables,
+ * so the result is the same function, with its variables in the same order. Runs before fuseOperators(), which then
+ * fuses the regrouped chains, keeping their operands in the regrouped order.
+ */
+unique_ptr<Expression> reorderChains(unique_ptr<Expression> expression);
+
+/**
+ * Rewrites the neighbouring operators that work a word at a time (Not, And, Or and Xor), like "!(a & b) | c", into
+ * single fused operations, which write their result in one pass, without allocating the intermediate truth tables.
+ * The chains of the same associative operator, like "a & b & c & d", become a single n-ary operator, whose lines stop
+ * reading their operands as soon as the result is known. Only the operators are fused, so the grouping of the
+ * operands, and hence the precedence between the different operators, is kept. The result is the same function,
+ * with its variables in the same order.
+ */
+unique_ptr<Expression> fuseOperators(unique_ptr<Expression> expression);
+
+/**
+ * Rewrites the conditions applied on expressions, like "(f & g | h)[a = 1, b = 0]", into conditions applied on the
+ * functions at the leaves, like "f[a = 1] & g[b = 0] | h[a = 1]". Conditioning a function halves its truth table
+ * for every variable, so the operators then work on the smaller tables, instead of on the whole ones that are
+ * conditioned afterwards. The conditions are pushed through the operators that work a line at a time (Not, And, Or
+ * and Xor), and stop at the others. The conditions that would fail (like on a variable that the expression doesn't
+ * have) are left as they are, so that they fail the same way.
+ */
+unique_ptr<Expression> pushDownConditions(unique_ptr<Expression> expression);
+}
@@ -0,0 +1,156 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <core/Utils.hpp>
+#include <core/HardwareCounters.hpp>
+
+using namespace std;
+
+namespace Logic {
+// Latencies in logarithmic buckets, a quarter of an octave wide each, so that the percentiles of any number of samples
+// can be estimated from a fixed amount of memory, within ~19% of the real values
+class LatencyHistogram {
+public:
+    void add(const uint64_t nanoseconds);
+    // Adds the other's samples
+    void add(const LatencyHistogram &other);
+
+    uint64_t getCount() const {
+        return count;
+    }
+
+    uint64_t getTotal() const {
+        return total;
+    }
+
+    uint64_t getMax() const {
+        return max;
+    }
+
+    // The upper bound of the bucket holding the percentile, clamped to the max. 0 if there are no samples.
+    uint64_t getPercentile(const double percentile) const;
+
+private:
+    vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+};
+
+struct ProfileEntry {
+    LatencyHistogram latencies;
+    // The truth table rows of the operands and the results
+    uint64_t rows = 0;
+    // The size of the results' truth tables, at a bit per row. Not what was allocated, which also includes the scratch
+    // space of the operators, and the allocator's overhead.
+    uint64_t resultBytes = 0;
+    // The totals of the hardware counters, if they were used
+    HardwareCounterValues counters;
+};
+
+// The rows and result sizes of the operators evaluated for a statement
+struct ProfileCounters {
+    atomic<uint64_t> rows{0};
+    atomic<uint64_t> resultBytes{0};
+};
+
+class Profiler;
+
+// Measures the time, and the hardware counters if the profiler uses them, on the calling thread from its construction
+class ProfileMeasurement {
+public:
+    ProfileMeasurement(const Profiler &profiler);
+
+    chrono::steady_clock::duration getElapsed() const;
+    HardwareCounterValues getCounters() const;
+
+private:
+    const chrono::steady_clock::time_point start;
+    HardwareCounters *hardwareCounters;
+    HardwareCounterValues startCounters;
+};
+
+/**
+ * Collects the invocation counts, latencies, rows and result sizes of the executed commands and evaluated operators, and
+ * optionally, the CPU's hardware counters while they ran. All the methods are thread safe.
+ */
+class Profiler {
+public:
+    Profiler(const bool useHardwareCounters = false) : useHardwareCounters(useHardwareCounters) {
+    }
+
+    // Whether the measurements should read the hardware counters. Even then, the counters may be unavailable.
+    bool usesHardwareCounters() const {
+        return useHardwareCounters;
+    }
+
+    void recordCommand(const string &command, const ProfileMeasurement &measurement, const ProfileCounters &counters);
+    // Also adds the rows and the result's size to the current thread's counters, if any
+    void recordOperator(const string &_operator, const ProfileMeasurement &measurement, const uint64_t rows, const uint64_t resultBytes);
+
+    // Adds everything the other profiler recorded to this one
+    void add(const Profiler &other);
+
+    map<string, ProfileEntry> getCommands() const;
+    map<string, ProfileEntry> getOperators() const;
+    void reset();
+
+    // The counters of the statement being executed on this thread. Null if none.
+    static ProfileCounters *getCurrentCounters();
+
+private:
+    const bool useHardwareCounters;
+    mutable mutex lock;
+    map<string, ProfileEntry> commands;
+    map<string, ProfileEntry> operators;
+};
+
+// Sets the current thread's counters for its lifetime, and restores the previous ones after
+class ScopedProfileCounters {
+public:
+    ScopedProfileCounters(ProfileCounters *counters);
+    ~ScopedProfileCounters();
+
+private:
+    ProfileCounters *previous;
+
+    ScopedProfileCounters(const ScopedProfileCounters &rhs) : previous(nullptr) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ScopedProfileCounters object not allowed.");
+    }
+
+    ScopedProfileCounters &operator=(const ScopedProfileCounters &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ScopedProfileCounters object not allowed.");
+    }
+};
+
+// A table of the commands and the operators, with their counts, total and percentile latencies, rows and result sizes. With the
+// hardware counters, also the instructions per cycle, and the cache and branch misses per row.
+ostream &operator<<(ostream &os, const Profiler &profiler);
+}
@@ -0,0 +1,150 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <core/Exceptions.hpp>
+#include <core/Utils.hpp>
+
+using namespace std;
+
+namespace Logic {
+/**
+ * A fixed size pool of worker threads executing tasks in FIFO order.
+ * Since the tasks are started in the order they were submitted, a task may safely block on the result of a task
+ * submitted before it.
+ */
+class ThreadPool {
+public:
+    ThreadPool(const size_t numThreads);
+    ~ThreadPool();
+
+    template <typename TFunction>
+    future<typename result_of<TFunction()>::type> submit(TFunction task) {
+        typedef typename result_of<TFunction()>::type TResult;
+        shared_ptr<packaged_task<TResult()>> packagedTask = make_shared<packaged_task<TResult()>>(task);
+        future<TResult> result = packagedTask->get_future();
+        {
+            unique_lock<mutex> lock(tasksMutex);
+            if (stopping) {
+                throw IllegalStateException("Cannot submit a task to a ThreadPool that is shutting down.");
+            }
+            tasks.push([packagedTask]() { (*packagedTask)(); });
+        }
+        tasksAvailable.notify_one();
+        return result;
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+private:
+    vector<thread> workers;
+    queue<function<void ()>> tasks;
+    mutex tasksMutex;
+    condition_variable tasksAvailable;
+    bool stopping;
+
+    ThreadPool(const ThreadPool &rhs) : stopping(false) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ThreadPool object not allowed.");
+    }
+
+    ThreadPool &operator=(const ThreadPool &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ThreadPool object not allowed.");
+    }
+
+    void work();
+};
+
+/**
+ * A task that is run either by a worker of the pool, or by the thread joining it; whichever gets to it first.
+ * Joining never waits on a task that hasn't started, so tasks can be forked and joined from within the tasks running
+ * on the same pool without deadlocking it.
+ */
+template <typename TResult>
+class ForkedTask {
+public:
+    ForkedTask(ThreadPool &pool, function<TResult ()> task) : state(make_shared<State>(task)), result(state->task.get_future()), joined(false) {
+        shared_ptr<State> state = this->state;
+        pool.submit([state]() {
+            if (state->claim()) {
+                state->task();
+            }
+        });
+    }
+
+    ~ForkedTask() {
+        if (!joined && !state->claim()) {
+            // Already running on a worker, and it may be referencing the caller's stack
+            result.wait();
+        }
+    }
+
+    // Returns the result of the task (or rethrows its error). Can only be called once.
+    TResult join() {
+        if (joined) {
+            throw IllegalStateException("A ForkedTask can only be joined once.");
+        }
+        joined = true;
+
+        if (state->claim()) {
+            state->task();
+        }
+        return result.get();
+    }
+
+private:
+    struct State {
+        State(function<TResult ()> task) : task(task), claimed(false) {
+        }
+
+        // Returns true if the caller is the first one to claim the task, and hence must run it
+        bool claim() {
+            return !claimed.exchange(true);
+        }
+
+        packaged_task<TResult ()> task;
+        atomic<bool> claimed;
+    };
+
+    shared_ptr<State> state;
+    future<TResult> result;
+    bool joined;
+
+    ForkedTask(const ForkedTask &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ForkedTask object not allowed.");
+    }
+
+    ForkedTask &operator=(const ForkedTask &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying ForkedTask object not allowed.");
+    }
+};
+}
@@ -0,0 +1,115 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <core/Utils.hpp>
+
+using namespace std;
+
+namespace Logic {
+struct TraceArgument {
+    string key;
+    string value;
+    // Else, a string
+    bool isNumber;
+};
+
+// A complete span, with its times relative to the start of the trace
+struct TraceEvent {
+    string name;
+    string category;
+    chrono::nanoseconds start;
+    chrono::nanoseconds duration;
+    vector<TraceArgument> arguments;
+};
+
+struct TraceThread {
+    // Small sequential ids, in the order that the threads recorded their first events
+    uint32_t id;
+    vector<TraceEvent> events;
+};
+
+/**
+ * Collects the spans recorded by any number of threads. Every thread records into its own buffer, so the threads
+ * don't contend with each other.
+ */
+class Tracer {
+public:
+    Tracer();
+
+    void record(TraceEvent &&event);
+    chrono::nanoseconds now() const;
+
+    // A copy of the events of every thread recorded so far
+    vector<TraceThread> getThreads() const;
+
+private:
+    struct Buffer {
+        mutex lock;
+        TraceThread thread;
+    };
+
+    // Identifies this tracer in the threads' cached buffers, which may outlive it
+    const uint64_t id;
+    const chrono::steady_clock::time_point origin;
+    mutable mutex lock;
+    vector<unique_ptr<Buffer>> buffers;
+
+    Buffer &getBuffer();
+
+    Tracer(const Tracer &rhs) : id(rhs.id), origin(rhs.origin) {
+        throw runtime_error("Copying Tracer object not allowed.");
+    }
+
+    Tracer &operator=(const Tracer &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying Tracer object not allowed.");
+    }
+};
+
+// Records a span from its construction to its destruction. Does nothing if the tracer is null.
+class TraceSpan {
+public:
+    TraceSpan(Tracer *tracer, const string &name, const string &category);
+    ~TraceSpan();
+
+    void addArgument(const string &key, const uint64_t value);
+    void addArgument(const string &key, const string &value);
+
+private:
+    Tracer *tracer;
+    TraceEvent event;
+
+    TraceSpan(const TraceSpan &rhs) : tracer(nullptr) {
+        UNUSED(rhs);
+        throw runtime_error("Copying TraceSpan object not allowed.");
+    }
+
+    TraceSpan &operator=(const TraceSpan &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying TraceSpan object not allowed.");
+    }
+};
+}
@@ -28,6 +28,10 @@ namespace Logic {
 class __TruthTableValueProxy;
 class TruthTableCondition;
 
+// The bits of the lines of a word where the variable of the column is 0, for the first 6 columns
+static const uint64_t NEGATIVE_COFACTOR_MASKS[6] = { 0x5555555555555555ull, 0x3333333333333333ull, 0x0F0F0F0F0F0F0F0Full,
+                                                     0x00FF00FF00FF00FFull, 0x0000FFFF0000FFFFull, 0x00000000FFFFFFFFull };
+
 class TruthTable {
 public:
     TruthTable(const vector<string> &variables);
@@ -45,13 +49,49 @@ public:
 
     TruthTableCondition conditionBuilder() const;
 
+    // The number of lines that are 1
+    TruthTableUInt count() const;
+
+    // Whether some two lines that only differ in the variable of the column have different values. If not, the
+    // variable is vacuous: the table's values don't depend on it.
+    bool dependsOn(const TruthTableVariablesUInt column) const;
+
+    // The variables that the values depend on, in the table's order
+    vector<string> getSupport() const;
+
+    // The lines where the variable of the column has the value, as a table of the other variables, in the same order.
+    // Built a word at a time. The table must have other variables.
+    TruthTable getCofactor(const TruthTableVariablesUInt column, const bool value) const;
+
     vector<TruthTableUInt> getMinterms() const;
     vector<TruthTableUInt> getMaxterms() const;
 
+    // An equal truth table, with the variables in the given order. The variables must be a permutation of this one's.
+    TruthTable reorder(const vector<string> &variables) const;
+
+    // The bytes held by the values and the variable names
+    uint64_t getMemoryUsage() const;
+    // The bytes that the values of a truth table with these many lines take
+    static uint64_t getValuesMemoryUsage(const TruthTableUInt size);
+
+    // The values are packed in 64 bit words, line i being the bit (i % 64) of the word (i / 64). If the table has
+    // fewer than 64 lines, the unused high bits of the only word must be left 0.
+    const uint64_t *getWords() const {
+        return values.data();
+    }
+
+    uint64_t *getWords() {
+        return values.data();
+    }
+
+    TruthTableUInt getNumWords() const {
+        return values.size();
+    }
+
     static bool getVariableValueInLine(TruthTableVariablesUInt columnNumber, TruthTableUInt lineIndex);
 private:
     vector<string> variables;
-    vector<bool> values;
+    vector<uint64_t> values;
 
     void validateIndex(const TruthTableUInt index) const;
 
@@ -69,11 +109,16 @@ public:
     }
 
     operator bool() const {
-        return table.values[index];
+        return ((table.values[index / 64] >> (index % 64)) & 1) == 1;
     }
 
     void operator=(const bool value) {
-        table.values[index] = value;
+        const uint64_t bit = ((uint64_t) 1) << (index % 64);
+        if (value) {
+            table.values[index / 64] |= bit;
+        } else {
+            table.values[index / 64] &= ~bit;
+        }
     }
 
 private:
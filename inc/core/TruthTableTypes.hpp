@@ -28,6 +28,9 @@ using namespace std;
 namespace Logic {
 typedef uint64_t TruthTableUInt;
 
+// The values of some variables, like the ones of a line of a truth table
+typedef unordered_map<string, bool> VariableAssignment;
+
 class TruthTableVariablesUInt {
 public:
     TruthTableVariablesUInt(const uint8_t value) : value(value) {
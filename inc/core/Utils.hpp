@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <stdint.h>
 
 using namespace std;
 // For explicitly removing -Wunused-parameter
@@ -30,6 +31,20 @@ namespace Logic {
     string trim(const string &str);
     vector<string> split(string str, const char delim);
     vector<string> split(string str, const string &delim);
+    // Saturates at the max uint64_t instead of overflowing
+    inline uint64_t saturatingAdd(const uint64_t first, const uint64_t second) {
+        return first > UINT64_MAX - second ? UINT64_MAX : first + second;
+    }
+    inline uint64_t saturatingMultiply(const uint64_t first, const uint64_t second) {
+        return second != 0 && first > UINT64_MAX / second ? UINT64_MAX : first * second;
+    }
+
+    // e.g. "1.50 MiB"
+    string formatBytes(const uint64_t bytes);
+    // e.g. "1.50 ms"
+    string formatDuration(const uint64_t nanoseconds);
+    // The installed memory of the machine, or the max uint64_t if it isn't known
+    uint64_t getPhysicalMemory();
 
     template <typename T>
     string join(const vector<T> &vec, const string &delimiter) {
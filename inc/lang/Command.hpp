@@ -20,6 +20,7 @@
 #include <lang/Runtime.hpp>
 #include <iostream>
 #include <functional>
+#include <vector>
 
 using namespace std;
 
@@ -29,24 +30,70 @@ public:
     virtual bool execute(const string &, Runtime &, ostream &, function<bool (istream &)>);           \
 }
 
+// A command that only reads the functions its args reference, and writes nothing but its output. See
+// Command::isIsolated().
+#define DECLARE_READ_ONLY_COMMAND_CLASS(COMMAND_NAME)                                             \
+class COMMAND_NAME##Command : public Command {                                                    \
+public:                                                                                           \
+    virtual bool execute(const string &, Runtime &, ostream &, function<bool (istream &)>);           \
+    virtual bool isIsolated(const string &) const {                                               \
+        return true;                                                                              \
+    }                                                                                             \
+}
+
 namespace Logic {
 class Command {
 public:
     virtual bool execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter);
+
+    // Whether executing the command with the args reads nothing from the runtime but the functions the args
+    // reference, and writes nothing to it but the function it defines, if any (besides clearing the flags, like every
+    // command does). Such statements are executed concurrently with their neighbours, against a private runtime.
+    virtual bool isIsolated(const string &args) const {
+        UNUSED(args);
+        return false;
+    }
+
+    // The function that executing the command with the args defines in the runtime. Empty if none.
+    virtual string getDefinedFunction(const string &args) const {
+        UNUSED(args);
+        return "";
+    }
+
+    // The functions of the runtime that the args reference, as $name
+    virtual vector<string> getReferencedFunctions(const string &args) const;
+
     virtual ~Command() {
     }
 };
 
+class LetCommand : public Command {
+public:
+    virtual bool execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter);
+
+    // A let of a whole function is isolated, unlike a let of a line of one
+    virtual bool isIsolated(const string &args) const;
+    virtual string getDefinedFunction(const string &args) const;
+};
+
 DECLARE_COMMAND_CLASS(Quit);
-DECLARE_COMMAND_CLASS(Let);
-DECLARE_COMMAND_CLASS(PrintBooleanFunction);
+DECLARE_READ_ONLY_COMMAND_CLASS(PrintBooleanFunction);
 DECLARE_COMMAND_CLASS(DeleteBooleanFunction);
-DECLARE_COMMAND_CLASS(PrintMinterms);
-DECLARE_COMMAND_CLASS(PrintMaxterms);
-DECLARE_COMMAND_CLASS(PrintVariables);
+DECLARE_READ_ONLY_COMMAND_CLASS(PrintMinterms);
+DECLARE_READ_ONLY_COMMAND_CLASS(PrintMaxterms);
+DECLARE_READ_ONLY_COMMAND_CLASS(PrintVariables);
 DECLARE_COMMAND_CLASS(If);
 DECLARE_COMMAND_CLASS(Else);
 DECLARE_COMMAND_CLASS(While);
+DECLARE_COMMAND_CLASS(Stats);
+DECLARE_COMMAND_CLASS(Mem);
+DECLARE_COMMAND_CLASS(Explain);
+DECLARE_COMMAND_CLASS(Bitmap);
+DECLARE_READ_ONLY_COMMAND_CLASS(Emit);
+DECLARE_READ_ONLY_COMMAND_CLASS(Count);
+DECLARE_READ_ONLY_COMMAND_CLASS(Sat);
+DECLARE_READ_ONLY_COMMAND_CLASS(Taut);
+DECLARE_READ_ONLY_COMMAND_CLASS(Support);
 // When adding new commands, update createDispatchTableWithAllCommands() in DispatchTable.hpp
 // to ensure that the command is available at runtime.
 }
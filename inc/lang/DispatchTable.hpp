@@ -19,7 +19,6 @@
 #include <lang/Command.hpp>
 #include <vector>
 #include <string>
-#include <functional>
 #include <unordered_map>
 #include <memory>
 
@@ -28,15 +27,20 @@ using namespace std;
 namespace Logic {
 class DispatchTable {
 public:
-    void registerCommand(const vector<string> &symbols, function<unique_ptr<Command> ()> commandFactory);
-    unique_ptr<Command> getCommand(const string &token);
+    // Commands are stateless, so a single instance is shared by all the symbols (aliases) it is registered with,
+    // and by all the statements that dispatch to it.
+    void registerCommand(const vector<string> &symbols, shared_ptr<Command> command);
+    Command &getCommand(const string &token);
+    // The first symbol that the token's command was registered with, e.g. "print" for "p"
+    const string &getCommandName(const string &token) const;
 
 private:
-    unordered_map<string, function<unique_ptr<Command> ()>> table;
+    unordered_map<string, shared_ptr<Command>> table;
+    unordered_map<string, string> names;
 };
 
 #define REGISTER_COMMAND(COMMAND, ...) \
-    dispatchTable.registerCommand({ __VA_ARGS__ }, []() { return unique_ptr<Command>(new COMMAND##Command()); });
+    dispatchTable.registerCommand({ __VA_ARGS__ }, make_shared<COMMAND##Command>());
 
 inline DispatchTable createDispatchTableWithAllCommands() {
     DispatchTable dispatchTable;
@@ -51,6 +55,15 @@ inline DispatchTable createDispatchTableWithAllCommands() {
     REGISTER_COMMAND(If, "if");
     REGISTER_COMMAND(Else, "else");
     REGISTER_COMMAND(While, "while");
+    REGISTER_COMMAND(Stats, "stats");
+    REGISTER_COMMAND(Mem, "mem");
+    REGISTER_COMMAND(Explain, "explain");
+    REGISTER_COMMAND(Bitmap, "bitmap");
+    REGISTER_COMMAND(Emit, "emit");
+    REGISTER_COMMAND(Count, "count");
+    REGISTER_COMMAND(Sat, "sat");
+    REGISTER_COMMAND(Taut, "taut");
+    REGISTER_COMMAND(Support, "support");
     return dispatchTable;
 }
 }
@@ -21,30 +21,53 @@
 #include <lang/Runtime.hpp>
 #include <lang/DispatchTable.hpp>
 #include <stdexcept>
+#include <chrono>
 #include <core/Utils.hpp>
+#include <core/ThreadPool.hpp>
 
 using namespace std;
 
 namespace Logic {
+class CommandObserver {
+public:
+    // Called with the command's name (see DispatchTable::getCommandName()) after every statement is executed, including
+    // the ones nested in the blocks of other statements, and the failed ones. The elapsed time of a statement includes
+    // that of its nested statements. With a thread pool, this is called from the interpreter's thread, in the program
+    // order, once the statements up to the first failed one are done.
+    virtual void onCommandExecuted(const string &command, const chrono::steady_clock::duration &elapsed) = 0;
+
+    virtual ~CommandObserver() {
+    }
+};
+
 class Interpreter
 {
 public:
-    Interpreter(Runtime &runtime, DispatchTable &dispatchTable, istream &in, ostream &out, const bool printPrompts)
-        : runtime(runtime), dispatchTable(dispatchTable), in(in), out(out), printPrompts(printPrompts) {
+    // If a threadPool is provided, the independent top level statements are executed concurrently on it.
+    // The output and the final state of the runtime are the same as that of a sequential execution.
+    Interpreter(Runtime &runtime, DispatchTable &dispatchTable, istream &in, ostream &out, const bool printPrompts, ThreadPool *threadPool = nullptr)
+        : runtime(runtime), dispatchTable(dispatchTable), in(in), out(out), printPrompts(printPrompts), threadPool(threadPool) {
     }
 
     void start();
     void run();
 
+    // The observer is not owned, and needs to outlive this Interpreter. Null to stop observing.
+    void setCommandObserver(CommandObserver *observer) {
+        this->observer = observer;
+    }
+
 private:
     Runtime &runtime;
     DispatchTable &dispatchTable;
     istream &in;
     ostream &out;
     const bool printPrompts;
+    ThreadPool *threadPool;
+    CommandObserver *observer = nullptr;
 
     Interpreter(const Interpreter &rhs)
-        : runtime(rhs.runtime), dispatchTable(rhs.dispatchTable), in(rhs.in), out(rhs.out), printPrompts(rhs.printPrompts) {
+        : runtime(rhs.runtime), dispatchTable(rhs.dispatchTable), in(rhs.in), out(rhs.out), printPrompts(rhs.printPrompts), threadPool(rhs.threadPool) {
             throw runtime_error("Copying Interpreter object not allowed.");
     }
 
@@ -56,5 +79,6 @@ private:
     string nextLine(istream &in);
     void printPromptsIfNeeded();
     bool executeCode(istream &in);
+    bool executeCodeConcurrently(istream &in);
 };
 }
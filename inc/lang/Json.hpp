@@ -0,0 +1,63 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <core/BooleanFunction.hpp>
+#include <core/TruthTableTypes.hpp>
+#include <core/Profiler.hpp>
+#include <core/Tracer.hpp>
+#include <ostream>
+
+using namespace std;
+
+namespace Logic {
+struct JsonMember {
+    bool isString;
+    // The decoded value for strings, else the raw JSON text of the value
+    string value;
+    // The raw JSON text of the value
+    string raw;
+};
+
+// Quotes and escapes the string
+string toJson(const string &value);
+string toJson(const vector<string> &values);
+string toJson(const vector<TruthTableUInt> &values);
+
+/**
+ * A constant value function is {"value": <0 or 1>}. Else, it's {"variables": [...], "values": "<bits>"}, where
+ * "values" holds the value at each truth table line, and the variables are listed in the order of their significance
+ * in the line index, starting from the least significant one.
+ */
+string toJson(const BooleanFunction &function);
+
+// {"commands": {<name>: <entry>, ...}, "operators": {<name>: <entry>, ...}}, where an entry is {"count", "total_ns",
+// "p50_ns", "p90_ns", "p99_ns", "max_ns", "rows", "result_bytes"}, and the available hardware counters among "cycles",
+// "instructions", "cache_misses" and "branch_misses"
+string toJson(const Profiler &profiler);
+
+// Writes the spans in the Chrome trace event format, which chrome://tracing and Perfetto can open
+void writeChromeTrace(const Tracer &tracer, ostream &os);
+
+// Parses a JSON object. Nested objects and arrays are not decoded, but their raw JSON text is available.
+// Throws invalid_argument if the JSON is malformed.
+unordered_map<string, JsonMember> parseJsonObject(const string &json);
+}
@@ -18,26 +18,84 @@
 
 #include <string>
 #include <core/BooleanFunction.hpp>
+#include <core/Expression.hpp>
 #include <core/Utils.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <limits>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
 namespace Logic {
+// How the commands print their results
+enum class OutputFormat {
+    Text,
+    // One JSON value per result, on its own line. See lang/Json.hpp
+    Json
+};
+
 class Runtime {
 public:
     void save(const string &variableName, const BooleanFunction &function);
+    // Makes a function owned elsewhere readable through get() const and contains(), without copying it. It needs to
+    // outlive this runtime, and doesn't count towards its memory usage. A saved function of the same name hides it.
+    void reference(const string &variableName, const BooleanFunction &function);
+    // The saved functions only, since the referenced ones can't be modified
     BooleanFunction &get(const string &variableName);
     const BooleanFunction &get(const string &variableName) const;
     bool contains(const string &variableName) const;
     void erase(const string &variableName);
 
+    // The bytes held by all the functions in the workspace
+    uint64_t getMemoryUsage() const {
+        return memoryUsage;
+    }
+
+    // The names and the bytes held by the functions in the workspace, largest first
+    vector<pair<string, uint64_t>> getFunctionsByMemoryUsage() const;
+
+    // The evaluations are limited to what's left of this after the workspace's memory usage. Unlimited by default.
+    void setMaxMemory(const uint64_t bytes) {
+        maxMemory = bytes;
+    }
+
+    uint64_t getMaxMemory() const {
+        return maxMemory;
+    }
+
+    uint64_t getAvailableMemory() const {
+        return memoryUsage >= maxMemory ? 0 : maxMemory - memoryUsage;
+    }
+
     void flag(const string &flagName);
     bool getFlag(const string &flagName);
     void clearFlags();
+
+    void setEvaluationOptions(const EvaluationOptions &options) {
+        evaluationOptions = options;
+    }
+
+    const EvaluationOptions &getEvaluationOptions() const {
+        return evaluationOptions;
+    }
+
+    void setOutputFormat(const OutputFormat format) {
+        outputFormat = format;
+    }
+
+    OutputFormat getOutputFormat() const {
+        return outputFormat;
+    }
+
 private:
     unordered_map<string, BooleanFunction> workspace;
+    unordered_map<string, const BooleanFunction *> references;
     unordered_set<string> flags;
+    EvaluationOptions evaluationOptions;
+    OutputFormat outputFormat = OutputFormat::Text;
+    uint64_t memoryUsage = 0;
+    uint64_t maxMemory = numeric_limits<uint64_t>::max();
 };
 }
@@ -0,0 +1,81 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <app/Framing.hpp>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+namespace Logic {
+static bool readFully(const int fd, char *buffer, size_t size) {
+    while (size > 0) {
+        const ssize_t count = read(fd, buffer, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+static bool writeFully(const int fd, const char *buffer, size_t size) {
+    while (size > 0) {
+        const ssize_t count = write(fd, buffer, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+bool readFrame(const int fd, string &payload) {
+    unsigned char header[4];
+    if (!readFully(fd, (char *) header, sizeof(header))) {
+        return false;
+    }
+
+    const uint32_t size = ((uint32_t) header[0] << 24) | ((uint32_t) header[1] << 16) | ((uint32_t) header[2] << 8) | (uint32_t) header[3];
+    if (size > MAX_FRAME_SIZE) {
+        return false;
+    }
+
+    payload.resize(size);
+    return size == 0 || readFully(fd, &payload[0], size);
+}
+
+bool writeFrame(const int fd, const string &payload) {
+    // A peer would reject it, and its size may not even fit in the header
+    if (payload.size() > MAX_FRAME_SIZE) {
+        return false;
+    }
+
+    const uint32_t size = (uint32_t) payload.size();
+    const unsigned char header[4] = {
+        (unsigned char) (size >> 24), (unsigned char) (size >> 16), (unsigned char) (size >> 8), (unsigned char) size
+    };
+    return writeFully(fd, (const char *) header, sizeof(header)) && writeFully(fd, payload.data(), payload.size());
+}
+}
@@ -15,12 +15,36 @@
 */
 
 #include <app/Modes.hpp>
+#include <app/Workspaces.hpp>
+#include <app/Framing.hpp>
 #include <string>
 #include <lang/Interpreter.hpp>
 #include <exception>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <core/ThreadPool.hpp>
+#include <core/Profiler.hpp>
+#include <core/Tracer.hpp>
+#include <core/Utils.hpp>
+#include <thread>
+#include <chrono>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <limits>
+#include <lang/Json.hpp>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 using namespace std;
 
@@ -32,13 +56,45 @@ int HelpMode::run() {
     cout << "      <no option>         : starts in interactive mode if no option is provided" << endl;
     cout << "      [filepath]          : executes the code in the text file located at <filepath>" << endl;
     cout << "      -c, --code [code]   : executes the code string passed as the command line arg itself" << endl;
+    cout << "      -j, --jobs [n] [filepaths...]" << endl;
+    cout << "                          : executes the code in each of the files concurrently on n threads, each in its own" << endl;
+    cout << "                            workspace. The outputs are printed in the order of the files, and the exit" << endl;
+    cout << "                            status is 1 if any of them failed" << endl;
+    cout << "      -s, --serve [path]  : serves requests on the Unix domain socket at <path>, keeping the workspaces resident" << endl;
+    cout << "      --jsonl             : executes the JSON requests read from stdin, one per line, and writes a JSON response" << endl;
+    cout << "                            per line to stdout. The requests are executed on a pool of threads (see -t)" << endl;
     cout << "      -h, --help          : print this usage info" << endl;
+    cout << "    execution options (must precede [filepath] or -c):" << endl;
+    cout << "      -t, --threads [n]   : executes the independent statements and subexpressions concurrently on n threads" << endl;
+    cout << "      --profile           : profiles the commands and the operators (see the 'stats' command), and prints the" << endl;
+    cout << "                            profile to stderr at the end. Also applies to the interactive mode. Uses the CPU's" << endl;
+    cout << "                            performance counters too, where Linux allows it" << endl;
+    cout << "      --trace [path]      : writes the spans of the statements, blocks, parses and operators to <path> as a" << endl;
+    cout << "                            Chrome trace (for chrome://tracing or Perfetto) at the end. Also applies to the" << endl;
+    cout << "                            interactive mode" << endl;
+    cout << "      --reduce-support    : removes from every evaluated function the variables it doesn't depend on, like b" << endl;
+    cout << "                            in (a & b) | (a & !b), so they don't double the size of the functions built on it." << endl;
+    cout << "                            Also applies to the interactive mode" << endl;
+    cout << "      --max-memory [size] : limits every workspace's functions and evaluations to <size> bytes (with an optional" << endl;
+    cout << "                            K, M or G suffix). Evaluations that wouldn't fit fail before allocating anything." << endl;
+    cout << "                            Also applies to the interactive, batch, server and JSON lines modes. With -t, the" << endl;
+    cout << "                            statements defining functions are executed one at a time, as they'd be without it" << endl;
 
     return returnCode;
 }
 
 int CodeExecutionMode::run() {
-    Interpreter interpreter(runtime, dispatchTable, *codeStream, cout, config.printPrompts);
+    unique_ptr<ThreadPool> threadPool(config.numThreads > 1 ? new ThreadPool(config.numThreads) : nullptr);
+    EvaluationOptions evaluationOptions = runtime.getEvaluationOptions();
+    unique_ptr<Profiler> profiler(config.profile ? new Profiler(true) : nullptr);
+    unique_ptr<Tracer> tracer(config.tracePath.empty() ? nullptr : new Tracer());
+    evaluationOptions.threadPool = threadPool.get();
+    evaluationOptions.profiler = profiler.get();
+    evaluationOptions.tracer = tracer.get();
+    evaluationOptions.reduceSupport = config.reduceSupport;
+    runtime.setEvaluationOptions(evaluationOptions);
+    runtime.setMaxMemory(config.maxMemory);
+    Interpreter interpreter(runtime, dispatchTable, *codeStream, cout, config.printPrompts, threadPool.get());
     interpreter.start();
     do {
         try {
@@ -48,6 +104,19 @@ int CodeExecutionMode::run() {
             cerr << "ERROR: " << ex.what() << endl;
         }
     } while (!config.terminateOnFailure);
+
+    if (profiler) {
+        cerr << *profiler << endl;
+    }
+
+    if (tracer) {
+        ofstream trace(config.tracePath);
+        writeChromeTrace(*tracer, trace);
+        if (!trace) {
+            cerr << "ERROR: Couldn't write the trace to " << config.tracePath << endl;
+            return 1;
+        }
+    }
     return 0;
 }
 
@@ -57,28 +126,404 @@ CodeExecutionMode::~CodeExecutionMode() {
     }
 }
 
+static ScriptResult executeScript(const string &path, DispatchTable &dispatchTable, const uint64_t maxMemory) {
+    ifstream code(path);
+    if (!code) {
+        ScriptResult result;
+        result.error = "Cannot open the file.";
+        return result;
+    }
+
+    Runtime runtime;
+    runtime.setMaxMemory(maxMemory);
+    return executeScript(code, runtime, dispatchTable);
+}
+
+int BatchMode::run() {
+    // Commands are stateless, so a single dispatch table can be shared by all the scripts
+    DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+    ThreadPool threadPool(numJobs);
+
+    vector<future<ScriptResult>> results;
+    for (const string &path : paths) {
+        const uint64_t maxMemory = this->maxMemory;
+        results.push_back(threadPool.submit([&dispatchTable, path, maxMemory]() {
+            return executeScript(path, dispatchTable, maxMemory);
+        }));
+    }
+
+    int returnCode = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const ScriptResult result = results[i].get();
+        out << result.output << flush;
+        if (!result.error.empty()) {
+            err << "ERROR: " << paths[i] << ": " << result.error << endl;
+            returnCode = 1;
+        }
+    }
+    return returnCode;
+}
+
+void ServerMode::serve(const int connection) {
+    string request;
+    while (readFrame(connection, request)) {
+        const size_t separator = request.find('\n');
+        string response;
+        if (separator == string::npos) {
+            response = "ERROR: Expected the workspace name and the code separated by a new line.\n";
+        } else {
+            const ScriptResult result = workspaces.execute(request.substr(0, separator), request.substr(separator + 1));
+            response = (result.error.empty() ? string("OK") : "ERROR: " + result.error) + "\n" + result.output;
+        }
+        if (response.size() > MAX_FRAME_SIZE) {
+            response = "ERROR: The response is larger than the limit of " + formatBytes(MAX_FRAME_SIZE) + " for a message.\n";
+        }
+
+        if (!writeFrame(connection, response)) {
+            break;
+        }
+    }
+    close(connection);
+}
+
+int ServerMode::run() {
+    // A client hanging up mid-response must not take the server down
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.length() >= sizeof(address.sun_path)) {
+        cerr << "ERROR: The socket path is too long: " << socketPath << endl;
+        return -1;
+    }
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // Replace a stale socket left behind by a previous server, but nothing else
+    struct stat existing;
+    if (stat(socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(socketPath.c_str());
+    }
+
+    const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 ||
+        ::bind(server, (const sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(server, SOMAXCONN) != 0) {
+        cerr << "ERROR: Cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+        if (server >= 0) {
+            close(server);
+        }
+        return -1;
+    }
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(connectionsMutex);
+            connectionClosed.wait(lock, [this]() { return numConnections < maxConnections; });
+        }
+
+        const int connection = accept(server, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            cerr << "ERROR: Cannot accept connections on " << socketPath << ": " << strerror(errno) << endl;
+            close(server);
+            return -1;
+        }
+
+        {
+            unique_lock<mutex> lock(connectionsMutex);
+            ++numConnections;
+        }
+        thread([this, connection]() {
+            serve(connection);
+            unique_lock<mutex> lock(connectionsMutex);
+            --numConnections;
+            connectionClosed.notify_one();
+        }).detach();
+    }
+}
+
+struct JsonRequest {
+    // The raw JSON of the request's id
+    string id;
+    string script;
+    string workspace;
+    OutputFormat format;
+};
+
+// The raw JSON of the request's id, if it has one
+static string getRequestId(const unordered_map<string, JsonMember> &members) {
+    const auto id = members.find("id");
+    return id == members.end() ? "null" : id->second.raw;
+}
+
+static JsonRequest parseJsonRequest(const unordered_map<string, JsonMember> &members) {
+    JsonRequest request;
+    request.id = getRequestId(members);
+
+    const auto script = members.find("script");
+    if (script == members.end() || !script->second.isString) {
+        throw invalid_argument("The request needs a string 'script'");
+    }
+    request.script = script->second.value;
+
+    const auto workspace = members.find("workspace");
+    if (workspace != members.end() && workspace->second.raw != "null") {
+        if (!workspace->second.isString) {
+            throw invalid_argument("The request's 'workspace' needs to be a string");
+        }
+        request.workspace = workspace->second.value;
+    }
+
+    const auto format = members.find("format");
+    request.format = OutputFormat::Text;
+    if (format != members.end() && format->second.raw != "null") {
+        if (format->second.isString && format->second.value == "json") {
+            request.format = OutputFormat::Json;
+        } else if (!format->second.isString || format->second.value != "text") {
+            throw invalid_argument("The request's 'format' needs to be either \"text\" or \"json\"");
+        }
+    }
+    return request;
+}
+
+static string getJsonResponse(const string &id, const ScriptResult &result, const OutputFormat format, const int64_t elapsedMicroseconds) {
+    stringstream response;
+    response << "{\"id\":" << id
+             << ",\"ok\":" << (result.error.empty() ? "true" : "false");
+    if (format == OutputFormat::Json) {
+        // Every line of the output is a JSON value
+        vector<string> results = split(result.output, '\n');
+        results.erase(remove_if(results.begin(), results.end(), [](const string &line) { return isWhitespace(line); }), results.end());
+        response << ",\"results\":[" << join(results, ",") << "]";
+    } else {
+        response << ",\"output\":" << toJson(result.output);
+    }
+    response << ",\"error\":" << (result.error.empty() ? "null" : toJson(result.error))
+             << ",\"elapsed_us\":" << elapsedMicroseconds
+             << "}";
+    return response.str();
+}
+
+int JsonLinesMode::run() {
+    ThreadPool threadPool(numThreads);
+
+    // The responses are written by a separate thread, so that a client waiting for a response before sending the
+    // next request isn't blocked by the reads
+    mutex responsesMutex;
+    condition_variable responsesAvailable;
+    queue<shared_future<string>> responses;
+    bool readAllRequests = false;
+    thread writer([&]() {
+        while (true) {
+            shared_future<string> response;
+            {
+                unique_lock<mutex> lock(responsesMutex);
+                responsesAvailable.wait(lock, [&]() { return readAllRequests || !responses.empty(); });
+                if (responses.empty()) {
+                    return;
+                }
+                response = responses.front();
+                responses.pop();
+            }
+            out << response.get() << endl;
+        }
+    });
+
+    // The latest request for every workspace. Each request waits for the previous one for its workspace, which is
+    // safe, as the pool starts the tasks in the order they were submitted.
+    unordered_map<string, shared_future<string>> latestRequests;
+
+    string line;
+    while (getline(in, line)) {
+        if (isWhitespace(line)) {
+            continue;
+        }
+
+        shared_future<string> response;
+        // Known once the line is parsed, so that the errors in the rest of the request can be matched with it
+        string id = "null";
+        try {
+            const unordered_map<string, JsonMember> members = parseJsonObject(line);
+            id = getRequestId(members);
+            const JsonRequest request = parseJsonRequest(members);
+            shared_future<string> previous;
+            if (!request.workspace.empty()) {
+                previous = latestRequests[request.workspace];
+            }
+
+            response = threadPool.submit([this, request, previous]() {
+                if (previous.valid()) {
+                    previous.wait();
+                }
+
+                const auto start = chrono::steady_clock::now();
+                ScriptResult result;
+                if (request.workspace.empty()) {
+                    Runtime runtime;
+                    runtime.setOutputFormat(request.format);
+                    runtime.setMaxMemory(workspaces.getMaxMemory());
+                    stringstream code(request.script);
+                    result = executeScript(code, runtime, workspaces.getDispatchTable());
+                } else {
+                    result = workspaces.execute(request.workspace, request.script, request.format);
+                }
+                const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+                return getJsonResponse(request.id, result, request.format, (int64_t) elapsed.count());
+            }).share();
+
+            if (!request.workspace.empty()) {
+                latestRequests[request.workspace] = response;
+            }
+        } catch (const exception &ex) {
+            ScriptResult result;
+            result.error = string("Bad request: ") + ex.what();
+            promise<string> badRequest;
+            badRequest.set_value(getJsonResponse(id, result, OutputFormat::Text, 0));
+            response = badRequest.get_future().share();
+        }
+
+        {
+            unique_lock<mutex> lock(responsesMutex);
+            responses.push(response);
+        }
+        responsesAvailable.notify_one();
+    }
+
+    {
+        unique_lock<mutex> lock(responsesMutex);
+        readAllRequests = true;
+    }
+    responsesAvailable.notify_one();
+    writer.join();
+    return 0;
+}
+
+// Parses a strictly positive integer option value. Returns 0 if invalid.
+static size_t parsePositiveInteger(const string &value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != string::npos) {
+        return 0;
+    }
+
+    try {
+        return stoul(value);
+    } catch (const out_of_range &) {
+        return 0;
+    }
+}
+
+// Parses a byte size with an optional K, M or G (binary) suffix, like 512M. Returns 0 if invalid.
+static uint64_t parseMemorySize(const string &value) {
+    if (value.empty()) {
+        return 0;
+    }
+
+    unsigned shift = 0;
+    string digits = value;
+    switch (value.back()) {
+        case 'K': case 'k': shift = 10; break;
+        case 'M': case 'm': shift = 20; break;
+        case 'G': case 'g': shift = 30; break;
+        default: break;
+    }
+    if (shift != 0) {
+        digits.pop_back();
+    }
+
+    const uint64_t size = parsePositiveInteger(digits);
+    if (size > (numeric_limits<uint64_t>::max() >> shift)) {
+        return 0;
+    }
+    return size << shift;
+}
+
 unique_ptr<Mode> getMode(const int argc, const char * const *argv) {
+    vector<string> args(argv + 1, argv + argc);
+
+    // Execution options
+    size_t numThreads = 1;
+    bool hasThreadsOption = false;
+    bool profile = false;
+    bool reduceSupport = false;
+    string tracePath;
+    uint64_t maxMemory = numeric_limits<uint64_t>::max();
+    size_t i = 0;
+    while (i < args.size()) {
+        const string &option = args[i];
+        if (option == "-t" || option == "--threads") {
+            if (i + 1 == args.size() || (numThreads = parsePositiveInteger(args[i + 1])) == 0) {
+                return unique_ptr<Mode>(new HelpMode(-1, argv[0]));
+            }
+            hasThreadsOption = true;
+            i += 2;
+        } else if (option == "--profile") {
+            profile = true;
+            ++i;
+        } else if (option == "--reduce-support") {
+            reduceSupport = true;
+            ++i;
+        } else if (option == "--trace") {
+            if (i + 1 == args.size()) {
+                return unique_ptr<Mode>(new HelpMode(-1, argv[0]));
+            }
+            tracePath = args[i + 1];
+            i += 2;
+        } else if (option == "--max-memory") {
+            if (i + 1 == args.size() || (maxMemory = parseMemorySize(args[i + 1])) == 0) {
+                return unique_ptr<Mode>(new HelpMode(-1, argv[0]));
+            }
+            i += 2;
+        } else {
+            break;
+        }
+    }
+    // The memory limit applies to every mode, but the rest only to the ones executing a single workspace's code
+    const bool hasExecutionOptions = hasThreadsOption || profile || reduceSupport || !tracePath.empty();
+    args.erase(args.begin(), args.begin() + (long) i);
+
     Mode *mode = nullptr;
-    if (argc == 1) {
-        // Interactive
-        mode = new CodeExecutionMode({ false, false, true }, &cin);
-    } else if (argc == 2) {
-        string path = argv[1];
+    if (args.size() >= 3 && (args[0] == "-j" || args[0] == "--jobs")) {
+        const size_t numJobs = parsePositiveInteger(args[1]);
+        if (numJobs == 0 || hasExecutionOptions) {
+            // Each script is executed sequentially in the batch mode
+            mode = new HelpMode(-1, argv[0]);
+        } else {
+            mode = new BatchMode(numJobs, vector<string>(args.begin() + 2, args.end()), maxMemory, cout, cerr);
+        }
+    } else if (args.size() == 0) {
+        if (hasThreadsOption) {
+            // The statements are executed one at a time in the interactive mode
+            mode = new HelpMode(-1, argv[0]);
+        } else {
+            // Interactive
+            mode = new CodeExecutionMode({ false, false, true, 1, profile, tracePath, maxMemory, reduceSupport }, &cin);
+        }
+    } else if (args.size() == 1) {
+        string path = args[0];
         if (path == "-c" || path == "--code") {
             // Can't use this as the file path, because this is the direct code option
             mode = new HelpMode(-1, argv[0]);
+        } else if (path == "--jsonl") {
+            mode = profile || reduceSupport || !tracePath.empty() ? (Mode *) new HelpMode(-1, argv[0]) :
+                             new JsonLinesMode(hasThreadsOption ? numThreads : max(thread::hardware_concurrency(), 1u), maxMemory, cin, cout);
+        } else if (path == "-s" || path == "--serve") {
+            mode = new HelpMode(-1, argv[0]);
         } else if (path == "-h" || path == "--help") {
             mode = new HelpMode(0, argv[0]);
         } else {
-            mode = new CodeExecutionMode({ true, true, false }, new ifstream(path));
+            mode = new CodeExecutionMode({ true, true, false, numThreads, profile, tracePath, maxMemory, reduceSupport }, new ifstream(path));
         }
-    } else if (argc == 3) {
-        string option = argv[1];
+    } else if (args.size() == 2) {
+        string option = args[0];
         if (option == "-c" || option == "--code") {
             // Run this code
             stringstream *codeStream = new stringstream();
-            (*codeStream) << argv[2];
-            mode = new CodeExecutionMode({ true, true, false }, codeStream);
+            (*codeStream) << args[1];
+            mode = new CodeExecutionMode({ true, true, false, numThreads, profile, tracePath, maxMemory, reduceSupport }, codeStream);
+        } else if ((option == "-s" || option == "--serve") && !hasExecutionOptions) {
+            mode = new ServerMode(string(args[1]), maxMemory);
         } else {
             mode = new HelpMode(-1, argv[0]);
         }
@@ -0,0 +1,57 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <app/Workspaces.hpp>
+#include <lang/Interpreter.hpp>
+#include <exception>
+#include <sstream>
+
+using namespace std;
+
+namespace Logic {
+ScriptResult executeScript(istream &code, Runtime &runtime, DispatchTable &dispatchTable) {
+    ScriptResult result;
+    stringstream out;
+    Interpreter interpreter(runtime, dispatchTable, code, out, false);
+    try {
+        interpreter.run();
+    } catch (const exception &ex) {
+        result.error = ex.what();
+    }
+    result.output = out.str();
+    return result;
+}
+
+Workspaces::Workspace &Workspaces::getWorkspace(const string &workspaceName) {
+    unique_lock<mutex> lock(workspacesMutex);
+    unique_ptr<Workspace> &workspace = workspaces[workspaceName];
+    if (workspace == nullptr) {
+        workspace.reset(new Workspace());
+        workspace->runtime.setMaxMemory(maxMemory);
+    }
+    // Workspaces are never removed, so the reference stays valid after the lock is released
+    return *workspace;
+}
+
+ScriptResult Workspaces::execute(const string &workspaceName, const string &code, const OutputFormat format) {
+    Workspace &workspace = getWorkspace(workspaceName);
+    stringstream codeStream(code);
+    unique_lock<mutex> lock(workspace.lock);
+    workspace.runtime.setOutputFormat(format);
+    return executeScript(codeStream, workspace.runtime, dispatchTable);
+}
+}
@@ -0,0 +1,351 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <core/Bitmap.hpp>
+#include <core/Utils.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace Logic {
+// The words of each column evaluated by a task: 256 KiB
+static const uint64_t CHUNK_WORDS = ((uint64_t) 1) << 15;
+
+// A memory mapped file. The readable ones are mapped as they are, and the writable ones are created (or truncated)
+// with the given size.
+class MappedFile {
+public:
+    MappedFile(const string &path, const bool writable, const uint64_t size = 0) : data(nullptr), size(size), device(0), inode(0) {
+        const int fd = writable ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open " + path + ": " + strerror(errno));
+        }
+
+        struct stat status;
+        if (!writable && fstat(fd, &status) != 0) {
+            close(fd);
+            throw runtime_error("Cannot read " + path + ": " + strerror(errno));
+        }
+        if (!writable) {
+            this->size = (uint64_t) status.st_size;
+            device = status.st_dev;
+            inode = status.st_ino;
+        } else if (ftruncate(fd, (off_t) size) != 0) {
+            close(fd);
+            throw runtime_error("Cannot write " + path + ": " + strerror(errno));
+        }
+
+        if (this->size != 0) {
+            void *mapped = mmap(nullptr, this->size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map " + path + ": " + strerror(errno));
+            }
+            data = (uint8_t *) mapped;
+            // Only a hint: the pages are read ahead, and dropped sooner once read
+            madvise(mapped, this->size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(data, size);
+        }
+    }
+
+    uint64_t getSize() const {
+        return size;
+    }
+
+    // If the readable file is the one at the path
+    bool isAt(const string &path) const {
+        struct stat status;
+        return stat(path.c_str(), &status) == 0 && status.st_dev == device && status.st_ino == inode;
+    }
+
+    uint64_t getNumWords() const {
+        return (size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    }
+
+    // The last word is padded with 0s
+    uint64_t readWord(const uint64_t index) const {
+        uint64_t word = 0;
+        if (index + 1 < getNumWords()) {
+            // A fixed size copy is a single load
+            memcpy(&word, data + index * sizeof(uint64_t), sizeof(uint64_t));
+        } else {
+            memcpy(&word, data + index * sizeof(uint64_t), getWordSize(index));
+        }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    // The bits of the last word beyond the size are dropped
+    void writeWord(const uint64_t index, uint64_t word) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        if (index + 1 < getNumWords()) {
+            memcpy(data + index * sizeof(uint64_t), &word, sizeof(uint64_t));
+        } else {
+            memcpy(data + index * sizeof(uint64_t), &word, getWordSize(index));
+        }
+    }
+
+    // The mask of the bits of the word that are within the size
+    uint64_t getWordMask(const uint64_t index) const {
+        const size_t bits = getWordSize(index) * 8;
+        return bits == 64 ? ~((uint64_t) 0) : (((uint64_t) 1) << bits) - 1;
+    }
+
+private:
+    uint8_t *data;
+    uint64_t size;
+    dev_t device;
+    ino_t inode;
+
+    size_t getWordSize(const uint64_t index) const {
+        return (size_t) min((uint64_t) sizeof(uint64_t), size - index * sizeof(uint64_t));
+    }
+
+    MappedFile(const MappedFile &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying MappedFile object not allowed.");
+    }
+
+    MappedFile &operator=(const MappedFile &rhs) {
+        UNUSED(rhs);
+        throw runtime_error("Copying MappedFile object not allowed.");
+    }
+};
+
+/**
+ * The values of the 16 functions of the first 2 variables at 64 records, where columns holds a word of each of them.
+ * The bit i of a function is its value at the line i of the 2 variables.
+ */
+static void getQuadFunctions(const uint64_t *columns, uint64_t quads[16]) {
+    const uint64_t minterms[4] = {~columns[0] & ~columns[1], columns[0] & ~columns[1], ~columns[0] & columns[1], columns[0] & columns[1]};
+    quads[0] = 0;
+    for (unsigned i = 1; i < 16; ++i) {
+        // The function without its lowest minterm, and that minterm
+        quads[i] = quads[i & (i - 1)] | minterms[__builtin_ctz(i)];
+    }
+}
+
+/**
+ * The values of the (4 to 64) lines of a word of the table at 64 records. Every 4 lines are a function of the first
+ * 2 variables, and the rest of the variables are multiplexed a level of the lines at a time.
+ */
+static uint64_t multiplexWord(const uint64_t lines, const uint64_t *columns, const uint64_t quads[16], const size_t numVariables) {
+    uint64_t values[16];
+    TruthTableUInt numValues = ((TruthTableUInt) 1) << (numVariables - 2);
+    for (TruthTableUInt i = 0; i < numValues; ++i) {
+        values[i] = quads[(lines >> (4 * i)) & 0xF];
+    }
+    for (size_t i = 2; i < numVariables; ++i) {
+        // The pairs of values differ only in the variable i
+        numValues /= 2;
+        for (TruthTableUInt j = 0; j < numValues; ++j) {
+            values[j] = (columns[i] & values[2 * j + 1]) | (~columns[i] & values[2 * j]);
+        }
+    }
+    return values[0];
+}
+
+// The values of the (up to 64) lines of the word at 64 records
+static uint64_t multiplexLines(const uint64_t lines, const uint64_t mask, const uint64_t *columns, const uint64_t quads[16],
+                               const size_t numVariables) {
+    if (lines == 0) {
+        return 0;
+    } else if (lines == mask) {
+        return ~((uint64_t) 0);
+    } else if (numVariables == 1) {
+        // Either the variable or its complement
+        return lines == 2 ? columns[0] : ~columns[0];
+    }
+    return multiplexWord(lines, columns, quads, numVariables);
+}
+
+/**
+ * The values of the table at 64 records, where columns holds a word of each variable, and quads the functions of the
+ * first 2 of them. It's the table's Shannon expansion, with each variable's word choosing between the values of the
+ * lines where the variable is 1 and 0. The words of the table that are all 0 or 1 skip the expansion of their lines.
+ * values must have room for a value per word of the table.
+ */
+static uint64_t multiplex(const uint64_t *table, const uint64_t *columns, const uint64_t quads[16], const size_t numVariables,
+                          uint64_t *values) {
+    if (numVariables <= 6) {
+        const TruthTableUInt numLines = ((TruthTableUInt) 1) << numVariables;
+        const uint64_t mask = numLines == 64 ? ~((uint64_t) 0) : (((uint64_t) 1) << numLines) - 1;
+        return multiplexLines(table[0] & mask, mask, columns, quads, numVariables);
+    }
+
+    TruthTableUInt numValues = ((TruthTableUInt) 1) << (numVariables - 6);
+    for (TruthTableUInt i = 0; i < numValues; ++i) {
+        values[i] = multiplexLines(table[i], ~((uint64_t) 0), columns, quads, 6);
+    }
+    for (size_t i = 6; i < numVariables; ++i) {
+        numValues /= 2;
+        for (TruthTableUInt j = 0; j < numValues; ++j) {
+            values[j] = (columns[i] & values[2 * j + 1]) | (~columns[i] & values[2 * j]);
+        }
+    }
+    return values[0];
+}
+
+// The values of the table at 64 records, where columns holds a word of each variable
+static uint64_t lookUp(const uint64_t *table, const uint64_t *columns, const size_t numVariables) {
+    // A variable at a time for all the records, which vectorizes
+    TruthTableUInt lines[64] = {};
+    for (size_t i = 0; i < numVariables; ++i) {
+        for (unsigned record = 0; record < 64; ++record) {
+            lines[record] |= ((columns[i] >> record) & 1) << i;
+        }
+    }
+
+    uint64_t values = 0;
+    for (unsigned record = 0; record < 64; ++record) {
+        values |= ((table[lines[record] / 64] >> (lines[record] % 64)) & 1) << record;
+    }
+    return values;
+}
+
+/**
+ * The most multiplexers that multiplex() can take for a word of records: one for every pair of values above the words
+ * of the table, and one for every line of the words that aren't all 0 or 1.
+ */
+static uint64_t estimateMultiplexers(const uint64_t *table, const size_t numVariables) {
+    if (numVariables <= 6) {
+        return (((uint64_t) 1) << numVariables) - 1;
+    }
+
+    const TruthTableUInt numWords = ((TruthTableUInt) 1) << (numVariables - 6);
+    uint64_t multiplexers = numWords - 1;
+    for (TruthTableUInt i = 0; i < numWords; ++i) {
+        if (table[i] != 0 && table[i] != ~((uint64_t) 0)) {
+            multiplexers += 63;
+        }
+    }
+    return multiplexers;
+}
+
+// Evaluates the words [first, last) of the records, and returns the number of records the function is true at
+static uint64_t evaluateWords(const uint64_t *table, const vector<const MappedFile *> &columns, const bool multiplexed,
+                              MappedFile &output, const uint64_t first, const uint64_t last) {
+    vector<uint64_t> columnWords(columns.size());
+    uint64_t quads[16];
+    vector<uint64_t> tableWordValues(multiplexed && columns.size() > 6 ? ((size_t) 1) << (columns.size() - 6) : 1);
+    uint64_t count = 0;
+    for (uint64_t word = first; word < last; ++word) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            columnWords[i] = columns[i]->readWord(word);
+        }
+        uint64_t values;
+        if (multiplexed) {
+            if (columns.size() >= 2) {
+                getQuadFunctions(columnWords.data(), quads);
+            }
+            values = multiplex(table, columnWords.data(), quads, columns.size(), tableWordValues.data());
+        } else {
+            values = lookUp(table, columnWords.data(), columns.size());
+        }
+        values &= output.getWordMask(word);
+        output.writeWord(word, values);
+        count += (uint64_t) __builtin_popcountll(values);
+    }
+    return count;
+}
+
+BitmapEvaluationResult evaluateBitmaps(const BooleanFunction &function, const unordered_map<string, string> &columns,
+                                       const string &outputPath, ThreadPool *threadPool) {
+    const vector<string> variables = function.hasTruthTable() ? function.getTruthTable().getVariables() : vector<string>();
+    for (const string &variable : variables) {
+        if (columns.find(variable) == columns.end()) {
+            throw invalid_argument("No column is bound to the variable " + variable + ".");
+        }
+    }
+    if (columns.empty()) {
+        throw invalid_argument("At least one column must be bound to know the number of records.");
+    }
+
+    vector<unique_ptr<MappedFile>> files;
+    unordered_map<string, const MappedFile *> filesByVariable;
+    for (const pair<const string, string> &column : columns) {
+        files.emplace_back(new MappedFile(column.second, false));
+        if (files.back()->getSize() != files.front()->getSize()) {
+            throw invalid_argument("The columns " + columns.begin()->second + " and " + column.second + " have different sizes.");
+        }
+        filesByVariable[column.first] = files.back().get();
+    }
+
+    // In the order of the table's variables, so that the i-th column chooses by the bit i of the line
+    vector<const MappedFile *> variableColumns;
+    for (const string &variable : variables) {
+        variableColumns.push_back(filesByVariable[variable]);
+    }
+    const uint64_t constantTable = !function.hasTruthTable() && function.getConstantValue() ? 1 : 0;
+    const uint64_t *table = function.hasTruthTable() ? function.getTruthTable().getWords() : &constantTable;
+
+    for (const unique_ptr<MappedFile> &file : files) {
+        if (file->isAt(outputPath)) {
+            // It'd be truncated before it's read
+            throw invalid_argument("The output " + outputPath + " can't be one of the columns.");
+        }
+    }
+
+    // Looking a record's line up takes an operation for every variable, so the whole table is multiplexed only if it's
+    // cheaper than looking all the 64 records up
+    const bool multiplexed = estimateMultiplexers(table, variables.size()) <= 64 * (variables.size() + 1);
+
+    const uint64_t size = files.front()->getSize();
+    MappedFile output(outputPath, true, size);
+    const uint64_t numWords = output.getNumWords();
+    const uint64_t numChunks = (numWords + CHUNK_WORDS - 1) / CHUNK_WORDS;
+    auto evaluateChunk = [&, table](const uint64_t chunk) -> uint64_t {
+        return evaluateWords(table, variableColumns, multiplexed, output, chunk * CHUNK_WORDS, min(numWords, (chunk + 1) * CHUNK_WORDS));
+    };
+
+    uint64_t count = 0;
+    const uint64_t numConcurrentChunks = threadPool == nullptr ? 1 : threadPool->size() + 1;
+    for (uint64_t chunk = 0; chunk < numChunks; chunk += numConcurrentChunks) {
+        // A round of chunks at a time, so that only as many tasks as the pool can run are waiting on it
+        const uint64_t roundEnd = min(numChunks, chunk + numConcurrentChunks);
+        vector<unique_ptr<ForkedTask<uint64_t>>> forked;
+        for (uint64_t next = chunk + 1; next < roundEnd; ++next) {
+            forked.emplace_back(new ForkedTask<uint64_t>(*threadPool, [&evaluateChunk, next]() {
+                return evaluateChunk(next);
+            }));
+        }
+        count += evaluateChunk(chunk);
+        for (unique_ptr<ForkedTask<uint64_t>> &task : forked) {
+            count += task->join();
+        }
+    }
+    return BitmapEvaluationResult{size * 8, count};
+}
+}
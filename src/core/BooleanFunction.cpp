@@ -44,6 +44,34 @@ bool operator==(const BooleanFunction &left, const BooleanFunction &right) {
     return false;
 }
 
+BooleanFunction reduceSupport(const BooleanFunction &function) {
+    if (function.isConstant()) {
+        return function;
+    }
+
+    // The vacuous variables can take any value, so the lines where they're 0 are kept. They're removed from the last
+    // one, so the columns of the ones left stay the same.
+    const TruthTable &table = function.getTruthTable();
+    vector<TruthTableVariablesUInt> vacuous;
+    for (TruthTableVariablesUInt i = (TruthTableVariablesUInt) table.getVariables().size(); i > 0; --i) {
+        if (!table.dependsOn(i - 1)) {
+            vacuous.push_back(i - 1);
+        }
+    }
+    if (vacuous.empty()) {
+        return function;
+    }
+    if (vacuous.size() == table.getVariables().size()) {
+        return BooleanFunction(table[0]);
+    }
+
+    TruthTable reduced = table.getCofactor(vacuous[0], false);
+    for (size_t i = 1; i < vacuous.size(); ++i) {
+        reduced = reduced.getCofactor(vacuous[i], false);
+    }
+    return BooleanFunction(reduced);
+}
+
 BooleanFunction::BooleanFunction(const TruthTable &table) : constValue(nullptr) {
     this->table = new TruthTable(table);
 }
@@ -105,6 +133,10 @@ const TruthTable &BooleanFunction::getTruthTable() const {
     throw IllegalStateException("Cannot get the truth table of a constant value Boolean function.");
 }
 
+uint64_t BooleanFunction::getMemoryUsage() const {
+    return hasTruthTable() ? table->getMemoryUsage() : 0;
+}
+
 bool BooleanFunction::isConstant() const {
     return constValue != nullptr;
 }
@@ -17,17 +17,16 @@
 #include <core/BooleanFunctionParser.hpp>
 #include <vector>
 #include <stdint.h>
-#include <mutex>
 #include <regex>
 #include <core/Exceptions.hpp>
 #include <core/Utils.hpp>
+#include <core/Tracer.hpp>
+#include <core/Optimizer.hpp>
 #include <utility>
 
 using namespace Logic;
 using namespace std;
 
-static mutex infixTokenRegexMutex;
-
 template <typename T>
 static T topAndPop(stack<T> &_stack) {
     T top = _stack.top();
@@ -39,18 +38,21 @@ namespace Logic {
 static const string BOOLEAN_FUNCTION_REGEX = "[0]{1}|[1]{1}|[\\$]?" + VARIABLE_REGEX;
 
 static string getInfixTokensRegex() {
-    static string result;
-    unique_lock<mutex> lock(infixTokenRegexMutex);
-    if (result.length() == 0) {
-        vector<string> tokens = OPERATOR_REGEXES;
-        tokens.push_back("[\\(]");
-        tokens.push_back("[\\)]");
-        tokens.push_back(BOOLEAN_FUNCTION_REGEX);
-        result = "[\\s]*(" + // Optional leading spaces
-                 join(tokens, "|") + // actual token regex
-                 ")[\\s]*"; // optional trailing spaces
-    }
-    return result;
+    vector<string> tokens = OPERATOR_REGEXES;
+    tokens.push_back("[\\(]");
+    tokens.push_back("[\\)]");
+    tokens.push_back(BOOLEAN_FUNCTION_REGEX);
+    return "[\\s]*(" + // Optional leading spaces
+           join(tokens, "|") + // actual token regex
+           ")[\\s]*"; // optional trailing spaces
+}
+
+static string getOperatorStackItemsRegex() {
+    // These are the regexes of the tokens that are allowed before a ")".
+    // In other words, these can be put in the operator stack until a ")" is encountered
+    vector<string> operatorStackItems = OPERATOR_REGEXES;
+    operatorStackItems.push_back("[\\(]");
+    return join(operatorStackItems, "|");
 }
 
 void BooleanFunctionAccumulator::push(const BooleanFunction &function) {
@@ -87,7 +89,9 @@ bool BooleanFunctionAccumulator::canBePopped() {
 
 // This will wrap even single variable names for easier application of unary operators
 static vector<string> getInfixTokens(const string &function) {
-    regex tokensRegex(getInfixTokensRegex());
+    // Compiled once, as these are used for every parsed function. The static initialization is thread safe.
+    static const regex tokensRegex(getInfixTokensRegex());
+    static const regex booleanFunctionRegex(BOOLEAN_FUNCTION_REGEX);
     smatch sm;
     vector<string> tokens;
     uint64_t i = 0;
@@ -96,7 +100,7 @@ static vector<string> getInfixTokens(const string &function) {
     while (i < function.length() && regex_search((substring = function.substr(i, string::npos)), sm, tokensRegex, regex_constants::match_continuous)) {
         // Index 1 => The first group in the regex
         string token = sm[1];
-        if (regex_match(token, regex(BOOLEAN_FUNCTION_REGEX))) {
+        if (regex_match(token, booleanFunctionRegex)) {
             // Surround by parenthesis, so that the unary operators are properly applied
             tokens.push_back("(");
             tokens.push_back(token);
@@ -119,11 +123,7 @@ static vector<string> getPostfixTokens(const string &function) {
     stack<string> operatorStack;
     vector<string> postfixTokens;
 
-    // These are the regexes of the tokens that are allowed before a ")".
-    // In other words, these can be put in the operator stack until a ")" is encountered
-    vector<string> operatorStackItems = OPERATOR_REGEXES;
-    operatorStackItems.push_back("[\\(]");
-    const regex stackItemsRegex(join(operatorStackItems, "|"));
+    static const regex stackItemsRegex(getOperatorStackItemsRegex());
     smatch sm;
 
     for (size_t i = 0; i < infixTokens.size(); ++i) {
@@ -200,27 +200,56 @@ BooleanFunction BooleanFunctionParser::parse(const string &function) const {
 }
 
 BooleanFunction BooleanFunctionParser::parse(const string &function, std::function<const BooleanFunction& (const string&)> lookupFunction) const {
+    TraceSpan span(options.tracer, "parse", "parse");
+    const unique_ptr<Expression> expression = compile(function, lookupFunction);
+    const uint64_t estimate = expression->estimatePeakMemoryUsage();
+    if (estimate > options.memoryBudget) {
+        const chrono::nanoseconds duration = Expression::estimateDuration(expression->estimateTotalWork());
+        throw MemoryLimitExceededException("Evaluating this function needs about " + formatBytes(estimate) + " of memory and " +
+                                           formatDuration((uint64_t) duration.count()) + ", but only " +
+                                           formatBytes(options.memoryBudget) + " is available: " + function);
+    }
+    BooleanFunction result = expression->evaluate(options);
+    if (options.reduceSupport) {
+        result = reduceSupport(result);
+    }
+    span.addArgument("expression", function);
+    span.addArgument("result_rows", result.hasTruthTable() ? result.getTruthTable().size() : 1);
+    return result;
+}
+
+unique_ptr<Expression> BooleanFunctionParser::compile(const string &function, std::function<const BooleanFunction& (const string&)> lookupFunction) const {
     vector<string> postfixTokens = getPostfixTokens(trim(function));
-    BooleanFunctionAccumulator accumulator;
+    stack<unique_ptr<Expression>> operands;
     for (const string &token : postfixTokens) {
         if (isKnownUnaryOperator(token)) {
-            UnaryOperator *op;
+            unique_ptr<UnaryOperator> op;
             try {
-                op = createUnaryOperatorWithSymbol(token);
+                op.reset(createUnaryOperatorWithSymbol(token));
             } catch (const invalid_argument &ex) {
                 throw BadBooleanFunctionException(ex.what());
             }
-            accumulator.push(*op);
-            delete op;
+            if (operands.empty()) {
+                throw IllegalStateException("Cannot push a unary operator on an empty stack.");
+            }
+            unique_ptr<Expression> operand = move(operands.top());
+            operands.pop();
+            operands.push(unique_ptr<Expression>(new UnaryOperatorExpression(move(op), move(operand))));
         } else if (isKnownBinaryOperator(token)) {
-            BinaryOperator *op;
+            unique_ptr<BinaryOperator> op;
             try {
-                op = createBinaryOperatorWithSymbol(token);
+                op.reset(createBinaryOperatorWithSymbol(token));
             } catch (const invalid_argument &ex) {
                 throw BadBooleanFunctionException(ex.what());
             }
-            accumulator.push(*op);
-            delete op;
+            if (operands.size() < 2) {
+                throw IllegalStateException("Cannot push a binary operator on an stack of size less than 2");
+            }
+            unique_ptr<Expression> operand2 = move(operands.top());
+            operands.pop();
+            unique_ptr<Expression> operand1 = move(operands.top());
+            operands.pop();
+            operands.push(unique_ptr<Expression>(new BinaryOperatorExpression(move(op), move(operand1), move(operand2))));
         } else {
             // token == variable
             if (token.c_str()[0] == '$') {
@@ -230,24 +259,34 @@ BooleanFunction BooleanFunctionParser::parse(const string &function, std::functi
                     throw UnknownTokenException("'$' is reserved token, and cannot be used as a variable name.");
                 }
                 const BooleanFunction &function = lookupFunction(lookupFunctionName);
-                accumulator.push(function);
+                operands.push(unique_ptr<Expression>(new FunctionReferenceExpression(lookupFunctionName, function)));
             } else {
                 if (token == "0" || token == "1") {
-                    accumulator.push(BooleanFunction(token == "1"));
+                    operands.push(unique_ptr<Expression>(new FunctionExpression(BooleanFunction(token == "1"))));
                 } else {
                     BooleanFunction function(TruthTable({ token }));
                     function.getTruthTable()[0] = false;
                     function.getTruthTable()[1] = true;
-                    accumulator.push(function);
+                    operands.push(unique_ptr<Expression>(new FunctionExpression(function)));
                 }
             }
         }
     }
 
-    if (!accumulator.canBePopped()) {
+    if (operands.size() != 1) {
         throw BadBooleanFunctionException("Missing operator tokens in the boolean function.");
     }
 
-    return accumulator.pop();
+    unique_ptr<Expression> expression = move(operands.top());
+    if (options.pushDownConditions) {
+        expression = Logic::pushDownConditions(move(expression));
+    }
+    if (options.reorderChains) {
+        expression = Logic::reorderChains(move(expression));
+    }
+    if (options.fuseOperators) {
+        expression = Logic::fuseOperators(move(expression));
+    }
+    return expression;
 }
 }
@@ -0,0 +1,356 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <core/CodeGenerator.hpp>
+#include <core/Utils.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace Logic {
+// Up to this many variables, the truth table may be packed in the generated code: 16 words
+static const size_t MAX_LOOKUP_TABLE_VARIABLES = 10;
+
+static const unordered_set<string> C_KEYWORDS = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum", "extern", "float",
+    "for", "goto", "if", "inline", "int", "long", "register", "restrict", "return", "short", "signed", "sizeof", "static",
+    "struct", "switch", "typedef", "union", "unsigned", "void", "volatile", "while", "bool", "true", "false", "uint64_t"
+};
+
+// An input of a gate: the output of another gate, or the constant 0, and if it's complemented
+struct GateInput {
+    static const size_t CONSTANT = (size_t) -1;
+
+    size_t gate;
+    bool complemented;
+
+    bool isConstant() const {
+        return gate == CONSTANT;
+    }
+
+    GateInput operator~() const {
+        return GateInput{gate, !complemented};
+    }
+
+    bool operator==(const GateInput &rhs) const {
+        return gate == rhs.gate && complemented == rhs.complemented;
+    }
+};
+
+static const GateInput ZERO = {GateInput::CONSTANT, false};
+static const GateInput ONE = {GateInput::CONSTANT, true};
+
+enum class GateType {
+    Variable, And, Or, Xor
+};
+
+struct Gate {
+    GateType type;
+    // The index of the variable of a Variable gate
+    size_t variable;
+    GateInput first;
+    GateInput second;
+};
+
+/**
+ * A network of gates computing a truth table, built from its Shannon expansion: the variable i chooses between the
+ * cofactors of the lines where it's 1 and 0, and the cofactors are shared with the equal (or complement) ones.
+ * The gates are in a topological order.
+ */
+class GateNetwork {
+public:
+    GateNetwork(const BooleanFunction &function) {
+        if (!function.hasTruthTable()) {
+            output = function.getConstantValue() ? ONE : ZERO;
+            return;
+        }
+
+        const TruthTable &table = function.getTruthTable();
+        for (size_t i = 0; i < table.getVariables().size(); ++i) {
+            gates.push_back(Gate{GateType::Variable, i, ZERO, ZERO});
+        }
+        output = expand(table.getWords(), 0, table.getVariables().size());
+    }
+
+    const vector<Gate> &getGates() const {
+        return gates;
+    }
+
+    GateInput getOutput() const {
+        return output;
+    }
+
+    // The bitwise operations the gates take, including the complements of their inputs
+    size_t getNumOperations() const {
+        size_t operations = output.complemented && !output.isConstant() ? 1 : 0;
+        for (const Gate &gate : gates) {
+            if (gate.type != GateType::Variable) {
+                operations += (size_t) (1 + gate.first.complemented + gate.second.complemented);
+            }
+        }
+        return operations;
+    }
+
+private:
+    vector<Gate> gates;
+    GateInput output;
+    // The cofactors by their lines, and their complements
+    unordered_map<string, GateInput> cofactors;
+    unordered_map<string, GateInput> sharedGates;
+
+    // The lines [offset, offset + 2^numVariables) of the table
+    GateInput expand(const uint64_t *table, const TruthTableUInt offset, const size_t numVariables) {
+        const TruthTableUInt numLines = ((TruthTableUInt) 1) << numVariables;
+        string lines;
+        string complementLines;
+        bool allZeros = true;
+        bool allOnes = true;
+        for (TruthTableUInt i = 0; i < (numLines + 63) / 64; ++i) {
+            const uint64_t mask = numLines >= 64 ? ~((uint64_t) 0) : (((uint64_t) 1) << numLines) - 1;
+            const uint64_t word = numLines >= 64 ? table[offset / 64 + i] : (table[offset / 64] >> (offset % 64)) & mask;
+            const uint64_t complementWord = ~word & mask;
+            allZeros = allZeros && word == 0;
+            allOnes = allOnes && complementWord == 0;
+            lines.append((const char *) &word, sizeof(word));
+            complementLines.append((const char *) &complementWord, sizeof(complementWord));
+        }
+        if (allZeros) {
+            return ZERO;
+        } else if (allOnes) {
+            return ONE;
+        }
+
+        // Every cofactor of a variable has as many lines
+        lines.push_back((char) numVariables);
+        complementLines.push_back((char) numVariables);
+        const auto found = cofactors.find(lines);
+        if (found != cofactors.end()) {
+            return found->second;
+        }
+
+        const TruthTableUInt half = numLines / 2;
+        const GateInput variable = {numVariables - 1, false};
+        const GateInput low = expand(table, offset, numVariables - 1);
+        const GateInput high = expand(table, offset + half, numVariables - 1);
+        GateInput result;
+        if (high == low) {
+            result = low;
+        } else if (high == ~low) {
+            result = combine(GateType::Xor, variable, low);
+        } else if (high.isConstant()) {
+            result = high == ONE ? combine(GateType::Or, variable, low) : combine(GateType::And, ~variable, low);
+        } else if (low.isConstant()) {
+            result = low == ZERO ? combine(GateType::And, variable, high) : combine(GateType::Or, ~variable, high);
+        } else if (implies(table, offset, offset + half, numVariables - 1)) {
+            result = combine(GateType::Or, low, combine(GateType::And, variable, high));
+        } else if (implies(table, offset + half, offset, numVariables - 1)) {
+            result = combine(GateType::Or, high, combine(GateType::And, ~variable, low));
+        } else {
+            // The variable chooses the bits where the cofactors differ: low ^ (variable & (high ^ low))
+            result = combine(GateType::Xor, low, combine(GateType::And, variable, combine(GateType::Xor, high, low)));
+        }
+
+        cofactors[lines] = result;
+        cofactors[complementLines] = ~result;
+        return result;
+    }
+
+    // If the lines [first, first + 2^numVariables) of the table are 1 only where the ones from second are
+    static bool implies(const uint64_t *table, const TruthTableUInt first, const TruthTableUInt second, const size_t numVariables) {
+        const TruthTableUInt numLines = ((TruthTableUInt) 1) << numVariables;
+        if (numLines < 64) {
+            const uint64_t mask = (((uint64_t) 1) << numLines) - 1;
+            return ((table[first / 64] >> (first % 64)) & ~(table[second / 64] >> (second % 64)) & mask) == 0;
+        }
+
+        for (TruthTableUInt i = 0; i < numLines / 64; ++i) {
+            if ((table[first / 64 + i] & ~table[second / 64 + i]) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The output of a gate of the type, folding the constants, and sharing the gates of the same inputs
+    GateInput combine(const GateType type, GateInput first, GateInput second) {
+        if (type == GateType::Xor) {
+            // A complemented input complements the output
+            const bool complemented = first.complemented != second.complemented;
+            first.complemented = false;
+            second.complemented = false;
+            if (first.isConstant() || second.isConstant() || first == second) {
+                const GateInput output = first.isConstant() ? second : (second.isConstant() ? first : ZERO);
+                return complemented ? ~output : output;
+            }
+            const GateInput output = addGate(type, first, second);
+            return complemented ? ~output : output;
+        }
+
+        // And and Or are the same, with the roles of 0 and 1 swapped
+        const GateInput absorbing = type == GateType::And ? ZERO : ONE;
+        if (first == absorbing || second == absorbing || first == ~second) {
+            return absorbing;
+        } else if (first.isConstant() || first == second) {
+            return second;
+        } else if (second.isConstant()) {
+            return first;
+        }
+        return addGate(type, first, second);
+    }
+
+    GateInput addGate(const GateType type, const GateInput first, const GateInput second) {
+        stringstream key;
+        key << (int) type << " " << min(first.gate, second.gate) << (first.gate < second.gate ? first.complemented : second.complemented)
+            << " " << max(first.gate, second.gate) << (first.gate < second.gate ? second.complemented : first.complemented);
+        const auto found = sharedGates.find(key.str());
+        if (found != sharedGates.end()) {
+            return found->second;
+        }
+
+        gates.push_back(Gate{type, 0, first, second});
+        const GateInput output = {gates.size() - 1, false};
+        sharedGates[key.str()] = output;
+        return output;
+    }
+};
+
+// The name, suffixed with '_' until it's not a C keyword, or any of the taken names. The result is taken.
+static string getUniqueName(string name, unordered_set<string> &taken) {
+    while (C_KEYWORDS.find(name) != C_KEYWORDS.end() || taken.find(name) != taken.end()) {
+        name += "_";
+    }
+    taken.insert(name);
+    return name;
+}
+
+// Writes the gates of the network as statements assigning to temporaries, and returns the network's output
+static string writeGates(const GateNetwork &network, const vector<string> &variables, const string &temporaryPrefix,
+                         const bool bitSliced, ostream &out) {
+    const string type = bitSliced ? "uint64_t" : "bool";
+    const string complement = bitSliced ? "~" : "!";
+    vector<string> names;
+    auto getInput = [&](const GateInput &input) -> string {
+        if (input.isConstant()) {
+            return input.complemented ? (bitSliced ? "~(uint64_t) 0" : "1") : "0";
+        }
+        return (input.complemented ? complement : "") + names[input.gate];
+    };
+
+    // The variables that the function doesn't depend on are still parameters
+    vector<bool> used(network.getGates().size(), false);
+    for (const Gate &gate : network.getGates()) {
+        for (const GateInput &input : { gate.first, gate.second }) {
+            if (gate.type != GateType::Variable && !input.isConstant()) {
+                used[input.gate] = true;
+            }
+        }
+    }
+    if (!network.getOutput().isConstant()) {
+        used[network.getOutput().gate] = true;
+    }
+    for (size_t i = 0; i < variables.size(); ++i) {
+        if (!used[i]) {
+            out << "    (void) " << variables[i] << ";" << endl;
+        }
+    }
+
+    size_t numTemporaries = 0;
+    for (const Gate &gate : network.getGates()) {
+        if (gate.type == GateType::Variable) {
+            names.push_back(variables[gate.variable]);
+            continue;
+        }
+
+        names.push_back(temporaryPrefix + to_string(numTemporaries++));
+        const string op = gate.type == GateType::And ? " & " : (gate.type == GateType::Or ? " | " : " ^ ");
+        out << "    const " << type << " " << names.back() << " = " << getInput(gate.first) << op << getInput(gate.second) << ";" << endl;
+    }
+    return getInput(network.getOutput());
+}
+
+// "<type> a, <type> b, ...", or "void"
+static string getParameters(const vector<string> &variables, const string &type) {
+    if (variables.empty()) {
+        return "void";
+    }
+
+    vector<string> parameters;
+    for (const string &variable : variables) {
+        parameters.push_back(type + " " + variable);
+    }
+    return join(parameters, ", ");
+}
+
+string generateC(const BooleanFunction &function, const string &name) {
+    const vector<string> originalVariables = function.hasTruthTable() ? function.getTruthTable().getVariables() : vector<string>();
+    unordered_set<string> taken;
+    const string functionName = getUniqueName(name, taken);
+    const string bitSlicedName = getUniqueName(functionName + "_64", taken);
+    const string tableName = getUniqueName(functionName + "_table", taken);
+    taken.insert("line");
+    vector<string> variables;
+    for (const string &variable : originalVariables) {
+        variables.push_back(getUniqueName(variable, taken));
+    }
+    // No variable may look like a temporary
+    string temporaryPrefix = "t";
+    while (any_of(variables.begin(), variables.end(), [&](const string &variable) { return variable.compare(0, temporaryPrefix.length(), temporaryPrefix) == 0; })) {
+        temporaryPrefix += "_";
+    }
+
+    const GateNetwork network(function);
+    // A lookup takes a shift and an or for every variable, and a shift and an and for the line's bit
+    const bool lookedUp = variables.size() <= MAX_LOOKUP_TABLE_VARIABLES && network.getNumOperations() > 2 * variables.size() + 2;
+
+    stringstream out;
+    out << "/* Generated by logic: a function of " << variables.size() << (variables.size() == 1 ? " variable" : " variables");
+    out << (lookedUp ? ", looked up in a packed truth table." : ", as bitwise operations.") << " */" << endl;
+    out << "#include <stdbool.h>" << endl << "#include <stdint.h>" << endl << endl;
+
+    if (lookedUp) {
+        const TruthTable &table = function.getTruthTable();
+        // Line i is the bit (i % 64) of the word (i / 64)
+        out << "static const uint64_t " << tableName << "[" << table.getNumWords() << "] = {";
+        for (TruthTableUInt i = 0; i < table.getNumWords(); ++i) {
+            out << (i == 0 ? "" : ",") << (i % 4 == 0 ? "\n    " : " ") << "UINT64_C(0x" << hex << setw(16) << setfill('0')
+                << table.getWords()[i] << dec << ")";
+        }
+        out << endl << "};" << endl << endl;
+
+        out << "static inline bool " << functionName << "(" << getParameters(variables, "bool") << ") {" << endl;
+        out << "    const uint64_t line = ";
+        for (size_t i = 0; i < variables.size(); ++i) {
+            out << (i == 0 ? "" : " | ") << "(uint64_t) " << variables[i] << (i == 0 ? "" : " << " + to_string(i));
+        }
+        out << ";" << endl << "    return (" << tableName << "[line / 64] >> (line % 64)) & 1;" << endl << "}" << endl;
+    } else {
+        out << "static inline bool " << functionName << "(" << getParameters(variables, "bool") << ") {" << endl;
+        const string output = writeGates(network, variables, temporaryPrefix, false, out);
+        out << "    return " << output << ";" << endl << "}" << endl;
+    }
+
+    out << endl << "/* The bit i of the result is the function's value at the bit i of the variables. */" << endl;
+    out << "static inline uint64_t " << bitSlicedName << "(" << getParameters(variables, "uint64_t") << ") {" << endl;
+    const string output = writeGates(network, variables, temporaryPrefix, true, out);
+    out << "    return " << output << ";" << endl << "}" << endl;
+    return out.str();
+}
+}
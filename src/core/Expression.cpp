@@ -0,0 +1,872 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <core/Expression.hpp>
+#include <core/ThreadPool.hpp>
+#include <core/Profiler.hpp>
+#include <core/Tracer.hpp>
+#include <core/Exceptions.hpp>
+#include <chrono>
+#include <core/Utils.hpp>
+#include <limits>
+#include <set>
+
+using namespace std;
+
+namespace Logic {
+static vector<string> getVariables(const BooleanFunction &function) {
+    return function.hasTruthTable() ? function.getTruthTable().getVariables() : vector<string>();
+}
+
+TruthTableUInt Expression::size() const {
+    if (variables.size() >= numeric_limits<TruthTableUInt>::digits) {
+        return numeric_limits<TruthTableUInt>::max();
+    }
+    return ((TruthTableUInt) 1) << variables.size();
+}
+
+// A saturated size stands for a table too big to count, so it saturates the bytes too
+static uint64_t getValuesMemoryUsage(const TruthTableUInt size) {
+    return size == numeric_limits<TruthTableUInt>::max() ? numeric_limits<uint64_t>::max() : TruthTable::getValuesMemoryUsage(size);
+}
+
+uint64_t Expression::getResultMemoryUsage() const {
+    return variables.empty() ? 0 : Logic::getValuesMemoryUsage(size());
+}
+
+uint64_t Expression::getBlockMemoryUsage(const TruthTableUInt blockSize) const {
+    return variables.empty() ? 0 : Logic::getValuesMemoryUsage(min(size(), blockSize));
+}
+
+chrono::nanoseconds Expression::estimateDuration(const TruthTableUInt work) {
+    // The single threaded throughput of the slowest operators, which gather or condition the tables a line at a time.
+    // Combining the tables with the same variable order, and negating them, is much faster, as it's done a word at a time.
+    static const chrono::nanoseconds::rep NANOSECONDS_PER_LINE = 25;
+    if (work > (TruthTableUInt) (numeric_limits<chrono::nanoseconds::rep>::max() / NANOSECONDS_PER_LINE)) {
+        return chrono::nanoseconds::max();
+    }
+    return chrono::nanoseconds((chrono::nanoseconds::rep) work * NANOSECONDS_PER_LINE);
+}
+
+// The function's value on the line with the given values of its variables
+static bool getValueAt(const BooleanFunction &function, const VariableAssignment &assignment) {
+    if (function.isConstant()) {
+        return function.getConstantValue();
+    }
+
+    const vector<string> &variables = function.getTruthTable().getVariables();
+    TruthTableUInt line = 0;
+    for (TruthTableVariablesUInt i = 0; i < variables.size(); ++i) {
+        if (assignment.at(variables[i])) {
+            line |= ((TruthTableUInt) 1) << i;
+        }
+    }
+    return function.getTruthTable()[line];
+}
+
+// The variables of the blocks that findLine() evaluates: 256Ki lines, 32 KiB a table, which is as fast per line as a
+// whole evaluation, as the blocks of the nodes stay in the cache, while the first line is still found early
+static const TruthTableVariablesUInt BLOCK_VARIABLES = 18;
+
+// The lines of the blocks of a function with these variables
+static TruthTableUInt getBlockSize(const vector<string> &variables) {
+    return ((TruthTableUInt) 1) << min(variables.size(), (size_t) BLOCK_VARIABLES);
+}
+
+// The function's lines with the given values of its variables, as a function of the rest of them
+static BooleanFunction getBlock(const BooleanFunction &function, const VariableAssignment &values) {
+    if (function.isConstant()) {
+        return function;
+    }
+
+    vector<pair<string, bool>> conditions;
+    for (const string &variable : function.getTruthTable().getVariables()) {
+        const auto value = values.find(variable);
+        if (value != values.end()) {
+            conditions.emplace_back(variable, value->second);
+        }
+    }
+    return conditions.empty() ? function : Conditions(conditions)(function);
+}
+
+// The function's lines that are 1. The words of a big table are counted concurrently on the options' thread pool.
+static TruthTableUInt countOnes(const BooleanFunction &function, const EvaluationOptions &options) {
+    if (function.isConstant()) {
+        return function.getConstantValue() ? 1 : 0;
+    }
+
+    const TruthTable &table = function.getTruthTable();
+    if (options.threadPool == nullptr || table.size() < options.forkThreshold) {
+        return table.count();
+    }
+
+    const uint64_t *words = table.getWords();
+    const TruthTableUInt numWords = table.getNumWords();
+    const TruthTableUInt numParts = options.threadPool->size() + 1;
+    const TruthTableUInt partSize = (numWords + numParts - 1) / numParts;
+    auto countPart = [words, numWords, partSize](const TruthTableUInt part) -> TruthTableUInt {
+        TruthTableUInt count = 0;
+        for (TruthTableUInt i = part * partSize; i < min(numWords, (part + 1) * partSize); ++i) {
+            count += (TruthTableUInt) __builtin_popcountll(words[i]);
+        }
+        return count;
+    };
+
+    vector<unique_ptr<ForkedTask<TruthTableUInt>>> forked;
+    for (TruthTableUInt part = 1; part < numParts; ++part) {
+        forked.emplace_back(new ForkedTask<TruthTableUInt>(*options.threadPool, [countPart, part]() {
+            return countPart(part);
+        }));
+    }
+    TruthTableUInt count = countPart(0);
+    for (unique_ptr<ForkedTask<TruthTableUInt>> &part : forked) {
+        count += part->join();
+    }
+    return count;
+}
+
+FunctionExpression::FunctionExpression(const BooleanFunction &function)
+    : Expression(Logic::getVariables(function)), function(function) {
+}
+
+BooleanFunction FunctionExpression::evaluate(const EvaluationOptions &options) const {
+    UNUSED(options);
+    return function;
+}
+
+uint64_t FunctionExpression::estimatePeakMemoryUsage() const {
+    return getResultMemoryUsage();
+}
+
+TruthTableUInt FunctionExpression::estimateWork() const {
+    // Copying the function is negligible next to the operators
+    return 0;
+}
+
+TruthTableUInt FunctionExpression::estimateTotalWork() const {
+    return 0;
+}
+
+string FunctionExpression::getDescription() const {
+    if (function.isConstant()) {
+        return function.getConstantValue() ? "1" : "0";
+    }
+    return getVariables().size() == 1 ? getVariables().front() : "Function";
+}
+
+bool FunctionExpression::evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const {
+    UNUSED(options);
+    return getValueAt(function, assignment);
+}
+
+uint64_t FunctionExpression::estimatePointPeakMemoryUsage() const {
+    return 0;
+}
+
+TruthTableUInt FunctionExpression::estimatePointWork() const {
+    return 1;
+}
+
+TruthTableUInt FunctionExpression::count(const EvaluationOptions &options) const {
+    return countOnes(function, options);
+}
+
+uint64_t FunctionExpression::estimateCountPeakMemoryUsage() const {
+    // Counted in place
+    return 0;
+}
+
+BooleanFunction FunctionExpression::evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const {
+    UNUSED(options);
+    return getBlock(function, values);
+}
+
+uint64_t FunctionExpression::estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const {
+    // The conditioned lines are collected before the block's table is built
+    return saturatingAdd(getBlockMemoryUsage(blockSize), getBlockMemoryUsage(blockSize));
+}
+
+FunctionReferenceExpression::FunctionReferenceExpression(const string &name, const BooleanFunction &function)
+    : Expression(Logic::getVariables(function)), name(name), function(function) {
+}
+
+BooleanFunction FunctionReferenceExpression::evaluate(const EvaluationOptions &options) const {
+    UNUSED(options);
+    return function;
+}
+
+uint64_t FunctionReferenceExpression::estimatePeakMemoryUsage() const {
+    return getResultMemoryUsage();
+}
+
+TruthTableUInt FunctionReferenceExpression::estimateWork() const {
+    return 0;
+}
+
+TruthTableUInt FunctionReferenceExpression::estimateTotalWork() const {
+    return 0;
+}
+
+string FunctionReferenceExpression::getDescription() const {
+    return "$" + name;
+}
+
+bool FunctionReferenceExpression::evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const {
+    UNUSED(options);
+    return getValueAt(function, assignment);
+}
+
+uint64_t FunctionReferenceExpression::estimatePointPeakMemoryUsage() const {
+    return 0;
+}
+
+TruthTableUInt FunctionReferenceExpression::estimatePointWork() const {
+    return 1;
+}
+
+TruthTableUInt FunctionReferenceExpression::count(const EvaluationOptions &options) const {
+    return countOnes(function, options);
+}
+
+uint64_t FunctionReferenceExpression::estimateCountPeakMemoryUsage() const {
+    // Counted in place
+    return 0;
+}
+
+BooleanFunction FunctionReferenceExpression::evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const {
+    UNUSED(options);
+    return getBlock(function, values);
+}
+
+uint64_t FunctionReferenceExpression::estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const {
+    // The conditioned lines are collected before the block's table is built
+    return saturatingAdd(getBlockMemoryUsage(blockSize), getBlockMemoryUsage(blockSize));
+}
+
+static uint64_t getRows(const BooleanFunction &function) {
+    return function.hasTruthTable() ? function.getTruthTable().size() : 1;
+}
+
+static uint64_t getResultBytes(const BooleanFunction &function) {
+    return function.hasTruthTable() ? (function.getTruthTable().size() + 7) / 8 : 0;
+}
+
+// Applies the operator, and records it in the profiler and the tracer, if any
+template <typename TOperator, typename TApply>
+static BooleanFunction apply(const EvaluationOptions &options, const TOperator &_operator, const uint64_t operandRows, TApply apply) {
+    if (options.profiler == nullptr && options.tracer == nullptr) {
+        return apply();
+    }
+
+    const string name = _operator.getName();
+    TraceSpan span(options.tracer, name, "operator");
+    unique_ptr<ProfileMeasurement> measurement(options.profiler == nullptr ? nullptr : new ProfileMeasurement(*options.profiler));
+    BooleanFunction result = apply();
+    if (measurement) {
+        options.profiler->recordOperator(name, *measurement, operandRows + getRows(result), getResultBytes(result));
+    }
+    span.addArgument("operand_rows", operandRows);
+    span.addArgument("result_rows", getRows(result));
+    return result;
+}
+
+UnaryOperatorExpression::UnaryOperatorExpression(unique_ptr<UnaryOperator> _operator, unique_ptr<Expression> operand)
+    : Expression(_operator->getResultVariables(operand->getVariables())), _operator(move(_operator)), operand(move(operand)) {
+    // The evaluations that decide the result early may never apply the operator, so it's checked here instead
+    this->_operator->validate(this->operand->getVariables());
+}
+
+bool UnaryOperatorExpression::isPointEvaluated() const {
+    // Unless reading the operand's lines one at a time is more work than evaluating its table
+    return getVariables().empty() && !operand->getVariables().empty() && _operator->canEvaluateAt() &&
+           estimatePointWork() <= saturatingAdd(operand->estimateTotalWork(), operand->size());
+}
+
+BooleanFunction UnaryOperatorExpression::evaluate(const EvaluationOptions &options) const {
+    if (isPointEvaluated()) {
+        return apply(options, *_operator, 1, [&]() { return BooleanFunction(evaluateAt(VariableAssignment(), options)); });
+    }
+
+    const BooleanFunction in = operand->evaluate(options);
+    return apply(options, *_operator, getRows(in), [&]() { return (*_operator)(in); });
+}
+
+uint64_t UnaryOperatorExpression::estimatePeakMemoryUsage() const {
+    if (isPointEvaluated()) {
+        return operand->estimatePointPeakMemoryUsage();
+    }
+
+    // The operand is held while the operator allocates its scratch space and the result
+    const uint64_t scratch = Logic::getValuesMemoryUsage(_operator->estimateScratchSize(operand->getVariables()));
+    const uint64_t applying = saturatingAdd(saturatingAdd(operand->getResultMemoryUsage(), scratch), getResultMemoryUsage());
+    return max(operand->estimatePeakMemoryUsage(), applying);
+}
+
+void UnaryOperatorExpression::release(unique_ptr<UnaryOperator> &_operator, unique_ptr<Expression> &operand) {
+    _operator = move(this->_operator);
+    operand = move(this->operand);
+}
+
+TruthTableUInt UnaryOperatorExpression::estimateWork() const {
+    if (isPointEvaluated()) {
+        return 1;
+    }
+    return saturatingAdd(saturatingAdd(operand->size(), _operator->estimateScratchSize(operand->getVariables())), size());
+}
+
+TruthTableUInt UnaryOperatorExpression::estimateTotalWork() const {
+    if (isPointEvaluated()) {
+        return estimatePointWork();
+    }
+    return saturatingAdd(operand->estimateTotalWork(), estimateWork());
+}
+
+string UnaryOperatorExpression::getDescription() const {
+    return _operator->getDescription();
+}
+
+bool UnaryOperatorExpression::evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const {
+    if (!_operator->canEvaluateAt()) {
+        return getValueAt(evaluate(options), assignment);
+    }
+    return _operator->evaluateAt(assignment, operand->getVariables(), [&](const VariableAssignment &operandAssignment) {
+        return operand->evaluateAt(operandAssignment, options);
+    });
+}
+
+uint64_t UnaryOperatorExpression::estimatePointPeakMemoryUsage() const {
+    return _operator->canEvaluateAt() ? operand->estimatePointPeakMemoryUsage() : estimatePeakMemoryUsage();
+}
+
+TruthTableUInt UnaryOperatorExpression::estimatePointWork() const {
+    if (!_operator->canEvaluateAt()) {
+        return estimateTotalWork();
+    }
+    const TruthTableUInt reads = _operator->estimatePointReads(operand->getVariables());
+    return saturatingAdd(saturatingMultiply(operand->estimatePointWork(), reads), 1);
+}
+
+bool UnaryOperatorExpression::isCountedFromOperand() const {
+    return !isPointEvaluated() && _operator->canCount() && getVariables().size() < (size_t) numeric_limits<TruthTableUInt>::digits;
+}
+
+TruthTableUInt UnaryOperatorExpression::count(const EvaluationOptions &options) const {
+    if (!isCountedFromOperand()) {
+        return countOnes(evaluate(options), options);
+    }
+    return _operator->count(operand->count(options), operand->size());
+}
+
+uint64_t UnaryOperatorExpression::estimateCountPeakMemoryUsage() const {
+    return isCountedFromOperand() ? operand->estimateCountPeakMemoryUsage() : estimatePeakMemoryUsage();
+}
+
+BooleanFunction UnaryOperatorExpression::evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const {
+    if (!_operator->canEvaluateBlock()) {
+        return getBlock(evaluate(options), values);
+    }
+    return _operator->evaluateBlock(values, operand->getVariables(), [&](const VariableAssignment &operandValues) {
+        return operand->evaluateBlock(operandValues, options);
+    });
+}
+
+uint64_t UnaryOperatorExpression::estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const {
+    if (!_operator->canEvaluateBlock()) {
+        return saturatingAdd(estimatePeakMemoryUsage(), getBlockMemoryUsage(blockSize));
+    }
+    const uint64_t applying = saturatingAdd(operand->getBlockMemoryUsage(blockSize), getBlockMemoryUsage(blockSize));
+    return max(operand->estimateBlockPeakMemoryUsage(blockSize), applying);
+}
+
+BinaryOperatorExpression::BinaryOperatorExpression(unique_ptr<BinaryOperator> _operator, unique_ptr<Expression> first, unique_ptr<Expression> second)
+    : Expression(_operator->getResultVariables(first->getVariables(), second->getVariables())),
+      _operator(move(_operator)), first(move(first)), second(move(second)) {
+}
+
+bool BinaryOperatorExpression::isEquality() const {
+    return dynamic_cast<const Equals *>(_operator.get()) != nullptr;
+}
+
+uint64_t BinaryOperatorExpression::estimatePeakMemoryUsage() const {
+    if (isEquality()) {
+        return estimateEqualsPeakMemoryUsage(*first, *second);
+    }
+
+    // The first operand's result is held while the second one is evaluated. A forked evaluation may overlap both the
+    // operands' peaks, so that's assumed, as an upper bound.
+    const uint64_t operands = saturatingAdd(first->estimatePeakMemoryUsage(), second->estimatePeakMemoryUsage());
+    const uint64_t scratch = Logic::getValuesMemoryUsage(_operator->estimateScratchSize(first->getVariables(), second->getVariables()));
+    const uint64_t applying = saturatingAdd(saturatingAdd(saturatingAdd(first->getResultMemoryUsage(), second->getResultMemoryUsage()), scratch), getResultMemoryUsage());
+    return max(operands, applying);
+}
+
+void BinaryOperatorExpression::release(unique_ptr<BinaryOperator> &_operator, unique_ptr<Expression> &first, unique_ptr<Expression> &second) {
+    _operator = move(this->_operator);
+    first = move(this->first);
+    second = move(this->second);
+}
+
+TruthTableUInt BinaryOperatorExpression::estimateWork() const {
+    const TruthTableUInt operands = saturatingAdd(first->size(), second->size());
+    return saturatingAdd(saturatingAdd(operands, _operator->estimateScratchSize(first->getVariables(), second->getVariables())), size());
+}
+
+TruthTableUInt BinaryOperatorExpression::estimateTotalWork() const {
+    return saturatingAdd(saturatingAdd(first->estimateTotalWork(), second->estimateTotalWork()), estimateWork());
+}
+
+string BinaryOperatorExpression::getDescription() const {
+    return _operator->getDescription();
+}
+
+bool BinaryOperatorExpression::evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const {
+    if (!_operator->canEvaluateAt()) {
+        return getValueAt(evaluate(options), assignment);
+    }
+    return _operator->evaluateAt(assignment,
+                                 [&](const VariableAssignment &firstAssignment) { return first->evaluateAt(firstAssignment, options); },
+                                 [&](const VariableAssignment &secondAssignment) { return second->evaluateAt(secondAssignment, options); });
+}
+
+uint64_t BinaryOperatorExpression::estimatePointPeakMemoryUsage() const {
+    if (!_operator->canEvaluateAt()) {
+        return estimatePeakMemoryUsage();
+    }
+    return max(first->estimatePointPeakMemoryUsage(), second->estimatePointPeakMemoryUsage());
+}
+
+TruthTableUInt BinaryOperatorExpression::estimatePointWork() const {
+    if (!_operator->canEvaluateAt()) {
+        return estimateTotalWork();
+    }
+    return saturatingAdd(saturatingAdd(first->estimatePointWork(), second->estimatePointWork()), 1);
+}
+
+// Only if every line of the result is a pair of lines of the operands, as their variables are all different
+bool BinaryOperatorExpression::isCountedFromOperands() const {
+    return _operator->canCount() && getVariables().size() < (size_t) numeric_limits<TruthTableUInt>::digits &&
+           first->getVariables().size() + second->getVariables().size() == getVariables().size();
+}
+
+TruthTableUInt BinaryOperatorExpression::count(const EvaluationOptions &options) const {
+    if (!isCountedFromOperands()) {
+        return countOnes(evaluate(options), options);
+    }
+    return _operator->count(first->count(options), first->size(), second->count(options), second->size());
+}
+
+uint64_t BinaryOperatorExpression::estimateCountPeakMemoryUsage() const {
+    if (!isCountedFromOperands()) {
+        return estimatePeakMemoryUsage();
+    }
+    return max(first->estimateCountPeakMemoryUsage(), second->estimateCountPeakMemoryUsage());
+}
+
+BooleanFunction BinaryOperatorExpression::evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const {
+    if (!_operator->canEvaluateBlock()) {
+        return getBlock(evaluate(options), values);
+    }
+    return _operator->evaluateBlock(values, [&](const VariableAssignment &firstValues) {
+        return first->evaluateBlock(firstValues, options);
+    }, [&](const VariableAssignment &secondValues) {
+        return second->evaluateBlock(secondValues, options);
+    });
+}
+
+uint64_t BinaryOperatorExpression::estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const {
+    if (!_operator->canEvaluateBlock()) {
+        return saturatingAdd(estimatePeakMemoryUsage(), getBlockMemoryUsage(blockSize));
+    }
+    // Same as estimatePeakMemoryUsage(), on the blocks
+    const uint64_t operands = saturatingAdd(first->estimateBlockPeakMemoryUsage(blockSize), second->estimateBlockPeakMemoryUsage(blockSize));
+    const uint64_t applying = saturatingAdd(saturatingAdd(first->getBlockMemoryUsage(blockSize), second->getBlockMemoryUsage(blockSize)),
+                                            getBlockMemoryUsage(blockSize));
+    return max(operands, applying);
+}
+
+BooleanFunction BinaryOperatorExpression::evaluate(const EvaluationOptions &options) const {
+    if (isEquality()) {
+        // Compared a block at a time, up to the first one where they differ, instead of evaluating both whole
+        return apply(options, *_operator, 0, [&]() { return BooleanFunction(equals(*first, *second, nullptr, options)); });
+    }
+
+    // Forking only pays off if both the operands need some real work, and the result is big enough
+    const bool fork = options.threadPool != nullptr &&
+                      !first->isLeaf() &&
+                      !second->isLeaf() &&
+                      size() >= options.forkThreshold;
+    if (!fork) {
+        const BooleanFunction firstResult = first->evaluate(options);
+        const BooleanFunction secondResult = second->evaluate(options);
+        return apply(options, *_operator, getRows(firstResult) + getRows(secondResult), [&]() { return (*_operator)(firstResult, secondResult); });
+    }
+
+    // The forked operand's operators count towards the same statement, whichever thread evaluates it
+    ProfileCounters *counters = Profiler::getCurrentCounters();
+    ForkedTask<BooleanFunction> firstResult(*options.threadPool, [&, counters]() {
+        ScopedProfileCounters scope(counters);
+        return first->evaluate(options);
+    });
+    unique_ptr<BooleanFunction> secondResult;
+    try {
+        secondResult.reset(new BooleanFunction(second->evaluate(options)));
+    } catch (...) {
+        // The first operand's error takes precedence, as it would in a sequential evaluation
+        firstResult.join();
+        throw;
+    }
+    const BooleanFunction joined = firstResult.join();
+    return apply(options, *_operator, getRows(joined) + getRows(*secondResult), [&]() { return (*_operator)(joined, *secondResult); });
+}
+
+static vector<vector<string>> getOperandsVariables(const vector<unique_ptr<Expression>> &operands) {
+    vector<vector<string>> variables;
+    for (const unique_ptr<Expression> &operand : operands) {
+        variables.push_back(operand->getVariables());
+    }
+    return variables;
+}
+
+FusedOperatorExpression::FusedOperatorExpression(FusedOperation operation, vector<unique_ptr<Expression>> operands)
+    : Expression(FusedOperation::getResultVariables(getOperandsVariables(operands))), operation(move(operation)), operands(move(operands)) {
+}
+
+uint64_t FusedOperatorExpression::estimatePeakMemoryUsage() const {
+    // Like BinaryOperatorExpression, the forked operands' peaks are assumed to overlap
+    uint64_t peaks = 0;
+    uint64_t results = getResultMemoryUsage();
+    for (const unique_ptr<Expression> &operand : operands) {
+        peaks = saturatingAdd(peaks, operand->estimatePeakMemoryUsage());
+        results = saturatingAdd(results, operand->getResultMemoryUsage());
+    }
+    return max(peaks, results);
+}
+
+TruthTableUInt FusedOperatorExpression::estimateWork() const {
+    TruthTableUInt work = size();
+    for (const unique_ptr<Expression> &operand : operands) {
+        work = saturatingAdd(work, operand->size());
+    }
+    return work;
+}
+
+TruthTableUInt FusedOperatorExpression::estimateTotalWork() const {
+    TruthTableUInt work = estimateWork();
+    for (const unique_ptr<Expression> &operand : operands) {
+        work = saturatingAdd(work, operand->estimateTotalWork());
+    }
+    return work;
+}
+
+string FusedOperatorExpression::getDescription() const {
+    return operation.getDescription();
+}
+
+bool FusedOperatorExpression::evaluateAt(const VariableAssignment &assignment, const EvaluationOptions &options) const {
+    return operation.evaluateAt([&](const size_t operand) { return operands[operand]->evaluateAt(assignment, options); });
+}
+
+uint64_t FusedOperatorExpression::estimatePointPeakMemoryUsage() const {
+    uint64_t peak = 0;
+    for (const unique_ptr<Expression> &operand : operands) {
+        peak = max(peak, operand->estimatePointPeakMemoryUsage());
+    }
+    return peak;
+}
+
+TruthTableUInt FusedOperatorExpression::estimatePointWork() const {
+    TruthTableUInt work = operation.getNumOperators();
+    for (const unique_ptr<Expression> &operand : operands) {
+        work = saturatingAdd(work, operand->estimatePointWork());
+    }
+    return work;
+}
+
+// See BinaryOperatorExpression::isCountedFromOperands()
+bool FusedOperatorExpression::isCountedFromOperands() const {
+    size_t numVariables = 0;
+    for (const unique_ptr<Expression> &operand : operands) {
+        numVariables += operand->getVariables().size();
+    }
+    return getVariables().size() < (size_t) numeric_limits<TruthTableUInt>::digits && numVariables == getVariables().size();
+}
+
+TruthTableUInt FusedOperatorExpression::count(const EvaluationOptions &options) const {
+    if (!isCountedFromOperands()) {
+        return countOnes(evaluate(options), options);
+    }
+    return operation.count([&](const size_t operand) {
+        return make_pair(operands[operand]->count(options), operands[operand]->size());
+    });
+}
+
+uint64_t FusedOperatorExpression::estimateCountPeakMemoryUsage() const {
+    if (!isCountedFromOperands()) {
+        return estimatePeakMemoryUsage();
+    }
+
+    uint64_t peak = 0;
+    for (const unique_ptr<Expression> &operand : operands) {
+        peak = max(peak, operand->estimateCountPeakMemoryUsage());
+    }
+    return peak;
+}
+
+BooleanFunction FusedOperatorExpression::evaluateBlock(const VariableAssignment &values, const EvaluationOptions &options) const {
+    vector<BooleanFunction> blocks;
+    vector<const BooleanFunction *> arguments;
+    blocks.reserve(operands.size());
+    for (const unique_ptr<Expression> &operand : operands) {
+        blocks.push_back(operand->evaluateBlock(values, options));
+    }
+    for (const BooleanFunction &block : blocks) {
+        arguments.push_back(&block);
+    }
+    return operation(arguments);
+}
+
+uint64_t FusedOperatorExpression::estimateBlockPeakMemoryUsage(const TruthTableUInt blockSize) const {
+    // Same as estimatePeakMemoryUsage(), on the blocks
+    uint64_t peaks = 0;
+    uint64_t blocks = getBlockMemoryUsage(blockSize);
+    for (const unique_ptr<Expression> &operand : operands) {
+        peaks = saturatingAdd(peaks, operand->estimateBlockPeakMemoryUsage(blockSize));
+        blocks = saturatingAdd(blocks, operand->getBlockMemoryUsage(blockSize));
+    }
+    return max(peaks, blocks);
+}
+
+BooleanFunction FusedOperatorExpression::evaluate(const EvaluationOptions &options) const {
+    // Same as BinaryOperatorExpression, but every operand that needs some real work is forked, except the last one,
+    // which is evaluated on this thread
+    const bool fork = options.threadPool != nullptr && size() >= options.forkThreshold;
+    size_t lastToEvaluate = operands.size();
+    for (size_t i = 0; i < operands.size(); ++i) {
+        if (!operands[i]->isLeaf()) {
+            lastToEvaluate = i;
+        }
+    }
+
+    ProfileCounters *counters = Profiler::getCurrentCounters();
+    vector<unique_ptr<ForkedTask<BooleanFunction>>> forked(operands.size());
+    for (size_t i = 0; fork && i < operands.size(); ++i) {
+        if (!operands[i]->isLeaf() && i != lastToEvaluate) {
+            const Expression &operand = *operands[i];
+            forked[i].reset(new ForkedTask<BooleanFunction>(*options.threadPool, [&operand, &options, counters]() {
+                ScopedProfileCounters scope(counters);
+                return operand.evaluate(options);
+            }));
+        }
+    }
+
+    // Collected in order, so the first operand's error takes precedence, as it would in a sequential evaluation. The
+    // forked tasks that are left are waited for when they're destroyed.
+    vector<BooleanFunction> results;
+    vector<const BooleanFunction *> arguments;
+    uint64_t operandRows = 0;
+    results.reserve(operands.size());
+    for (size_t i = 0; i < operands.size(); ++i) {
+        results.push_back(forked[i] ? forked[i]->join() : operands[i]->evaluate(options));
+        operandRows += getRows(results.back());
+    }
+    for (const BooleanFunction &result : results) {
+        arguments.push_back(&result);
+    }
+    return apply(options, operation, operandRows, [&]() { return operation(arguments); });
+}
+
+bool evaluate(const Expression &expression, const VariableAssignment &assignment, const EvaluationOptions &options) {
+    for (const string &variable : expression.getVariables()) {
+        if (assignment.find(variable) == assignment.end()) {
+            throw invalid_argument("No value for the variable " + variable);
+        }
+    }
+    return expression.evaluateAt(assignment, options);
+}
+
+TruthTableUInt count(const Expression &expression, const EvaluationOptions &options) {
+    const uint64_t estimate = expression.estimateCountPeakMemoryUsage();
+    if (estimate > options.memoryBudget) {
+        throw MemoryLimitExceededException("Counting the lines of this function needs about " + formatBytes(estimate) +
+                                           " of memory, but only " + formatBytes(options.memoryBudget) + " is available.");
+    }
+    return expression.count(options);
+}
+
+// Sets line to the values on the block's first line with the value, if any. The values of the block's variables are
+// the bits of the line's index, and the others, the values that selected the block.
+static bool findLineInBlock(const BooleanFunction &block, const bool value, const vector<string> &variables,
+                            const VariableAssignment &values, VariableAssignment &line) {
+    TruthTableUInt index = 0;
+    if (block.isConstant()) {
+        if (block.getConstantValue() != value) {
+            return false;
+        }
+    } else {
+        const TruthTable &table = block.getTruthTable();
+        const uint64_t *words = table.getWords();
+        const uint64_t lastWordMask = table.size() < 64 ? (((uint64_t) 1) << table.size()) - 1 : ~(uint64_t) 0;
+        TruthTableUInt i = 0;
+        uint64_t word = 0;
+        for (; i < table.getNumWords(); ++i) {
+            word = (value ? words[i] : ~words[i]) & (i + 1 == table.getNumWords() ? lastWordMask : ~(uint64_t) 0);
+            if (word != 0) {
+                break;
+            }
+        }
+        if (word == 0) {
+            return false;
+        }
+        index = i * 64 + (TruthTableUInt) __builtin_ctzll(word);
+    }
+
+    line.clear();
+    for (const string &variable : variables) {
+        const auto fixed = values.find(variable);
+        line[variable] = fixed != values.end() && fixed->second;
+    }
+    if (!block.isConstant()) {
+        const vector<string> &blockVariables = block.getTruthTable().getVariables();
+        for (TruthTableVariablesUInt i = 0; i < blockVariables.size(); ++i) {
+            line[blockVariables[i]] = TruthTable::getVariableValueInLine(i, index);
+        }
+    }
+    return true;
+}
+
+// Looks for the first line with the value, over the blocks of the lines of a function with the variables, which
+// evaluateBlock returns given the values of the variables that select them, with the work of evaluating all of them.
+// See findLine().
+static bool findLineInBlocks(const vector<string> &variables, const uint64_t blockPeakMemoryUsage, const TruthTableUInt work,
+                             const EvaluationOptions &options,
+                             const function<BooleanFunction (const VariableAssignment &)> &evaluateBlock, const bool value,
+                             VariableAssignment &line) {
+    if (blockPeakMemoryUsage > options.memoryBudget) {
+        throw MemoryLimitExceededException("Evaluating this function a block of lines at a time needs about " + formatBytes(blockPeakMemoryUsage) +
+                                           " of memory, but only " + formatBytes(options.memoryBudget) + " is available.");
+    }
+
+    // The highest variables select the block, so the blocks are in the order of the lines. Beyond 2^64 blocks, the
+    // ones left would never be reached anyway.
+    const size_t blockVariables = min(variables.size(), (size_t) BLOCK_VARIABLES);
+    const size_t numSelecting = variables.size() - blockVariables;
+    const TruthTableUInt numBlocks = numSelecting >= (size_t) numeric_limits<TruthTableUInt>::digits ?
+                                     numeric_limits<TruthTableUInt>::max() : ((TruthTableUInt) 1) << numSelecting;
+    auto getValues = [&](const TruthTableUInt block) {
+        VariableAssignment values;
+        for (size_t i = 0; i < numSelecting; ++i) {
+            values[variables[blockVariables + i]] = i < (size_t) numeric_limits<TruthTableUInt>::digits && ((block >> i) & 1) != 0;
+        }
+        return values;
+    };
+
+    // Like parsing, the scan fails if it might take too long, but only once it's done as much as it may, since a line
+    // with the value is often found early
+    const TruthTableUInt blockWork = max((TruthTableUInt) 1, work / numBlocks + (work % numBlocks != 0 ? 1 : 0));
+    const TruthTableUInt maxBlocks = min(numBlocks, max((TruthTableUInt) 1, options.workBudget / blockWork));
+
+    // With a thread pool, a round of blocks is evaluated at once, as many as fit in the memory budget
+    TruthTableUInt roundSize = 1;
+    if (options.threadPool != nullptr && numBlocks > 1) {
+        roundSize = min((TruthTableUInt) options.threadPool->size() + 1, numBlocks);
+        if (blockPeakMemoryUsage != 0) {
+            roundSize = max((TruthTableUInt) 1, min(roundSize, options.memoryBudget / blockPeakMemoryUsage));
+        }
+    }
+
+    ProfileCounters *counters = Profiler::getCurrentCounters();
+    for (TruthTableUInt first = 0; first < maxBlocks; first += min(roundSize, maxBlocks - first)) {
+        const TruthTableUInt size = min(roundSize, maxBlocks - first);
+        vector<VariableAssignment> values;
+        for (TruthTableUInt i = 0; i < size; ++i) {
+            values.push_back(getValues(first + i));
+        }
+
+        // Checked in order, so the first line is found, and the first block's error takes precedence. The forked tasks
+        // that are left are waited for when they're destroyed.
+        vector<unique_ptr<ForkedTask<BooleanFunction>>> forked;
+        for (TruthTableUInt i = 1; i < size; ++i) {
+            const VariableAssignment &blockValues = values[i];
+            forked.emplace_back(new ForkedTask<BooleanFunction>(*options.threadPool, [&evaluateBlock, &blockValues, counters]() {
+                ScopedProfileCounters scope(counters);
+                return evaluateBlock(blockValues);
+            }));
+        }
+        if (findLineInBlock(evaluateBlock(values[0]), value, variables, values[0], line)) {
+            return true;
+        }
+        for (TruthTableUInt i = 1; i < size; ++i) {
+            if (findLineInBlock(forked[i - 1]->join(), value, variables, values[i], line)) {
+                return true;
+            }
+        }
+    }
+    if (maxBlocks < numBlocks) {
+        throw WorkLimitExceededException("Evaluating this function a block of lines at a time may take about " +
+                                         formatDuration((uint64_t) Expression::estimateDuration(work).count()) +
+                                         ", but the first " + formatDuration((uint64_t) Expression::estimateDuration(options.workBudget).count()) +
+                                         " of it found no line with the value.");
+    }
+    return false;
+}
+
+bool findLine(const Expression &expression, const bool value, VariableAssignment &line, const EvaluationOptions &options) {
+    const uint64_t estimate = expression.estimateBlockPeakMemoryUsage(getBlockSize(expression.getVariables()));
+    return findLineInBlocks(expression.getVariables(), estimate, expression.estimateTotalWork(), options, [&](const VariableAssignment &values) {
+        return expression.evaluateBlock(values, options);
+    }, value, line);
+}
+
+bool isSatisfiable(const Expression &expression, VariableAssignment &witness, const EvaluationOptions &options) {
+    return findLine(expression, true, witness, options);
+}
+
+bool isTautology(const Expression &expression, VariableAssignment &counterexample, const EvaluationOptions &options) {
+    return !findLine(expression, false, counterexample, options);
+}
+
+bool equals(const Expression &first, const Expression &second, VariableAssignment *counterexample, const EvaluationOptions &options) {
+    // Same as the == operator of the functions, which never equals the functions of different variables. Neither is
+    // evaluated then, which is fine, as the errors that don't depend on the values are thrown when they're built.
+    const vector<string> &variables = first.getVariables();
+    if (set<string>(variables.begin(), variables.end()) != set<string>(second.getVariables().begin(), second.getVariables().end())) {
+        return false;
+    }
+
+    // The lines where they differ are the ones where their Xor is 1. Most blocks are usually equal, which is quicker to
+    // check, a word at a time.
+    const Xor difference;
+    VariableAssignment line;
+    const TruthTableUInt work = saturatingAdd(first.estimateTotalWork(), second.estimateTotalWork());
+    const bool differ = findLineInBlocks(variables, estimateEqualsPeakMemoryUsage(first, second), work, options, [&](const VariableAssignment &values) {
+        const BooleanFunction firstBlock = first.evaluateBlock(values, options);
+        const BooleanFunction secondBlock = second.evaluateBlock(values, options);
+        return firstBlock == secondBlock ? BooleanFunction(false) : difference(firstBlock, secondBlock);
+    }, true, line);
+    if (differ && counterexample != nullptr) {
+        *counterexample = line;
+    }
+    return !differ;
+}
+
+uint64_t estimateEqualsPeakMemoryUsage(const Expression &first, const Expression &second) {
+    // Both the blocks and their Xor are held at once
+    const TruthTableUInt blockSize = getBlockSize(first.getVariables());
+    const uint64_t blocks = saturatingAdd(first.estimateBlockPeakMemoryUsage(blockSize), second.estimateBlockPeakMemoryUsage(blockSize));
+    return saturatingAdd(blocks, first.getBlockMemoryUsage(blockSize));
+}
+}
@@ -0,0 +1,270 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <core/FusedOperation.hpp>
+#include <core/Utils.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Logic {
+/**
+ * Reads an operand's values for 64 consecutive lines of a combined table at a time. The operand's variables are
+ * columns of the combined table, so an operand's line is made of some of the bits of the combined table's line.
+ */
+class CombinedOperandReader {
+public:
+    CombinedOperandReader(const BooleanFunction &operand, const vector<string> &combinedVariables)
+        : operand(operand), lowLines(), numLowVariables(0), isLowContiguous(true), cachedHighIndex(0), hasCachedWord(false), cachedWord(0) {
+        if (operand.isConstant()) {
+            cachedWord = operand.getConstantValue() ? ~(uint64_t) 0 : 0;
+            hasCachedWord = true;
+            return;
+        }
+
+        const vector<string> &variables = operand.getTruthTable().getVariables();
+        for (TruthTableVariablesUInt i = 0; i < variables.size(); ++i) {
+            const TruthTableVariablesUInt column = (TruthTableVariablesUInt) (find(combinedVariables.begin(), combinedVariables.end(), variables[i]) - combinedVariables.begin());
+            if (column < 6) {
+                // Varies within a word of the combined table
+                isLowContiguous = isLowContiguous && column == i;
+                ++numLowVariables;
+                for (unsigned line = 0; line < 64; ++line) {
+                    lowLines[line] |= (TruthTableUInt) ((line >> column) & 1) << i;
+                }
+            } else {
+                highColumns.push_back(make_pair(column, i));
+            }
+        }
+        // The low variables must also be the operand's lowest ones
+        for (const pair<TruthTableVariablesUInt, TruthTableVariablesUInt> &column : highColumns) {
+            isLowContiguous = isLowContiguous && column.second >= numLowVariables;
+        }
+    }
+
+    // The values for the combined table's lines [firstLine, firstLine + numLines). firstLine is a multiple of 64.
+    uint64_t read(const TruthTableUInt firstLine, const unsigned numLines) {
+        if (operand.isConstant()) {
+            return cachedWord;
+        }
+
+        TruthTableUInt highIndex = 0;
+        for (const pair<TruthTableVariablesUInt, TruthTableVariablesUInt> &column : highColumns) {
+            highIndex |= ((firstLine >> column.first) & 1) << column.second;
+        }
+        if (hasCachedWord && highIndex == cachedHighIndex) {
+            return cachedWord;
+        }
+
+        cachedHighIndex = highIndex;
+        hasCachedWord = true;
+        cachedWord = isLowContiguous ? readContiguous(highIndex) : gather(highIndex, numLines);
+        return cachedWord;
+    }
+
+private:
+    const BooleanFunction &operand;
+    // The operand's line index bits set by each line within a combined word
+    TruthTableUInt lowLines[64];
+    unsigned numLowVariables;
+    // Whether the low variables are the operand's first columns, in the same order as in the combined table
+    bool isLowContiguous;
+    // The (combined column, operand column) of the variables that only change across combined words
+    vector<pair<TruthTableVariablesUInt, TruthTableVariablesUInt>> highColumns;
+
+    TruthTableUInt cachedHighIndex;
+    bool hasCachedWord;
+    uint64_t cachedWord;
+
+    uint64_t readContiguous(const TruthTableUInt highIndex) const {
+        const uint64_t *words = operand.getTruthTable().getWords();
+        if (numLowVariables == 6) {
+            return words[highIndex / 64];
+        }
+
+        // A block of 2^numLowVariables lines, repeated over the word
+        const unsigned blockSize = 1u << numLowVariables;
+        uint64_t block = (words[highIndex / 64] >> (highIndex % 64)) & ((((uint64_t) 1) << blockSize) - 1);
+        for (unsigned size = blockSize; size < 64; size *= 2) {
+            block |= block << size;
+        }
+        return block;
+    }
+
+    uint64_t gather(const TruthTableUInt highIndex, const unsigned numLines) const {
+        const TruthTable &table = operand.getTruthTable();
+        uint64_t word = 0;
+        for (unsigned line = 0; line < numLines; ++line) {
+            if (table[highIndex | lowLines[line]]) {
+                word |= ((uint64_t) 1) << line;
+            }
+        }
+        return word;
+    }
+};
+
+FusedOperation::FusedOperation(const size_t operand)
+    : unaryOperator(nullptr), binaryOperator(nullptr), operand(operand) {
+}
+
+FusedOperation::FusedOperation(unique_ptr<BoolTransformationUnaryOperator> _operator, FusedOperation operand)
+    : ownedUnaryOperator(move(_operator)), unaryOperator(ownedUnaryOperator.get()), binaryOperator(nullptr), operand(0) {
+    operands.push_back(move(operand));
+}
+
+FusedOperation::FusedOperation(unique_ptr<CombinatoryBinaryOperator> _operator, vector<FusedOperation> operands)
+    : FusedOperation(*_operator, move(operands)) {
+    ownedBinaryOperator = move(_operator);
+}
+
+FusedOperation::FusedOperation(const CombinatoryBinaryOperator &_operator, vector<FusedOperation> operands)
+    : unaryOperator(nullptr), binaryOperator(&_operator), operand(0), operands(move(operands)) {
+    if (this->operands.empty()) {
+        throw invalid_argument("A fused operator needs at least one operand");
+    }
+}
+
+vector<string> FusedOperation::getResultVariables(const vector<vector<string>> &operands) {
+    // The unary operators keep the variables, and the binary ones append the new variables of the second operand
+    vector<string> variables;
+    for (const vector<string> &operand : operands) {
+        for (const string &variable : operand) {
+            if (!contains(variables, variable)) {
+                variables.push_back(variable);
+            }
+        }
+    }
+    return variables;
+}
+
+size_t FusedOperation::getNumOperators() const {
+    size_t count = isLeaf() ? 0 : 1;
+    for (const FusedOperation &operand : operands) {
+        count += operand.getNumOperators();
+    }
+    return count;
+}
+
+string FusedOperation::getName() const {
+    if (isLeaf()) {
+        return "_";
+    }
+
+    const string name = unaryOperator != nullptr ? unaryOperator->getName() : binaryOperator->getName();
+    if (all_of(operands.begin(), operands.end(), [](const FusedOperation &operand) { return operand.isLeaf(); })) {
+        return name;
+    }
+
+    vector<string> names;
+    for (const FusedOperation &operand : operands) {
+        names.push_back(operand.getName());
+    }
+    return name + "(" + join(names, ", ") + ")";
+}
+
+uint64_t FusedOperation::operateWords(vector<CombinedOperandReader> &readers, const TruthTableUInt firstLine, const unsigned numLines) const {
+    if (isLeaf()) {
+        return readers[operand].read(firstLine, numLines);
+    }
+
+    if (unaryOperator != nullptr) {
+        return unaryOperator->operateWord(operands.front().operateWords(readers, firstLine, numLines), numLines);
+    }
+
+    uint64_t word = operands.front().operateWords(readers, firstLine, numLines);
+    for (size_t i = 1; i < operands.size() && !binaryOperator->isAbsorbing(word); ++i) {
+        word = binaryOperator->operateWords(word, operands[i].operateWords(readers, firstLine, numLines), numLines);
+    }
+    return word;
+}
+
+// Same as operateWords(), on a single line. The operands are read as words of all 0s or all 1s, so that the absorbing
+// words are still found.
+uint64_t FusedOperation::operateLine(const function<bool (const size_t)> &operand) const {
+    if (isLeaf()) {
+        return operand(this->operand) ? ~(uint64_t) 0 : 0;
+    }
+
+    if (unaryOperator != nullptr) {
+        return unaryOperator->operateWord(operands.front().operateLine(operand), 1);
+    }
+
+    uint64_t word = operands.front().operateLine(operand);
+    for (size_t i = 1; i < operands.size() && !binaryOperator->isAbsorbing(word); ++i) {
+        word = binaryOperator->operateWords(word, operands[i].operateLine(operand), 1);
+    }
+    return word;
+}
+
+bool FusedOperation::evaluateAt(const function<bool (const size_t)> &operand) const {
+    return (operateLine(operand) & 1) == 1;
+}
+
+// The lines that are 1, and all the lines of the result
+pair<TruthTableUInt, TruthTableUInt> FusedOperation::countLines(const function<pair<TruthTableUInt, TruthTableUInt> (const size_t)> &operand) const {
+    if (isLeaf()) {
+        return operand(this->operand);
+    }
+
+    if (unaryOperator != nullptr) {
+        const pair<TruthTableUInt, TruthTableUInt> in = operands.front().countLines(operand);
+        return make_pair(unaryOperator->count(in.first, in.second), in.second);
+    }
+
+    pair<TruthTableUInt, TruthTableUInt> lines = operands.front().countLines(operand);
+    for (size_t i = 1; i < operands.size(); ++i) {
+        const pair<TruthTableUInt, TruthTableUInt> next = operands[i].countLines(operand);
+        lines = make_pair(binaryOperator->count(lines.first, lines.second, next.first, next.second), lines.second * next.second);
+    }
+    return lines;
+}
+
+TruthTableUInt FusedOperation::count(const function<pair<TruthTableUInt, TruthTableUInt> (const size_t)> &operand) const {
+    return countLines(operand).first;
+}
+
+BooleanFunction FusedOperation::operator()(const vector<const BooleanFunction *> &operands) const {
+    vector<vector<string>> operandsVariables;
+    for (const BooleanFunction *operand : operands) {
+        operandsVariables.push_back(operand->isConstant() ? vector<string>() : operand->getTruthTable().getVariables());
+    }
+
+    const vector<string> variables = getResultVariables(operandsVariables);
+    vector<CombinedOperandReader> readers;
+    readers.reserve(operands.size());
+    for (const BooleanFunction *operand : operands) {
+        readers.push_back(CombinedOperandReader(*operand, variables));
+    }
+
+    if (variables.empty()) {
+        // All the operands are constants, which read as words of all 0s or all 1s
+        return BooleanFunction((operateWords(readers, 0, 1) & 1) == 1);
+    }
+
+    TruthTable result(variables);
+    const unsigned numLines = result.size() < 64 ? (unsigned) result.size() : 64;
+    uint64_t *words = result.getWords();
+    for (TruthTableUInt i = 0; i < result.getNumWords(); ++i) {
+        words[i] = operateWords(readers, i * 64, numLines);
+    }
+    if (numLines < 64) {
+        words[0] &= (((uint64_t) 1) << numLines) - 1;
+    }
+
+    return BooleanFunction(result);
+}
+}
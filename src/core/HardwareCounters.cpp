@@ -0,0 +1,159 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <core/HardwareCounters.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Logic {
+bool HardwareCounterValues::any() const {
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        if (available[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HardwareCounterValues HardwareCounterValues::operator-(const HardwareCounterValues &rhs) const {
+    HardwareCounterValues difference;
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        difference.available[i] = available[i] && rhs.available[i];
+        difference.values[i] = difference.available[i] && values[i] > rhs.values[i] ? values[i] - rhs.values[i] : 0;
+    }
+    return difference;
+}
+
+HardwareCounterValues &HardwareCounterValues::operator+=(const HardwareCounterValues &rhs) {
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        values[i] += rhs.values[i];
+        available[i] = available[i] || rhs.available[i];
+    }
+    return *this;
+}
+
+HardwareCounters &HardwareCounters::forCurrentThread() {
+    static thread_local HardwareCounters counters;
+    return counters;
+}
+
+bool HardwareCounters::isAvailable() const {
+    return numOpened > 0;
+}
+
+#ifdef __linux__
+static int openCounter(const uint64_t config, const int groupLeader) {
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attributes.disabled = groupLeader == -1 ? 1 : 0;
+    // Unprivileged users can only count their own code
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    // This thread only, on any CPU
+    return (int) syscall(__NR_perf_event_open, &attributes, 0, -1, groupLeader, 0);
+}
+
+HardwareCounters::HardwareCounters() : leader(-1), numOpened(0) {
+    static const uint64_t configs[NUM_HARDWARE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        fds[i] = openCounter(configs[i], leader);
+        if (fds[i] == -1) {
+            if (error.empty()) {
+                error = string("perf_event_open failed: ") + strerror(errno);
+            }
+            continue;
+        }
+        if (leader == -1) {
+            leader = fds[i];
+        }
+        order[numOpened++] = i;
+    }
+
+    if (leader != -1) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+HardwareCounters::~HardwareCounters() {
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        if (fds[i] != -1) {
+            close(fds[i]);
+        }
+    }
+}
+
+HardwareCounterValues HardwareCounters::read() const {
+    HardwareCounterValues values;
+    if (leader == -1) {
+        return values;
+    }
+
+    // See the PERF_FORMAT_GROUP layout in perf_event_open(2)
+    uint64_t buffer[3 + NUM_HARDWARE_COUNTERS];
+    const ssize_t size = ::read(leader, buffer, sizeof(buffer));
+    if (size < (ssize_t) (3 * sizeof(uint64_t)) || buffer[0] != (uint64_t) numOpened) {
+        return values;
+    }
+
+    const uint64_t enabled = buffer[1];
+    const uint64_t running = buffer[2];
+    for (int i = 0; i < numOpened; ++i) {
+        uint64_t value = buffer[3 + i];
+        if (running > 0 && running < enabled) {
+            value = (uint64_t) llround((double) value * (double) enabled / (double) running);
+        }
+        values.values[order[i]] = value;
+        values.available[order[i]] = true;
+    }
+    return values;
+}
+#else
+HardwareCounters::HardwareCounters() : leader(-1), numOpened(0), error("Hardware counters are only supported on Linux") {
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+        fds[i] = -1;
+    }
+}
+
+HardwareCounters::~HardwareCounters() {
+}
+
+HardwareCounterValues HardwareCounters::read() const {
+    return HardwareCounterValues();
+}
+#endif
+}
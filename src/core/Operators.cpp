@@ -15,9 +15,13 @@
 */
 
 #include <core/Operators.hpp>
+#include <core/FusedOperation.hpp>
+#include <core/Exceptions.hpp>
 #include <core/Utils.hpp>
-#include <unordered_set>
+#include <core/BooleanFunctionParser.hpp>
 #include <regex>
+#include <algorithm>
+#include <limits>
 
 using namespace std;
 
@@ -28,17 +32,17 @@ bool isKnownUnaryOperator(const string &_operator) {
 }
 
 bool isKnownSuffixUnaryOperator(const string &_operator) {
-    regex unaryOperators(join<string>({ INDEX_REGEX, CONDITIONS_REGEX }, "|"));
+    static const regex unaryOperators(join<string>({ INDEX_REGEX, CONDITIONS_REGEX, EXISTS_REGEX, FORALL_REGEX }, "|"));
     return regex_match(_operator, unaryOperators);
 }
 
 bool isKnownPrefixUnaryOperator(const string &_operator) {
-    regex unaryOperators(join<string>({ NOT_REGEX }, "|"));
+    static const regex unaryOperators(join<string>({ NOT_REGEX }, "|"));
     return regex_match(_operator, unaryOperators);
 }
 
 bool isKnownBinaryOperator(const string &_operator) {
-    regex binaryOperators(join<string>({ AND_REGEX, OR_REGEX, XOR_REGEX, EQUALS_REGEX }, "|"));
+    static const regex binaryOperators(join<string>({ AND_REGEX, OR_REGEX, XOR_REGEX, EQUALS_REGEX }, "|"));
     return regex_match(_operator, binaryOperators);
 }
 
@@ -74,209 +78,425 @@ static vector<pair<string, bool>> parseConditions(const string &rawConditions) {
     return conditions;
 }
 
+static vector<string> parseQuantifiedVariables(const string &rawVariables) {
+    static const regex variableRegex(VARIABLE_REGEX);
+    vector<string> variables;
+    for (const string &variable : split(rawVariables, ',')) {
+        const string name = trim(variable);
+        if (!regex_match(name, variableRegex)) {
+            throw invalid_argument("Illegal quantified variable: " + variable);
+        }
+        if (!contains(variables, name)) {
+            variables.push_back(name);
+        }
+    }
+    if (variables.empty()) {
+        throw invalid_argument("No variables specified for the quantifier");
+    }
+    return variables;
+}
+
 UnaryOperator *createUnaryOperatorWithSymbol(const string &_operator) {
-    if (regex_match(_operator, regex(NOT_REGEX))) {
+    static const regex notRegex(NOT_REGEX);
+    static const regex indexRegex(INDEX_REGEX);
+    static const regex conditionsRegex(CONDITIONS_REGEX);
+    static const regex existsRegex(EXISTS_REGEX);
+    static const regex forallRegex(FORALL_REGEX);
+
+    if (regex_match(_operator, notRegex)) {
         return new Not();
-    } else if (regex_match(_operator, regex(INDEX_REGEX))) {
-        regex operatorRegex(INDEX_REGEX);
+    } else if (regex_match(_operator, indexRegex)) {
         smatch sm;
 
-        if (!regex_search(_operator, sm, operatorRegex, regex_constants::match_continuous)) {
+        if (!regex_search(_operator, sm, indexRegex, regex_constants::match_continuous)) {
             throw invalid_argument("Invalid index operator: " + _operator);
         }
 
         return new Index(stoul(sm[1]));
-    } else if (regex_match(_operator, regex(CONDITIONS_REGEX))) {
-        regex operatorRegex(CONDITIONS_REGEX);
+    } else if (regex_match(_operator, conditionsRegex)) {
         smatch sm;
 
-        if (!regex_search(_operator, sm, operatorRegex, regex_constants::match_continuous)) {
+        if (!regex_search(_operator, sm, conditionsRegex, regex_constants::match_continuous)) {
             throw invalid_argument("Invalid conditions operator: " + _operator);
         }
 
         return new Conditions(parseConditions(sm[1]));
     }
+
+    smatch sm;
+    if (regex_match(_operator, sm, existsRegex)) {
+        return new Exists(parseQuantifiedVariables(sm[1]));
+    } else if (regex_match(_operator, sm, forallRegex)) {
+        return new Forall(parseQuantifiedVariables(sm[1]));
+    }
     throw invalid_argument("Unknown operator: " + _operator);
 }
 
 BinaryOperator *createBinaryOperatorWithSymbol(const string &_operator) {
-    if (regex_match(_operator, regex(AND_REGEX))) {
+    static const regex andRegex(AND_REGEX);
+    static const regex orRegex(OR_REGEX);
+    static const regex xorRegex(XOR_REGEX);
+    static const regex equalsRegex(EQUALS_REGEX);
+
+    if (regex_match(_operator, andRegex)) {
         return new And();
-    } else if (regex_match(_operator, regex(OR_REGEX)))  {
+    } else if (regex_match(_operator, orRegex))  {
         return new Or();
-    } else if (regex_match(_operator, regex(XOR_REGEX)))  {
+    } else if (regex_match(_operator, xorRegex))  {
         return new Xor();
-    } else if (regex_match(_operator, regex(EQUALS_REGEX)))  {
+    } else if (regex_match(_operator, equalsRegex))  {
         return new Equals();
     }
     throw invalid_argument("Unknown operator: " + _operator);
 }
 
 BooleanFunction BoolTransformationUnaryOperator::operator()(const BooleanFunction &in) const {
-    BooleanFunction result(in);
     if (in.isConstant()) {
-        result.getConstantValue() = operate(in.getConstantValue());
-    } else {
-        for (TruthTableUInt i = 0; i < in.getTruthTable().size(); ++i) {
-            result.getTruthTable()[i] = operate(in.getTruthTable()[i]);
-        }
+        return BooleanFunction(operate(in.getConstantValue()));
+    }
+
+    // Written straight into a new table, rather than into a copy of the input
+    TruthTable result(in.getTruthTable().getVariables());
+    const unsigned numLines = result.size() < 64 ? (unsigned) result.size() : 64;
+    const uint64_t *inWords = in.getTruthTable().getWords();
+    uint64_t *words = result.getWords();
+    for (TruthTableUInt i = 0; i < result.getNumWords(); ++i) {
+        words[i] = operateWord(inWords[i], numLines);
     }
+    if (numLines < 64) {
+        words[0] &= (((uint64_t) 1) << numLines) - 1;
+    }
+
+    return BooleanFunction(result);
+}
 
+uint64_t BoolTransformationUnaryOperator::operateWord(const uint64_t in, const unsigned numLines) const {
+    uint64_t result = 0;
+    for (unsigned i = 0; i < numLines; ++i) {
+        if (operate(((in >> i) & 1) == 1)) {
+            result |= ((uint64_t) 1) << i;
+        }
+    }
     return result;
 }
 
-static TruthTableUInt getOtherTablesIndex(const TruthTableUInt combinedTablesIndex, const TruthTableVariablesUInt numVariablesInFirstTable) {
-    TruthTableUInt mask = ~((((TruthTableUInt) 1) << numVariablesInFirstTable) - 1);
-    return (combinedTablesIndex & mask) >> numVariablesInFirstTable;
+BooleanFunction CombinatoryBinaryOperator::operator()(const BooleanFunction &first, const BooleanFunction &second) const {
+    return (*this)({ &first, &second });
 }
 
-static TruthTableUInt getFirstTablesIndex(const TruthTableUInt combinedTablesIndex, const TruthTableVariablesUInt numVariablesInFirstTable) {
-    TruthTableUInt mask = (((TruthTableUInt) 1) << numVariablesInFirstTable) - 1;
-    return combinedTablesIndex & mask;
+BooleanFunction CombinatoryBinaryOperator::operator()(const vector<const BooleanFunction *> &operands) const {
+    if (operands.empty()) {
+        throw invalid_argument("Cannot combine an empty list of operands");
+    }
+
+    vector<FusedOperation> leaves;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        leaves.push_back(FusedOperation(i));
+    }
+    return FusedOperation(*this, move(leaves))(operands);
 }
 
-static vector<pair<string, vector<TruthTableVariablesUInt>>> getVariableIndices(const vector<string> &variables) {
-    vector<pair<string, vector<TruthTableVariablesUInt>>> result;
-    unordered_map<string, TruthTableVariablesUInt> variablesSeen;
+bool CombinatoryBinaryOperator::evaluateAt(const VariableAssignment &assignment, const function<bool (const VariableAssignment &)> &first,
+                                           const function<bool (const VariableAssignment &)> &second) const {
+    const bool firstValue = first(assignment);
+    if (isAbsorbing(firstValue ? ~(uint64_t) 0 : 0)) {
+        return firstValue;
+    }
+    return operate(firstValue, second(assignment));
+}
 
-    for (TruthTableVariablesUInt i = 0; i < variables.size(); ++i) {
-        const string &variable = variables[i];
-        if (variablesSeen.find(variable) == variablesSeen.end()) {
-            result.push_back(pair<string, vector<TruthTableVariablesUInt>>(variable, {}));
-            variablesSeen[variable] = (TruthTableVariablesUInt) (result.size() - 1);
+TruthTableUInt CombinatoryBinaryOperator::count(const TruthTableUInt firstCount, const TruthTableUInt firstSize,
+                                                const TruthTableUInt secondCount, const TruthTableUInt secondSize) const {
+    // The number of the operands' lines with each value
+    const TruthTableUInt firstLines[2] = { firstSize - firstCount, firstCount };
+    const TruthTableUInt secondLines[2] = { secondSize - secondCount, secondCount };
+    TruthTableUInt count = 0;
+    for (const bool firstValue : { false, true }) {
+        for (const bool secondValue : { false, true }) {
+            if (operate(firstValue, secondValue)) {
+                count += firstLines[firstValue] * secondLines[secondValue];
+            }
         }
-
-        result[variablesSeen[variable]].second.push_back(i);
     }
+    return count;
+}
 
+uint64_t CombinatoryBinaryOperator::operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const {
+    uint64_t result = 0;
+    for (unsigned i = 0; i < numLines; ++i) {
+        if (operate(((first >> i) & 1) == 1, ((second >> i) & 1) == 1)) {
+            result |= ((uint64_t) 1) << i;
+        }
+    }
     return result;
 }
 
-static TruthTableUInt getLineIndexInCombinedTable(const TruthTableVariablesUInt numVariablesInOriginalTable,
-                                     const TruthTableUInt originalTableLineIndex,
-                                     const vector<pair<string, vector<TruthTableVariablesUInt>>> &variableIndices) {
-    unordered_set<TruthTableVariablesUInt> columnsToRemove;
-    for (const auto &variable : variableIndices) {
-        // Keep the 0th, remove all others
-        for (TruthTableVariablesUInt i = 1; i < variable.second.size(); ++i) {
-            columnsToRemove.insert(variable.second[i]);
+vector<string> CombinatoryBinaryOperator::getResultVariables(const vector<string> &first, const vector<string> &second) const {
+    return getResultVariables(vector<vector<string>>({ first, second }));
+}
+
+vector<string> CombinatoryBinaryOperator::getResultVariables(const vector<vector<string>> &operands) const {
+    return FusedOperation::getResultVariables(operands);
+}
+
+BooleanFunction Index::operator()(const BooleanFunction &in) const {
+    if (in.isConstant()) {
+        return BooleanFunction(in.getConstantValue());
+    }
+
+    return BooleanFunction(in.getTruthTable()[index]);
+}
+
+void Index::validate(const vector<string> &variables) const {
+    // Same checks as reading the line of the operand's truth table. A constant has the same value on every line.
+    if (!variables.empty() && variables.size() < numeric_limits<TruthTableUInt>::digits && index >> variables.size() != 0) {
+        throw out_of_range("index needs to be in range: [0, " + to_string((((TruthTableUInt) 1) << variables.size()) - 1) + "]");
+    }
+}
+
+bool Index::evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                       const function<bool (const VariableAssignment &)> &operand) const {
+    UNUSED(assignment);
+    VariableAssignment line;
+    if (!operandVariables.empty()) {
+        for (TruthTableVariablesUInt i = 0; i < operandVariables.size(); ++i) {
+            line[operandVariables[i]] = TruthTable::getVariableValueInLine(i, index);
         }
     }
+    return operand(line);
+}
 
-    TruthTableUInt wordForNewLine = 0;
-    TruthTableVariablesUInt newLineColumn = 0;
-    for (TruthTableVariablesUInt column = 0; column < numVariablesInOriginalTable; ++column) {
-        if (columnsToRemove.find(column) == columnsToRemove.end()) {
-            wordForNewLine += (TruthTable::getVariableValueInLine(column, originalTableLineIndex) ? (TruthTableUInt)1 : (TruthTableUInt)0) << newLineColumn++;
+vector<string> Conditions::getResultVariables(const vector<string> &variables) const {
+    vector<string> result;
+    for (const string &variable : variables) {
+        if (find_if(conditions.begin(), conditions.end(), [&](const pair<string, bool> &condition) { return condition.first == variable; }) == conditions.end()) {
+            result.push_back(variable);
         }
     }
+    return result;
+}
 
-    return wordForNewLine;
+TruthTableUInt Conditions::estimateScratchSize(const vector<string> &variables) const {
+    // The condition builder collects the result's lines before building its table
+    const size_t numVariables = getResultVariables(variables).size();
+    if (numVariables >= numeric_limits<TruthTableUInt>::digits) {
+        return numeric_limits<TruthTableUInt>::max();
+    }
+    return ((TruthTableUInt) 1) << numVariables;
 }
 
-static bool shouldKeepLine(const vector<pair<string, vector<TruthTableVariablesUInt>>> &variableIndices, TruthTableUInt lineIndex) {
-    for (const auto &variable : variableIndices) {
-        bool previous = TruthTable::getVariableValueInLine(variable.second[0], lineIndex);
-        for (TruthTableUInt i = 1; i < variable.second.size(); ++i) {
-            if (previous != TruthTable::getVariableValueInLine(variable.second[i], lineIndex)) {
-                return false;
-            }
-        }
+string Conditions::getDescription() const {
+    vector<string> descriptions;
+    for (const pair<string, bool> &condition : conditions) {
+        descriptions.push_back(condition.first + " = " + (condition.second ? "1" : "0"));
     }
-    return true;
+    return getName() + "[" + join(descriptions, ", ") + "]";
 }
 
-TruthTable CombinatoryBinaryOperator::combineColumnsWithSameVariables(const TruthTableBuilder &rawBuilder) const {
-    vector<pair<string, vector<TruthTableVariablesUInt>>> variableIndices = getVariableIndices(rawBuilder.getVariables());
+void Conditions::validate(const vector<string> &variables) const {
+    // Same checks as conditioning the operand's truth table
+    if (variables.empty()) {
+        throw IllegalStateException("Cannot get the truth table of a constant value Boolean function.");
+    }
 
-    bool needsCombining = false;
-    for (const auto &variable : variableIndices) {
-        if (variable.second.size() > 1) {
-            needsCombining = true;
-            break;
+    for (const pair<string, bool> &condition : conditions) {
+        if (!contains(variables, condition.first)) {
+            throw invalid_argument("variable not found in the truth table: " + condition.first);
         }
     }
+}
+
+bool Conditions::evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const {
+    UNUSED(operandVariables);
+    VariableAssignment line = assignment;
+    for (const pair<string, bool> &condition : conditions) {
+        line[condition.first] = condition.second;
+    }
+    return operand(line);
+}
 
-    if (!needsCombining) {
-        return rawBuilder.build();
+BooleanFunction Conditions::evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const {
+    UNUSED(operandVariables);
+    VariableAssignment operandValues = values;
+    for (const pair<string, bool> &condition : conditions) {
+        operandValues[condition.first] = condition.second;
     }
+    return operand(operandValues);
+}
 
-    TruthTableBuilder builder;
-    vector<string> variables;
-    for (const auto &variable : variableIndices) {
-        variables.push_back(variable.first);
+BooleanFunction Conditions::operator()(const BooleanFunction &in) const {
+    TruthTableCondition truthTableCondition = in.getTruthTable().conditionBuilder();
+    for (const pair<string, bool> &condition : conditions) {
+        truthTableCondition.addCondition(condition.first, condition.second);
+    }
+    truthTableCondition.process();
+
+    if (truthTableCondition.hasCollapsedToConstant()) {
+        return BooleanFunction(truthTableCondition.getConstant());
+    } else {
+        return BooleanFunction(truthTableCondition.getTruthTable());
     }
-    builder.setVariables(variables);
+}
+
+// Every word of the table is reduced to 2^(6 - lineColumns) lines of the result, and combined with the ones of the
+// other words that differ only in the quantified word columns. The columns are from the last one. The result starts
+// out with the neutral value of combine, and every word is combined only into its own lines.
+template <typename Combine>
+static void quantifyWords(const TruthTable &table, const vector<unsigned> &lineColumns, const vector<unsigned> &wordColumns,
+                          TruthTable &result, const uint64_t neutral, const Combine &combine) {
+    uint64_t *words = result.getWords();
+    fill(words, words + result.getNumWords(), neutral);
+    const unsigned linesPerWord = 64u >> lineColumns.size();
+    const uint64_t linesMask = linesPerWord == 64 ? ~(uint64_t) 0 : (((uint64_t) 1) << linesPerWord) - 1;
+    const uint64_t *inWords = table.getWords();
+    for (TruthTableUInt i = 0; i < table.getNumWords(); ++i) {
+        // The lines where a column is 0 are combined with the ones where it's 1, and then packed into the low bits
+        uint64_t bits = inWords[i];
+        for (const unsigned column : lineColumns) {
+            bits = combine(bits, bits >> (1u << column)) & NEGATIVE_COFACTOR_MASKS[column];
+        }
+        for (const unsigned column : lineColumns) {
+            for (unsigned run = column; run < 5; ++run) {
+                bits = (bits | (bits >> (1u << run))) & NEGATIVE_COFACTOR_MASKS[run + 1];
+            }
+        }
 
-    for (TruthTableUInt i = 0; i < rawBuilder.tentativeSize(); ++i) {
-        if (shouldKeepLine(variableIndices, i)) {
-            builder.set(getLineIndexInCombinedTable((TruthTableVariablesUInt) rawBuilder.getVariables().size(), i, variableIndices), rawBuilder.getValue(i));
+        TruthTableUInt wordIndex = i;
+        for (const unsigned column : wordColumns) {
+            const unsigned bit = column - 6;
+            wordIndex = ((wordIndex >> (bit + 1)) << bit) | (wordIndex & ((((TruthTableUInt) 1) << bit) - 1));
         }
+        const TruthTableUInt line = wordIndex * linesPerWord;
+        const unsigned offset = (unsigned) (line % 64);
+        words[line / 64] = combine(words[line / 64], (bits << offset) | (neutral & ~(linesMask << offset)));
     }
+}
 
-    return builder.build();
+vector<string> Quantifier::getResultVariables(const vector<string> &variables) const {
+    vector<string> result;
+    for (const string &variable : variables) {
+        if (!contains(this->variables, variable)) {
+            result.push_back(variable);
+        }
+    }
+    return result;
 }
 
-TruthTableBuilder CombinatoryBinaryOperator::combineTables(const BooleanFunction &first, const BooleanFunction &second) const {
-    // By convention, this function's variables will have lower significance
-    vector<string> variables = first.getTruthTable().getVariables();
-    variables.insert(variables.end(), second.getTruthTable().getVariables().begin(), second.getTruthTable().getVariables().end());
-    TruthTableBuilder resultingTable;
-    resultingTable.setVariables(variables);
+vector<string> Quantifier::getQuantifiedOperandVariables(const vector<string> &operandVariables) const {
+    vector<string> result;
+    for (const string &variable : operandVariables) {
+        if (contains(variables, variable)) {
+            result.push_back(variable);
+        }
+    }
+    return result;
+}
 
-    TruthTableVariablesUInt numVariablesInFirst = (TruthTableVariablesUInt) first.getTruthTable().getVariables().size();
-    for (TruthTableUInt i = 0; i < resultingTable.tentativeSize(); ++i) {
-        bool operand1 = first.getTruthTable()[getFirstTablesIndex(i, numVariablesInFirst)];
-        bool operand2 = second.getTruthTable()[getOtherTablesIndex(i, numVariablesInFirst)];
-        resultingTable.set(i, operate(operand1, operand2));
+string Quantifier::getDescription() const {
+    return getName() + "[" + join(variables, ", ") + "]";
+}
+
+bool Quantifier::evaluateAt(const VariableAssignment &assignment, const vector<string> &operandVariables,
+                            const function<bool (const VariableAssignment &)> &operand) const {
+    const vector<string> quantified = getQuantifiedOperandVariables(operandVariables);
+    if (quantified.size() >= numeric_limits<TruthTableUInt>::digits) {
+        throw invalid_argument("Cannot quantify " + to_string(quantified.size()) + " variables on a single line");
     }
 
-    return resultingTable;
+    VariableAssignment line = assignment;
+    for (TruthTableUInt i = 0; i >> quantified.size() == 0; ++i) {
+        for (size_t j = 0; j < quantified.size(); ++j) {
+            line[quantified[j]] = ((i >> j) & 1) == 1;
+        }
+        if (operand(line) == getDecidingValue()) {
+            return getDecidingValue();
+        }
+    }
+    return !getDecidingValue();
 }
 
-BooleanFunction CombinatoryBinaryOperator::operator()(const BooleanFunction &first, const BooleanFunction &second) const {
-    if (first.hasTruthTable() && second.hasTruthTable()) {
-        // Combining two regular Boolean functions
-        return BooleanFunction(combineColumnsWithSameVariables(combineTables(first, second)));
+TruthTableUInt Quantifier::estimatePointReads(const vector<string> &variables) const {
+    const size_t quantified = getQuantifiedOperandVariables(variables).size();
+    if (quantified >= numeric_limits<TruthTableUInt>::digits) {
+        return numeric_limits<TruthTableUInt>::max();
     }
+    return ((TruthTableUInt) 1) << quantified;
+}
 
-    if (!first.hasTruthTable() && !second.hasTruthTable()) {
-        // Just combining two constant bools
-        return BooleanFunction(operate(first.getConstantValue(), second.getConstantValue()));
+BooleanFunction Quantifier::evaluateBlock(const VariableAssignment &values, const vector<string> &operandVariables,
+                                          const function<BooleanFunction (const VariableAssignment &)> &operand) const {
+    const vector<string> quantified = getQuantifiedOperandVariables(operandVariables);
+    if (quantified.size() >= numeric_limits<TruthTableUInt>::digits) {
+        throw invalid_argument("Cannot quantify " + to_string(quantified.size()) + " variables on a block of lines");
     }
 
-    // Combining one truthtable Boolean function with a constant one
-    TruthTable clone = first.hasTruthTable() ? first.getTruthTable() : second.getTruthTable();
-    for (TruthTableUInt i = 0; i < clone.size(); ++i) {
-        // The order of args might be important, because the binary operator may or may not be reflexive
-        if (first.hasTruthTable()) {
-            clone[i] = operate(first.getTruthTable()[i], second.getConstantValue());
+    // The operand's blocks have the same variables, so they're combined line by line
+    VariableAssignment operandValues = values;
+    BooleanFunction result(!getDecidingValue());
+    for (TruthTableUInt i = 0; i >> quantified.size() == 0; ++i) {
+        for (size_t j = 0; j < quantified.size(); ++j) {
+            operandValues[quantified[j]] = ((i >> j) & 1) == 1;
+        }
+        const BooleanFunction block = operand(operandValues);
+        if (i == 0) {
+            result = block;
+        } else if (block.isConstant()) {
+            result = BooleanFunction((combineWords(result.getConstantValue(), block.getConstantValue()) & 1) == 1);
         } else {
-            clone[i] = operate(first.getConstantValue(), second.getTruthTable()[i]);
+            uint64_t *words = result.getTruthTable().getWords();
+            const uint64_t *blockWords = block.getTruthTable().getWords();
+            for (TruthTableUInt k = 0; k < result.getTruthTable().getNumWords(); ++k) {
+                words[k] = combineWords(words[k], blockWords[k]);
+            }
+        }
+
+        // Stop once every line is decided
+        const TruthTableUInt decided = result.isConstant() ? result.getConstantValue() == getDecidingValue() :
+                                       (getDecidingValue() ? result.getTruthTable().count() :
+                                                             result.getTruthTable().size() - result.getTruthTable().count());
+        if (decided == (result.isConstant() ? 1 : result.getTruthTable().size())) {
+            break;
         }
     }
-    return BooleanFunction(clone);
+    return result;
 }
 
-BooleanFunction Index::operator()(const BooleanFunction &in) const {
+BooleanFunction Quantifier::operator()(const BooleanFunction &in) const {
     if (in.isConstant()) {
-        return BooleanFunction(in.getConstantValue());
+        return in;
     }
 
-    return BooleanFunction(in.getTruthTable()[index]);
-}
+    const TruthTable &table = in.getTruthTable();
+    const vector<string> resultVariables = getResultVariables(table.getVariables());
+    if (resultVariables.size() == table.getVariables().size()) {
+        return in;
+    }
+    if (resultVariables.empty()) {
+        const TruthTableUInt count = table.count();
+        return BooleanFunction(getDecidingValue() ? count != 0 : count == table.size());
+    }
 
-BooleanFunction Conditions::operator()(const BooleanFunction &in) const {
-    TruthTableCondition truthTableCondition = in.getTruthTable().conditionBuilder();
-    for (const pair<string, bool> &condition : conditions) {
-        truthTableCondition.addCondition(condition.first, condition.second);
+    // The quantified columns from the last one: the ones within a word, and the ones that select the words
+    vector<unsigned> wordColumns;
+    vector<unsigned> lineColumns;
+    for (TruthTableVariablesUInt i = (TruthTableVariablesUInt) table.getVariables().size(); i > 0; --i) {
+        if (!contains(resultVariables, table.getVariables()[i - 1])) {
+            (i - 1 < 6 ? lineColumns : wordColumns).push_back(i - 1);
+        }
     }
-    truthTableCondition.process();
 
-    if (truthTableCondition.hasCollapsedToConstant()) {
-        return BooleanFunction(truthTableCondition.getConstant());
+    TruthTable result(resultVariables);
+    if (getDecidingValue()) {
+        quantifyWords(table, lineColumns, wordColumns, result, 0, [](const uint64_t first, const uint64_t second) { return first | second; });
     } else {
-        return BooleanFunction(truthTableCondition.getTruthTable());
+        quantifyWords(table, lineColumns, wordColumns, result, ~(uint64_t) 0, [](const uint64_t first, const uint64_t second) { return first & second; });
+    }
+    if (result.size() < 64) {
+        result.getWords()[0] &= (((uint64_t) 1) << result.size()) - 1;
     }
+
+    return BooleanFunction(result);
 }
 }
@@ -0,0 +1,371 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <core/Optimizer.hpp>
+#include <core/FusedOperation.hpp>
+#include <core/Operators.hpp>
+#include <core/Utils.hpp>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace Logic {
+// A way of combining the operands of a chain: either an operand, or the combination of two other plans
+struct ChainPlan {
+    // The index of the operand if this is a leaf, else -1
+    int operand;
+    unique_ptr<ChainPlan> first;
+    unique_ptr<ChainPlan> second;
+    vector<string> variables;
+};
+
+// The peak size of the truth tables allocated by a single combination, and the lines processed by all of them.
+// Compared in that order.
+struct ChainCost {
+    TruthTableUInt peak = 0;
+    TruthTableUInt work = 0;
+
+    bool operator<(const ChainCost &rhs) const {
+        return peak != rhs.peak ? peak < rhs.peak : work < rhs.work;
+    }
+};
+
+static TruthTableUInt getSize(const vector<string> &variables) {
+    if (variables.size() >= numeric_limits<TruthTableUInt>::digits) {
+        return numeric_limits<TruthTableUInt>::max();
+    }
+    return ((TruthTableUInt) 1) << variables.size();
+}
+
+static unique_ptr<ChainPlan> createLeaf(const int operand, const vector<string> &variables) {
+    unique_ptr<ChainPlan> plan(new ChainPlan());
+    plan->operand = operand;
+    plan->variables = variables;
+    return plan;
+}
+
+static unique_ptr<ChainPlan> combine(const BinaryOperator &_operator, unique_ptr<ChainPlan> first, unique_ptr<ChainPlan> second) {
+    unique_ptr<ChainPlan> plan(new ChainPlan());
+    plan->operand = -1;
+    plan->variables = _operator.getResultVariables(first->variables, second->variables);
+    plan->first = move(first);
+    plan->second = move(second);
+    return plan;
+}
+
+// The allocations of combining these two, like BinaryOperatorExpression::estimatePeakMemoryUsage(), in lines
+static TruthTableUInt getCombinationPeak(const BinaryOperator &_operator, const vector<string> &first, const vector<string> &second) {
+    const TruthTableUInt operands = saturatingAdd(getSize(first), getSize(second));
+    return saturatingAdd(saturatingAdd(operands, _operator.estimateScratchSize(first, second)), getSize(_operator.getResultVariables(first, second)));
+}
+
+static ChainCost getCost(const BinaryOperator &_operator, const ChainPlan &plan) {
+    ChainCost cost;
+    if (plan.operand >= 0) {
+        return cost;
+    }
+
+    const ChainCost first = getCost(_operator, *plan.first);
+    const ChainCost second = getCost(_operator, *plan.second);
+    const TruthTableUInt peak = getCombinationPeak(_operator, plan.first->variables, plan.second->variables);
+    cost.peak = max(peak, saturatingAdd(first.peak, second.peak));
+    cost.work = saturatingAdd(saturatingAdd(first.work, second.work),
+                              saturatingAdd(saturatingAdd(getSize(plan.first->variables), getSize(plan.second->variables)), peak));
+    return cost;
+}
+
+// Takes the chain apart, and returns the plan of how it was grouped. The operands and the operators are collected in
+// their original order.
+static unique_ptr<ChainPlan> flattenChain(unique_ptr<Expression> expression, const string &operatorName,
+                                          vector<unique_ptr<Expression>> &operands, vector<unique_ptr<BinaryOperator>> &operators) {
+    BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get());
+    if (binary == nullptr || binary->getOperator().getName() != operatorName) {
+        const vector<string> variables = expression->getVariables();
+        operands.push_back(reorderChains(move(expression)));
+        return createLeaf((int) operands.size() - 1, variables);
+    }
+
+    unique_ptr<BinaryOperator> _operator;
+    unique_ptr<Expression> first;
+    unique_ptr<Expression> second;
+    binary->release(_operator, first, second);
+    operators.push_back(move(_operator));
+    const BinaryOperator &chainOperator = *operators.back();
+    unique_ptr<ChainPlan> firstPlan = flattenChain(move(first), operatorName, operands, operators);
+    unique_ptr<ChainPlan> secondPlan = flattenChain(move(second), operatorName, operands, operators);
+    return combine(chainOperator, move(firstPlan), move(secondPlan));
+}
+
+// Repeatedly combines the two plans whose combination allocates the least, keeping the original order between them
+static unique_ptr<ChainPlan> getGreedyPlan(const BinaryOperator &_operator, const vector<unique_ptr<Expression>> &operands) {
+    vector<unique_ptr<ChainPlan>> plans;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        plans.push_back(createLeaf((int) i, operands[i]->getVariables()));
+    }
+
+    while (plans.size() > 1) {
+        size_t bestFirst = 0;
+        size_t bestSecond = 1;
+        TruthTableUInt bestPeak = numeric_limits<TruthTableUInt>::max();
+        for (size_t i = 0; i < plans.size(); ++i) {
+            for (size_t j = i + 1; j < plans.size(); ++j) {
+                const TruthTableUInt peak = getCombinationPeak(_operator, plans[i]->variables, plans[j]->variables);
+                if (peak < bestPeak) {
+                    bestFirst = i;
+                    bestSecond = j;
+                    bestPeak = peak;
+                }
+            }
+        }
+
+        plans[bestFirst] = combine(_operator, move(plans[bestFirst]), move(plans[bestSecond]));
+        plans.erase(plans.begin() + (long) bestSecond);
+    }
+    return move(plans.front());
+}
+
+static unique_ptr<Expression> build(const ChainPlan &plan, vector<unique_ptr<Expression>> &operands, vector<unique_ptr<BinaryOperator>> &operators) {
+    if (plan.operand >= 0) {
+        return move(operands[(size_t) plan.operand]);
+    }
+
+    unique_ptr<Expression> first = build(*plan.first, operands, operators);
+    unique_ptr<Expression> second = build(*plan.second, operands, operators);
+    unique_ptr<BinaryOperator> _operator = move(operators.back());
+    operators.pop_back();
+    return unique_ptr<Expression>(new BinaryOperatorExpression(move(_operator), move(first), move(second)));
+}
+
+unique_ptr<Expression> reorderChains(unique_ptr<Expression> expression) {
+    if (UnaryOperatorExpression *unary = dynamic_cast<UnaryOperatorExpression *>(expression.get())) {
+        unique_ptr<UnaryOperator> _operator;
+        unique_ptr<Expression> operand;
+        unary->release(_operator, operand);
+        return unique_ptr<Expression>(new UnaryOperatorExpression(move(_operator), reorderChains(move(operand))));
+    }
+
+    BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get());
+    if (binary == nullptr) {
+        return expression;
+    }
+
+    if (!binary->getOperator().isAssociativeAndCommutative()) {
+        unique_ptr<BinaryOperator> _operator;
+        unique_ptr<Expression> first;
+        unique_ptr<Expression> second;
+        binary->release(_operator, first, second);
+        return unique_ptr<Expression>(new BinaryOperatorExpression(move(_operator), reorderChains(move(first)), reorderChains(move(second))));
+    }
+
+    const vector<string> variables = expression->getVariables();
+    const string operatorName = binary->getOperator().getName();
+    vector<unique_ptr<Expression>> operands;
+    vector<unique_ptr<BinaryOperator>> operators;
+    unique_ptr<ChainPlan> plan = flattenChain(move(expression), operatorName, operands, operators);
+    const BinaryOperator &_operator = *operators.front();
+
+    // Putting the variables back in order would hold a copy of the whole result, which is more than any grouping
+    // saves, so only the groupings that keep the order are used
+    unique_ptr<ChainPlan> greedyPlan = getGreedyPlan(_operator, operands);
+    const bool useGreedyPlan = greedyPlan->variables == variables && getCost(_operator, *greedyPlan) < getCost(_operator, *plan);
+    return build(useGreedyPlan ? *greedyPlan : *plan, operands, operators);
+}
+
+// Whether the expression is an operator that works a word at a time, and hence can be fused
+static bool isFusable(const Expression &expression) {
+    if (const UnaryOperatorExpression *unary = dynamic_cast<const UnaryOperatorExpression *>(&expression)) {
+        return dynamic_cast<const BoolTransformationUnaryOperator *>(&unary->getOperator()) != nullptr;
+    }
+    if (const BinaryOperatorExpression *binary = dynamic_cast<const BinaryOperatorExpression *>(&expression)) {
+        return dynamic_cast<const CombinatoryBinaryOperator *>(&binary->getOperator()) != nullptr;
+    }
+    return false;
+}
+
+// The number of operators that would be fused together with this one
+static size_t countFusable(const Expression &expression) {
+    if (!isFusable(expression)) {
+        return 0;
+    }
+    if (const UnaryOperatorExpression *unary = dynamic_cast<const UnaryOperatorExpression *>(&expression)) {
+        return 1 + countFusable(unary->getOperand());
+    }
+    const BinaryOperatorExpression &binary = dynamic_cast<const BinaryOperatorExpression &>(expression);
+    return 1 + countFusable(binary.getFirst()) + countFusable(binary.getSecond());
+}
+
+static FusedOperation fuse(unique_ptr<Expression> expression, vector<unique_ptr<Expression>> &operands);
+
+// Takes a chain of the operator apart, like "a & (b & c)", collecting its operands in their original order
+static void flatten(unique_ptr<Expression> expression, const string &operatorName, vector<FusedOperation> &chain, vector<unique_ptr<Expression>> &operands) {
+    BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get());
+    if (binary == nullptr || binary->getOperator().getName() != operatorName || !binary->getOperator().isAssociativeAndCommutative()) {
+        chain.push_back(fuse(move(expression), operands));
+        return;
+    }
+
+    unique_ptr<BinaryOperator> _operator;
+    unique_ptr<Expression> first;
+    unique_ptr<Expression> second;
+    binary->release(_operator, first, second);
+    flatten(move(first), operatorName, chain, operands);
+    flatten(move(second), operatorName, chain, operands);
+}
+
+// The operation of the fusable operators at the top of the expression. The expressions under them are collected as the
+// operands, from left to right, with their own operators fused.
+static FusedOperation fuse(unique_ptr<Expression> expression, vector<unique_ptr<Expression>> &operands) {
+    if (!isFusable(*expression)) {
+        operands.push_back(fuseOperators(move(expression)));
+        return FusedOperation(operands.size() - 1);
+    }
+
+    if (UnaryOperatorExpression *unary = dynamic_cast<UnaryOperatorExpression *>(expression.get())) {
+        unique_ptr<UnaryOperator> _operator;
+        unique_ptr<Expression> operand;
+        unary->release(_operator, operand);
+        unique_ptr<BoolTransformationUnaryOperator> transformation(static_cast<BoolTransformationUnaryOperator *>(_operator.release()));
+        return FusedOperation(move(transformation), fuse(move(operand), operands));
+    }
+
+    BinaryOperatorExpression &binary = dynamic_cast<BinaryOperatorExpression &>(*expression);
+    unique_ptr<BinaryOperator> _operator;
+    unique_ptr<Expression> first;
+    unique_ptr<Expression> second;
+    binary.release(_operator, first, second);
+    vector<FusedOperation> chain;
+    if (_operator->isAssociativeAndCommutative()) {
+        flatten(move(first), _operator->getName(), chain, operands);
+        flatten(move(second), _operator->getName(), chain, operands);
+    } else {
+        chain.push_back(fuse(move(first), operands));
+        chain.push_back(fuse(move(second), operands));
+    }
+    unique_ptr<CombinatoryBinaryOperator> combinatory(static_cast<CombinatoryBinaryOperator *>(_operator.release()));
+    return FusedOperation(move(combinatory), move(chain));
+}
+
+unique_ptr<Expression> fuseOperators(unique_ptr<Expression> expression) {
+    if (countFusable(*expression) >= 2) {
+        vector<unique_ptr<Expression>> operands;
+        FusedOperation operation = fuse(move(expression), operands);
+        return unique_ptr<Expression>(new FusedOperatorExpression(move(operation), move(operands)));
+    }
+
+    // A single operator has no intermediate table to avoid
+    if (UnaryOperatorExpression *unary = dynamic_cast<UnaryOperatorExpression *>(expression.get())) {
+        unique_ptr<UnaryOperator> _operator;
+        unique_ptr<Expression> operand;
+        unary->release(_operator, operand);
+        return unique_ptr<Expression>(new UnaryOperatorExpression(move(_operator), fuseOperators(move(operand))));
+    }
+    if (BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get())) {
+        unique_ptr<BinaryOperator> _operator;
+        unique_ptr<Expression> first;
+        unique_ptr<Expression> second;
+        binary->release(_operator, first, second);
+        return unique_ptr<Expression>(new BinaryOperatorExpression(move(_operator), fuseOperators(move(first)), fuseOperators(move(second))));
+    }
+    return expression;
+}
+
+typedef vector<pair<string, bool>> ConditionList;
+
+// The conditions on the given variables
+static ConditionList restrict(const ConditionList &conditions, const vector<string> &variables) {
+    ConditionList result;
+    for (const pair<string, bool> &condition : conditions) {
+        if (contains(variables, condition.first)) {
+            result.push_back(condition);
+        }
+    }
+    return result;
+}
+
+static unique_ptr<Expression> createConditions(const ConditionList &conditions, unique_ptr<Expression> expression) {
+    return unique_ptr<Expression>(new UnaryOperatorExpression(unique_ptr<UnaryOperator>(new Conditions(conditions)), move(expression)));
+}
+
+// Applies the conditions, which are all on the expression's variables, as deep in the expression as possible
+static unique_ptr<Expression> condition(unique_ptr<Expression> expression, const ConditionList &conditions) {
+    if (conditions.empty()) {
+        return expression;
+    }
+
+    if (UnaryOperatorExpression *unary = dynamic_cast<UnaryOperatorExpression *>(expression.get())) {
+        const bool isTransformation = dynamic_cast<const BoolTransformationUnaryOperator *>(&unary->getOperator()) != nullptr;
+        const bool isQuantifier = dynamic_cast<const Quantifier *>(&unary->getOperator()) != nullptr;
+        const Conditions *inner = dynamic_cast<const Conditions *>(&unary->getOperator());
+        if (isTransformation || isQuantifier || inner != nullptr) {
+            unique_ptr<UnaryOperator> _operator;
+            unique_ptr<Expression> operand;
+            unary->release(_operator, operand);
+            if (isTransformation || isQuantifier) {
+                // The same line of the operand is transformed, or the conditions are on the variables that aren't
+                // quantified
+                return unique_ptr<Expression>(new UnaryOperatorExpression(move(_operator), condition(move(operand), conditions)));
+            }
+
+            // The inner conditions are on other variables, since they're not in the result
+            ConditionList merged = static_cast<const Conditions &>(*_operator).getConditions();
+            merged.insert(merged.end(), conditions.begin(), conditions.end());
+            return createConditions(merged, move(operand));
+        }
+    }
+
+    BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get());
+    if (binary != nullptr && dynamic_cast<const CombinatoryBinaryOperator *>(&binary->getOperator()) != nullptr) {
+        // The lines of the operands that are combined into the conditioned lines
+        unique_ptr<BinaryOperator> _operator;
+        unique_ptr<Expression> first;
+        unique_ptr<Expression> second;
+        binary->release(_operator, first, second);
+        const ConditionList firstConditions = restrict(conditions, first->getVariables());
+        const ConditionList secondConditions = restrict(conditions, second->getVariables());
+        return unique_ptr<Expression>(new BinaryOperatorExpression(move(_operator), condition(move(first), firstConditions),
+                                                                   condition(move(second), secondConditions)));
+    }
+
+    return createConditions(conditions, move(expression));
+}
+
+unique_ptr<Expression> pushDownConditions(unique_ptr<Expression> expression) {
+    if (UnaryOperatorExpression *unary = dynamic_cast<UnaryOperatorExpression *>(expression.get())) {
+        unique_ptr<UnaryOperator> _operator;
+        unique_ptr<Expression> operand;
+        unary->release(_operator, operand);
+        operand = pushDownConditions(move(operand));
+
+        const Conditions *conditions = dynamic_cast<const Conditions *>(_operator.get());
+        if (conditions != nullptr && !operand->getVariables().empty() &&
+            restrict(conditions->getConditions(), operand->getVariables()).size() == conditions->getConditions().size()) {
+            return condition(move(operand), conditions->getConditions());
+        }
+        return unique_ptr<Expression>(new UnaryOperatorExpression(move(_operator), move(operand)));
+    }
+
+    if (BinaryOperatorExpression *binary = dynamic_cast<BinaryOperatorExpression *>(expression.get())) {
+        unique_ptr<BinaryOperator> _operator;
+        unique_ptr<Expression> first;
+        unique_ptr<Expression> second;
+        binary->release(_operator, first, second);
+        return unique_ptr<Expression>(new BinaryOperatorExpression(move(_operator), pushDownConditions(move(first)), pushDownConditions(move(second))));
+    }
+    return expression;
+}
+}
@@ -0,0 +1,241 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <core/Profiler.hpp>
+#include <core/Utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace Logic {
+static constexpr unsigned BUCKETS_PER_OCTAVE = 4;
+
+static thread_local ProfileCounters *currentCounters = nullptr;
+
+static size_t getBucket(const uint64_t nanoseconds) {
+    return nanoseconds == 0 ? 0 : (size_t) floor(log2((double) nanoseconds) * BUCKETS_PER_OCTAVE) + 1;
+}
+
+static uint64_t getBucketUpperBound(const size_t bucket) {
+    return bucket == 0 ? 0 : (uint64_t) ceil(pow(2, (double) bucket / BUCKETS_PER_OCTAVE));
+}
+
+void LatencyHistogram::add(const uint64_t nanoseconds) {
+    const size_t bucket = getBucket(nanoseconds);
+    if (bucket >= buckets.size()) {
+        buckets.resize(bucket + 1, 0);
+    }
+    ++buckets[bucket];
+    ++count;
+    total += nanoseconds;
+    max = std::max(max, nanoseconds);
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other) {
+    if (other.buckets.size() > buckets.size()) {
+        buckets.resize(other.buckets.size(), 0);
+    }
+    for (size_t bucket = 0; bucket < other.buckets.size(); ++bucket) {
+        buckets[bucket] += other.buckets[bucket];
+    }
+    count += other.count;
+    total += other.total;
+    max = std::max(max, other.max);
+}
+
+uint64_t LatencyHistogram::getPercentile(const double percentile) const {
+    // Nearest rank
+    const uint64_t rank = std::max((uint64_t) ceil(percentile / 100 * (double) count), (uint64_t) 1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            return std::min(getBucketUpperBound(bucket), max);
+        }
+    }
+    return max;
+}
+
+ProfileMeasurement::ProfileMeasurement(const Profiler &profiler)
+    : start(chrono::steady_clock::now()),
+      hardwareCounters(profiler.usesHardwareCounters() ? &HardwareCounters::forCurrentThread() : nullptr) {
+    if (hardwareCounters != nullptr) {
+        startCounters = hardwareCounters->read();
+    }
+}
+
+chrono::steady_clock::duration ProfileMeasurement::getElapsed() const {
+    return chrono::steady_clock::now() - start;
+}
+
+HardwareCounterValues ProfileMeasurement::getCounters() const {
+    return hardwareCounters == nullptr ? HardwareCounterValues() : hardwareCounters->read() - startCounters;
+}
+
+static void record(map<string, ProfileEntry> &entries, const string &name, const chrono::steady_clock::duration &elapsed,
+                   const HardwareCounterValues &counters, const uint64_t rows, const uint64_t resultBytes) {
+    ProfileEntry &entry = entries[name];
+    entry.latencies.add((uint64_t) chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    entry.rows += rows;
+    entry.resultBytes += resultBytes;
+    entry.counters += counters;
+}
+
+void Profiler::recordCommand(const string &command, const ProfileMeasurement &measurement, const ProfileCounters &counters) {
+    // Measure before waiting for the lock
+    const chrono::steady_clock::duration elapsed = measurement.getElapsed();
+    const HardwareCounterValues hardwareCounters = measurement.getCounters();
+
+    lock_guard<mutex> guard(lock);
+    record(commands, command, elapsed, hardwareCounters, counters.rows, counters.resultBytes);
+}
+
+void Profiler::recordOperator(const string &_operator, const ProfileMeasurement &measurement, const uint64_t rows, const uint64_t resultBytes) {
+    const chrono::steady_clock::duration elapsed = measurement.getElapsed();
+    const HardwareCounterValues hardwareCounters = measurement.getCounters();
+    if (currentCounters != nullptr) {
+        currentCounters->rows += rows;
+        currentCounters->resultBytes += resultBytes;
+    }
+
+    lock_guard<mutex> guard(lock);
+    record(operators, _operator, elapsed, hardwareCounters, rows, resultBytes);
+}
+
+static void add(map<string, ProfileEntry> &entries, const map<string, ProfileEntry> &others) {
+    for (const auto &other : others) {
+        ProfileEntry &entry = entries[other.first];
+        entry.latencies.add(other.second.latencies);
+        entry.rows += other.second.rows;
+        entry.resultBytes += other.second.resultBytes;
+        entry.counters += other.second.counters;
+    }
+}
+
+void Profiler::add(const Profiler &other) {
+    // Copied first, so that the locks are never held together
+    const map<string, ProfileEntry> otherCommands = other.getCommands();
+    const map<string, ProfileEntry> otherOperators = other.getOperators();
+    lock_guard<mutex> guard(lock);
+    Logic::add(commands, otherCommands);
+    Logic::add(operators, otherOperators);
+}
+
+map<string, ProfileEntry> Profiler::getCommands() const {
+    lock_guard<mutex> guard(lock);
+    return commands;
+}
+
+map<string, ProfileEntry> Profiler::getOperators() const {
+    lock_guard<mutex> guard(lock);
+    return operators;
+}
+
+void Profiler::reset() {
+    lock_guard<mutex> guard(lock);
+    commands.clear();
+    operators.clear();
+}
+
+ProfileCounters *Profiler::getCurrentCounters() {
+    return currentCounters;
+}
+
+ScopedProfileCounters::ScopedProfileCounters(ProfileCounters *counters) : previous(currentCounters) {
+    currentCounters = counters;
+}
+
+ScopedProfileCounters::~ScopedProfileCounters() {
+    currentCounters = previous;
+}
+
+static bool hasHardwareCounters(const map<string, ProfileEntry> &entries) {
+    for (const auto &entry : entries) {
+        if (entry.second.counters.any()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A ratio of the counters, or "-" if it's not known
+static string getRatio(const HardwareCounterValues &counters, const HardwareCounter numerator, const double denominator) {
+    if (!counters.available[numerator] || denominator == 0) {
+        return "-";
+    }
+    stringstream out;
+    out << fixed << setprecision(3) << (double) counters.values[numerator] / denominator;
+    return out.str();
+}
+
+static void printEntries(ostream &os, const string &title, const map<string, ProfileEntry> &entries, const bool printCounters) {
+    os << left << setw(12) << title << right
+       << setw(10) << "count"
+       << setw(12) << "total"
+       << setw(12) << "p50"
+       << setw(12) << "p90"
+       << setw(12) << "p99"
+       << setw(12) << "max"
+       << setw(16) << "rows"
+       << setw(16) << "result bytes";
+    if (printCounters) {
+        os << setw(8) << "IPC"
+           << setw(16) << "cache miss/row"
+           << setw(16) << "branch miss/row";
+    }
+    os << endl;
+    for (const auto &entry : entries) {
+        const LatencyHistogram &latencies = entry.second.latencies;
+        os << left << setw(12) << entry.first << right
+           << setw(10) << latencies.getCount()
+           << setw(12) << formatDuration(latencies.getTotal())
+           << setw(12) << formatDuration(latencies.getPercentile(50))
+           << setw(12) << formatDuration(latencies.getPercentile(90))
+           << setw(12) << formatDuration(latencies.getPercentile(99))
+           << setw(12) << formatDuration(latencies.getMax())
+           << setw(16) << entry.second.rows
+           << setw(16) << entry.second.resultBytes;
+        if (printCounters) {
+            const HardwareCounterValues &counters = entry.second.counters;
+            const double rows = (double) entry.second.rows;
+            os << setw(8) << (counters.available[CYCLES] ? getRatio(counters, INSTRUCTIONS, (double) counters.values[CYCLES]) : "-")
+               << setw(16) << getRatio(counters, CACHE_MISSES, rows)
+               << setw(16) << getRatio(counters, BRANCH_MISSES, rows);
+        }
+        os << endl;
+    }
+}
+
+ostream &operator<<(ostream &os, const Profiler &profiler) {
+    const map<string, ProfileEntry> commands = profiler.getCommands();
+    const map<string, ProfileEntry> operators = profiler.getOperators();
+    const bool printCounters = hasHardwareCounters(commands) || hasHardwareCounters(operators);
+
+    printEntries(os, "command", commands, printCounters);
+    os << endl;
+    printEntries(os, "operator", operators, printCounters);
+
+    if (profiler.usesHardwareCounters() && !printCounters) {
+        const string &error = HardwareCounters::forCurrentThread().getError();
+        os << endl << "Hardware counters unavailable" << (error.empty() ? "" : ": " + error) << endl;
+    }
+    return os;
+}
+}
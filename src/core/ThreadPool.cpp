@@ -0,0 +1,59 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <core/ThreadPool.hpp>
+
+using namespace std;
+
+namespace Logic {
+ThreadPool::ThreadPool(const size_t numThreads) : stopping(false) {
+    if (numThreads == 0) {
+        throw invalid_argument("A ThreadPool needs at least 1 thread.");
+    }
+
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers.push_back(thread([this]() { work(); }));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<mutex> lock(tasksMutex);
+        stopping = true;
+    }
+    tasksAvailable.notify_all();
+    for (thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        function<void ()> task;
+        {
+            unique_lock<mutex> lock(tasksMutex);
+            tasksAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            // Drain the queue before stopping, so that no submitted task is left with a broken promise
+            if (tasks.empty()) {
+                return;
+            }
+            task = tasks.front();
+            tasks.pop();
+        }
+        task();
+    }
+}
+}
@@ -0,0 +1,97 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <core/Tracer.hpp>
+#include <atomic>
+
+using namespace std;
+
+namespace Logic {
+static atomic<uint64_t> nextTracerId(1);
+
+// The buffer of the tracer that this thread recorded into last
+struct CachedBuffer {
+    uint64_t tracerId;
+    void *buffer;
+};
+static thread_local CachedBuffer cachedBuffer = { 0, nullptr };
+
+Tracer::Tracer() : id(nextTracerId++), origin(chrono::steady_clock::now()) {
+}
+
+chrono::nanoseconds Tracer::now() const {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin);
+}
+
+Tracer::Buffer &Tracer::getBuffer() {
+    if (cachedBuffer.tracerId == id) {
+        return *static_cast<Buffer *>(cachedBuffer.buffer);
+    }
+
+    // This thread's first event for this tracer
+    lock_guard<mutex> guard(lock);
+    buffers.push_back(unique_ptr<Buffer>(new Buffer()));
+    Buffer &buffer = *buffers.back();
+    buffer.thread.id = (uint32_t) buffers.size();
+    cachedBuffer = { id, &buffer };
+    return buffer;
+}
+
+void Tracer::record(TraceEvent &&event) {
+    Buffer &buffer = getBuffer();
+    // Only contended while the events are being copied out
+    lock_guard<mutex> guard(buffer.lock);
+    buffer.thread.events.push_back(move(event));
+}
+
+vector<TraceThread> Tracer::getThreads() const {
+    lock_guard<mutex> guard(lock);
+    vector<TraceThread> threads;
+    for (const auto &buffer : buffers) {
+        lock_guard<mutex> bufferGuard(buffer->lock);
+        threads.push_back(buffer->thread);
+    }
+    return threads;
+}
+
+TraceSpan::TraceSpan(Tracer *tracer, const string &name, const string &category) : tracer(tracer) {
+    if (tracer != nullptr) {
+        event.name = name;
+        event.category = category;
+        event.start = tracer->now();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (tracer != nullptr) {
+        event.duration = tracer->now() - event.start;
+        tracer->record(move(event));
+    }
+}
+
+void TraceSpan::addArgument(const string &key, const uint64_t value) {
+    if (tracer != nullptr) {
+        event.arguments.push_back({ key, to_string(value), true });
+    }
+}
+
+void TraceSpan::addArgument(const string &key, const string &value) {
+    if (tracer != nullptr) {
+        event.arguments.push_back({ key, value, false });
+    }
+}
+}
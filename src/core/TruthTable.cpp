@@ -40,7 +40,7 @@ static bool containsDuplicates(const TContainer &container) {
     return false;
 }
 
-TruthTable::TruthTable(const vector<string> &variables) : variables(variables), values(pow(2, variables.size()), false) {
+TruthTable::TruthTable(const vector<string> &variables) : variables(variables) {
     if (variables.size() == 0 || variables.size() > MAX_NUM_VARIABLES) {
         throw invalid_argument("variables' size needs to be 0 < n <= " + to_string(MAX_NUM_VARIABLES));
     }
@@ -48,6 +48,9 @@ TruthTable::TruthTable(const vector<string> &variables) : variables(variables),
     if (containsDuplicates<vector<string>, string>(variables)) {
         throw invalid_argument("TruthTable cannot contain duplicate variables");
     }
+
+    // Only allocated once the variables are known to be valid, as a bad table can be too large to allocate
+    values.assign((size_t) (getValuesMemoryUsage(size()) / sizeof(uint64_t)), 0);
 }
 
 __TruthTableValueProxy TruthTable::operator[](const TruthTableUInt index) {
@@ -57,27 +60,129 @@ __TruthTableValueProxy TruthTable::operator[](const TruthTableUInt index) {
 
 bool TruthTable::operator[](const TruthTableUInt index) const {
     validateIndex(index);
-    return values[index];
+    return ((values[index / 64] >> (index % 64)) & 1) == 1;
 }
 
-vector<TruthTableUInt> TruthTable::getMinterms() const {
-    vector<TruthTableUInt> minterms;
-    for (TruthTableUInt i = 0; i < size(); ++i) {
-        if ((*this)[i]) {
-             minterms.push_back(i);
+// The lines whose values are the given one, a word at a time
+static vector<TruthTableUInt> getLinesWithValue(const vector<uint64_t> &values, const TruthTableUInt size, const bool value) {
+    vector<TruthTableUInt> lines;
+    const uint64_t lastWordMask = size % 64 == 0 ? ~(uint64_t) 0 : (((uint64_t) 1) << (size % 64)) - 1;
+    for (size_t word = 0; word < values.size(); ++word) {
+        uint64_t bits = value ? values[word] : ~values[word];
+        if (word + 1 == values.size()) {
+            bits &= lastWordMask;
+        }
+        while (bits != 0) {
+            lines.push_back(word * 64 + (TruthTableUInt) __builtin_ctzll(bits));
+            bits &= bits - 1;
         }
     }
-    return minterms;
+    return lines;
 }
 
-vector<TruthTableUInt> TruthTable::getMaxterms() const {
-    vector<TruthTableUInt> maxterms;
-    for (TruthTableUInt i = 0; i < size(); ++i) {
-        if (!(*this)[i]) {
-             maxterms.push_back(i);
+TruthTableUInt TruthTable::count() const {
+    // The unused high bits of the last word are 0
+    TruthTableUInt count = 0;
+    for (const uint64_t word : values) {
+        count += (TruthTableUInt) __builtin_popcountll(word);
+    }
+    return count;
+}
+
+bool TruthTable::dependsOn(const TruthTableVariablesUInt column) const {
+    if (column >= variables.size()) {
+        throw out_of_range("column needs to be in range: [0, " + to_string(variables.size() - 1) + "]");
+    }
+
+    if (column < 6) {
+        // The lines of the column's cofactors are in the same word: the bits where the variable is 0, and the ones
+        // shifted down from where it's 1. The unused high bits are 0, and they're only ever compared to each other.
+        const unsigned shift = 1u << column;
+        const uint64_t mask = NEGATIVE_COFACTOR_MASKS[column];
+        for (const uint64_t word : values) {
+            if (((word ^ (word >> shift)) & mask) != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Else, they're whole words, a stride apart
+    const TruthTableUInt stride = ((TruthTableUInt) 1) << (column - 6);
+    for (TruthTableUInt i = 0; i < values.size(); i += 2 * stride) {
+        for (TruthTableUInt j = i; j < i + stride; ++j) {
+            if (values[j] != values[j + stride]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+TruthTable TruthTable::getCofactor(const TruthTableVariablesUInt column, const bool value) const {
+    if (column >= variables.size()) {
+        throw out_of_range("column needs to be in range: [0, " + to_string(variables.size() - 1) + "]");
+    }
+    if (variables.size() == 1) {
+        throw invalid_argument("The cofactor of a truth table of a single variable is a constant value.");
+    }
+
+    vector<string> cofactorVariables(variables);
+    cofactorVariables.erase(cofactorVariables.begin() + column);
+    TruthTable cofactor(cofactorVariables);
+    uint64_t *words = cofactor.getWords();
+    if (column >= 6) {
+        // Every other run of stride words
+        const TruthTableUInt stride = ((TruthTableUInt) 1) << (column - 6);
+        for (TruthTableUInt i = value ? stride : 0; i < values.size(); i += 2 * stride) {
+            copy(values.begin() + (long) i, values.begin() + (long) (i + stride), words);
+            words += stride;
+        }
+        return cofactor;
+    }
+
+    // The runs of 2^column bits are packed into the low half of the word, doubling the runs at every step, and the
+    // halves of every two words make one
+    const unsigned shift = 1u << column;
+    for (TruthTableUInt i = 0; i < values.size(); ++i) {
+        uint64_t bits = (value ? values[i] >> shift : values[i]) & NEGATIVE_COFACTOR_MASKS[column];
+        for (unsigned run = column; run < 5; ++run) {
+            bits = (bits | (bits >> (1u << run))) & NEGATIVE_COFACTOR_MASKS[run + 1];
         }
+        words[i / 2] |= bits << (32 * (i % 2));
     }
-    return maxterms;
+    return cofactor;
+}
+
+vector<string> TruthTable::getSupport() const {
+    vector<string> support;
+    for (TruthTableVariablesUInt i = 0; i < variables.size(); ++i) {
+        if (dependsOn(i)) {
+            support.push_back(variables[i]);
+        }
+    }
+    return support;
+}
+
+vector<TruthTableUInt> TruthTable::getMinterms() const {
+    return getLinesWithValue(values, size(), true);
+}
+
+vector<TruthTableUInt> TruthTable::getMaxterms() const {
+    return getLinesWithValue(values, size(), false);
+}
+
+uint64_t TruthTable::getMemoryUsage() const {
+    uint64_t bytes = getValuesMemoryUsage(size());
+    for (const string &variable : variables) {
+        bytes += variable.length();
+    }
+    return bytes;
+}
+
+uint64_t TruthTable::getValuesMemoryUsage(const TruthTableUInt size) {
+    // A bit per line, in 64 bit words
+    return (size / 64 + (size % 64 == 0 ? 0 : 1)) * sizeof(uint64_t);
 }
 
 template <typename TCollection, typename TValue>
@@ -119,6 +224,11 @@ bool operator==(const TruthTable &left, const TruthTable &right) {
         return false;
     }
 
+    if (left.getVariables() == right.getVariables()) {
+        // The unused bits are always 0, so the words can be compared as they are
+        return left.values == right.values;
+    }
+
     const vector<TruthTableVariablesUInt> matches = findMatches<vector<string>, string>(left.getVariables(), right.getVariables());
 
     for (TruthTableUInt i = 0; i < left.size(); ++i) {
@@ -131,6 +241,15 @@ bool operator==(const TruthTable &left, const TruthTable &right) {
     return true;
 }
 
+TruthTable TruthTable::reorder(const vector<string> &variables) const {
+    const vector<TruthTableVariablesUInt> matches = findMatches<vector<string>, string>(this->variables, variables);
+    TruthTable result(variables);
+    for (TruthTableUInt i = 0; i < size(); ++i) {
+        result[match(i, matches, (TruthTableVariablesUInt) variables.size())] = (*this)[i];
+    }
+    return result;
+}
+
 void TruthTable::validateIndex(const TruthTableUInt index) const {
     if (index >= size()) {
         throw out_of_range("index needs to be in range: [0, " + to_string(size() - 1) + "]");
@@ -193,21 +312,23 @@ void TruthTableCondition::process() {
         builder = nullptr;
     }
 
+    TruthTableUInt fixedColumns = 0;
+    TruthTableUInt fixedValues = 0;
+    for (const auto &condition : conditions) {
+        fixedColumns |= ((TruthTableUInt) 1) << condition.first;
+        fixedValues |= (condition.second ? (TruthTableUInt) 1 : (TruthTableUInt) 0) << condition.first;
+    }
+
+    // Only the lines that meet all the conditions are visited, so every condition halves the work: the free columns of
+    // the line index count up, in order, while the conditioned ones keep their values
+    const TruthTableUInt freeColumns = (table->size() - 1) & ~fixedColumns;
     TruthTableUInt newTable = 0;
+    TruthTableUInt freeValues = 0;
     builder = new TruthTableBuilder();
-    for (TruthTableUInt i = 0; i < table->size(); ++i) {
-        bool allConditionsMet = true;
-        for (const auto &condition : conditions) {
-            if ((bool) ((i >> condition.first) & 1) != condition.second) {
-                allConditionsMet = false;
-                break;
-            }
-        }
-
-        if (allConditionsMet) {
-            builder->set(newTable++, (*table)[i]);
-        }
-    }
+    do {
+        builder->set(newTable++, (*table)[freeValues | fixedValues]);
+        freeValues = (freeValues - freeColumns) & freeColumns;
+    } while (freeValues != 0);
 
     vector<string> newVariables;
     for (TruthTableVariablesUInt i = 0; i < table->getVariables().size(); ++i) {
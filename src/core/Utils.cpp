@@ -16,6 +16,9 @@
 
 #include <core/Utils.hpp>
 #include <core/Exceptions.hpp>
+#include <iomanip>
+#include <limits>
+#include <unistd.h>
 
 using namespace std;
 
@@ -58,6 +61,41 @@ namespace Logic {
         return str.substr(first, (last-first+1));
     }
 
+    string formatBytes(const uint64_t bytes) {
+        static const char *units[] = { "B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
+        double scaled = (double) bytes;
+        size_t unit = 0;
+        while (scaled >= 1024 && unit < sizeof(units) / sizeof(units[0]) - 1) {
+            scaled /= 1024;
+            ++unit;
+        }
+        stringstream formatted;
+        formatted << fixed << setprecision(unit == 0 ? 0 : 2) << scaled << ' ' << units[unit];
+        return formatted.str();
+    }
+
+    string formatDuration(const uint64_t nanoseconds) {
+        static const char *units[] = { "ns", "us", "ms", "s" };
+        double scaled = (double) nanoseconds;
+        size_t unit = 0;
+        while (scaled >= 1000 && unit < sizeof(units) / sizeof(units[0]) - 1) {
+            scaled /= 1000;
+            ++unit;
+        }
+        stringstream formatted;
+        formatted << fixed << setprecision(unit == 0 ? 0 : 2) << scaled << ' ' << units[unit];
+        return formatted.str();
+    }
+
+    uint64_t getPhysicalMemory() {
+        const long pages = sysconf(_SC_PHYS_PAGES);
+        const long pageSize = sysconf(_SC_PAGE_SIZE);
+        if (pages <= 0 || pageSize <= 0) {
+            return numeric_limits<uint64_t>::max();
+        }
+        return (uint64_t) pages * (uint64_t) pageSize;
+    }
+
     vector<string> split(string str, const char delim) {
         return split(str, string(1, delim));
     }
@@ -18,9 +18,17 @@
 #include <regex>
 #include <core/BooleanFunctionParser.hpp>
 #include <lang/Exceptions.hpp>
+#include <lang/Json.hpp>
 #include <core/Utils.hpp>
+#include <core/Bitmap.hpp>
+#include <core/CodeGenerator.hpp>
 #include <core/Operators.hpp>
+#include <core/Profiler.hpp>
+#include <core/Tracer.hpp>
 #include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <limits>
 #include <sstream>
 #include <utility>
 
@@ -30,8 +38,16 @@ namespace Logic {
 static const string ELSE_ALLOWED = "else_allowed";
 static const string RUN_ELSE = "run_else";
 
+// The runtime's options, with the memory budget limited to what's available to the workspace, and the machine
+static EvaluationOptions getEvaluationOptions(const Runtime &runtime) {
+    static const uint64_t physicalMemory = getPhysicalMemory();
+    EvaluationOptions options = runtime.getEvaluationOptions();
+    options.memoryBudget = min(options.memoryBudget, min(runtime.getAvailableMemory(), physicalMemory));
+    return options;
+}
+
 BooleanFunction parse(const string &expression, const Runtime &runtime) {
-    return BooleanFunctionParser().parse(expression, [&](const string &functionName) -> const BooleanFunction& {
+    return BooleanFunctionParser(getEvaluationOptions(runtime)).parse(expression, [&](const string &functionName) -> const BooleanFunction& {
         return runtime.get(functionName);
     });
 }
@@ -44,6 +60,18 @@ bool Command::execute(const string &args, Runtime &runtime, ostream &out, functi
     return true;
 }
 
+vector<string> Command::getReferencedFunctions(const string &args) const {
+    static const regex referenceRegex("[\\$](" + VARIABLE_REGEX + ")");
+    vector<string> references;
+    for (sregex_iterator it(args.begin(), args.end(), referenceRegex); it != sregex_iterator(); ++it) {
+        const string name = (*it)[1];
+        if (!contains(references, name)) {
+            references.push_back(name);
+        }
+    }
+    return references;
+}
+
 bool QuitCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
     Command::execute(args, runtime, out, interpreter);
     UNUSED(out);
@@ -56,26 +84,45 @@ bool QuitCommand::execute(const string &args, Runtime &runtime, ostream &out, fu
     return false;
 }
 
+// Splits the args of a let into its sides. False if there's no '='.
+static bool splitLetArgs(const string &args, string &lhs, string &rhs) {
+    static const regex createArgsRegex("\\s*(.+?)\\s*[=]\\s*(.+)\\s*");
+    smatch sm;
+    if (!regex_match(args, sm, createArgsRegex, regex_constants::match_continuous)) {
+        return false;
+    }
+    lhs = sm[1];
+    rhs = sm[2];
+    return true;
+}
+
+string LetCommand::getDefinedFunction(const string &args) const {
+    static const regex variableNameRegex(VARIABLE_REGEX);
+    string lhs;
+    string rhs;
+    return splitLetArgs(args, lhs, rhs) && regex_match(lhs, variableNameRegex) ? lhs : "";
+}
+
+bool LetCommand::isIsolated(const string &args) const {
+    return !getDefinedFunction(args).empty();
+}
+
 bool LetCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
     Command::execute(args, runtime, out, interpreter);
     UNUSED(out);
     UNUSED(interpreter);
 
-    static const regex createArgsRegex("\\s*(.+?)\\s*[=]\\s*(.+)\\s*");
-    smatch sm;
-    if (regex_match(args, sm, createArgsRegex, regex_constants::match_continuous)) {
-        string lhs = sm[1];
-        string rhs = sm[2];
-
-        static regex variableNameRegex(VARIABLE_REGEX);
-        sm = smatch();
-        if (regex_match(lhs, sm, variableNameRegex, regex_constants::match_continuous)) {
-            runtime.save(lhs, parse(rhs, runtime));
+    string lhs;
+    string rhs;
+    if (splitLetArgs(args, lhs, rhs)) {
+        const string definedFunction = getDefinedFunction(args);
+        if (!definedFunction.empty()) {
+            runtime.save(definedFunction, parse(rhs, runtime));
             return true;
         }
 
         static regex indexAccessRegex("[\\$]{1}(" + VARIABLE_REGEX + ")" + "[\\s]*" + INDEX_REGEX + "[\\s]*");
-        sm = smatch();
+        smatch sm;
         if (regex_match(lhs, sm, indexAccessRegex, regex_constants::match_continuous)) {
             string variableName = sm[1];
             TruthTableUInt truthTableIndex = stoul(sm[2]);
@@ -91,7 +138,12 @@ bool PrintBooleanFunctionCommand::execute(const string &expression, Runtime &run
     Command::execute(expression, runtime, out, interpreter);
     UNUSED(interpreter);
 
-    out << parse(expression, runtime) << endl;
+    const BooleanFunction function = parse(expression, runtime);
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << toJson(function) << endl;
+    } else {
+        out << function << endl;
+    }
     return true;
 }
 
@@ -108,7 +160,12 @@ bool PrintMaxtermsCommand::execute(const string &expression, Runtime &runtime, o
     Command::execute(expression, runtime, out, interpreter);
     UNUSED(interpreter);
 
-    out << join(parse(expression, runtime).getTruthTable().getMaxterms(), ", ") << endl;
+    const vector<TruthTableUInt> maxterms = parse(expression, runtime).getTruthTable().getMaxterms();
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << toJson(maxterms) << endl;
+    } else {
+        out << join(maxterms, ", ") << endl;
+    }
     return true;
 }
 
@@ -116,7 +173,12 @@ bool PrintMintermsCommand::execute(const string &expression, Runtime &runtime, o
     Command::execute(expression, runtime, out, interpreter);
     UNUSED(interpreter);
 
-    out << join(parse(expression, runtime).getTruthTable().getMinterms(), ", ") << endl;
+    const vector<TruthTableUInt> minterms = parse(expression, runtime).getTruthTable().getMinterms();
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << toJson(minterms) << endl;
+    } else {
+        out << join(minterms, ", ") << endl;
+    }
     return true;
 }
 
@@ -125,9 +187,333 @@ bool PrintVariablesCommand::execute(const string &expression, Runtime &runtime,
     UNUSED(interpreter);
 
     vector<string> variables = parse(expression, runtime).getTruthTable().getVariables();
-    // This is how the variables are shown in the truth table -- little endian
-    reverse(variables.begin(), variables.end());
-    out << join(variables, ", ") << endl;
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        // Same order as in the JSON truth tables
+        out << toJson(variables) << endl;
+    } else {
+        // This is how the variables are shown in the truth table -- little endian
+        reverse(variables.begin(), variables.end());
+        out << join(variables, ", ") << endl;
+    }
+    return true;
+}
+
+bool SupportCommand::execute(const string &expression, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(expression, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    // Same as the variables command, but only the ones that the function depends on
+    const BooleanFunction function = parse(expression, runtime);
+    vector<string> support = function.hasTruthTable() ? function.getTruthTable().getSupport() : vector<string>();
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << toJson(support) << endl;
+    } else {
+        reverse(support.begin(), support.end());
+        out << join(support, ", ") << endl;
+    }
+    return true;
+}
+
+bool StatsCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(args, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    Profiler *profiler = runtime.getEvaluationOptions().profiler;
+    if (profiler == nullptr) {
+        throw CommandNotAllowedException("'stats' command needs the profiling to be enabled with --profile.");
+    }
+
+    if (args == "reset") {
+        profiler->reset();
+    } else if (args.length() != 0) {
+        throw BadCommandArgumentsException("Unknown args to command 'stats': " + args);
+    } else if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << toJson(*profiler) << endl;
+    } else {
+        out << *profiler << endl;
+    }
+    return true;
+}
+
+static size_t getNumVariables(const BooleanFunction &function) {
+    return function.hasTruthTable() ? function.getTruthTable().getVariables().size() : 0;
+}
+
+bool MemCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(args, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    static const size_t DEFAULT_COUNT = 10;
+    size_t count = DEFAULT_COUNT;
+    if (args.length() != 0) {
+        static const regex countRegex("[\\d]+");
+        if (!regex_match(args, countRegex)) {
+            throw BadCommandArgumentsException("Unknown args to command 'mem': " + args);
+        }
+        count = stoul(args);
+    }
+
+    const vector<pair<string, uint64_t>> functions = runtime.getFunctionsByMemoryUsage();
+    const bool limited = runtime.getMaxMemory() != numeric_limits<uint64_t>::max();
+    const size_t shown = min(count, functions.size());
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{\"total_bytes\":" << runtime.getMemoryUsage()
+            << ",\"max_bytes\":" << (limited ? to_string(runtime.getMaxMemory()) : "null")
+            << ",\"functions\":[";
+        for (size_t i = 0; i < shown; ++i) {
+            out << (i == 0 ? "" : ",") << "{\"name\":" << toJson(functions[i].first)
+                << ",\"bytes\":" << functions[i].second
+                << ",\"variables\":" << getNumVariables(runtime.get(functions[i].first)) << "}";
+        }
+        out << "]}" << endl;
+        return true;
+    }
+
+    out << "Workspace: " << formatBytes(runtime.getMemoryUsage()) << " in " << functions.size() << (functions.size() == 1 ? " function" : " functions");
+    if (limited) {
+        out << " (limit: " << formatBytes(runtime.getMaxMemory()) << ")";
+    }
+    out << endl;
+    for (size_t i = 0; i < shown; ++i) {
+        out << "  " << setw(12) << formatBytes(functions[i].second) << "  " << functions[i].first
+            << " (" << getNumVariables(runtime.get(functions[i].first)) << " variables)" << endl;
+    }
+    if (shown < functions.size()) {
+        out << "  ... and " << functions.size() - shown << " more" << endl;
+    }
+    return true;
+}
+
+struct ExplainStep {
+    const Expression *expression;
+    vector<size_t> inputs;
+    // If set, only a single line of this node is evaluated
+    bool atPoint;
+
+    TruthTableUInt getRows() const {
+        return atPoint ? 1 : expression->size();
+    }
+
+    uint64_t getBytes() const {
+        return atPoint ? 0 : expression->getResultMemoryUsage();
+    }
+
+    TruthTableUInt getWork() const {
+        return atPoint ? 1 : expression->estimateWork();
+    }
+};
+
+// Lists the nodes in the order they're evaluated in, each after its inputs. Returns the node's step number.
+static size_t getExplainSteps(const Expression &expression, bool atPoint, vector<ExplainStep> &steps) {
+    vector<size_t> inputs;
+    if (const UnaryOperatorExpression *unary = dynamic_cast<const UnaryOperatorExpression *>(&expression)) {
+        atPoint = atPoint && unary->getOperator().canEvaluateAt();
+        inputs.push_back(getExplainSteps(unary->getOperand(), atPoint || unary->isPointEvaluated(), steps));
+    } else if (const BinaryOperatorExpression *binary = dynamic_cast<const BinaryOperatorExpression *>(&expression)) {
+        atPoint = atPoint && binary->getOperator().canEvaluateAt();
+        inputs.push_back(getExplainSteps(binary->getFirst(), atPoint, steps));
+        inputs.push_back(getExplainSteps(binary->getSecond(), atPoint, steps));
+    } else if (const FusedOperatorExpression *fused = dynamic_cast<const FusedOperatorExpression *>(&expression)) {
+        for (const unique_ptr<Expression> &operand : fused->getOperands()) {
+            inputs.push_back(getExplainSteps(*operand, atPoint, steps));
+        }
+    }
+    steps.push_back({ &expression, inputs, atPoint });
+    return steps.size();
+}
+
+static string getExplainVariables(const vector<string> &variables) {
+    static const size_t MAX_SHOWN = 8;
+    if (variables.size() <= MAX_SHOWN) {
+        return join(variables, ", ");
+    }
+    return join(vector<string>(variables.begin(), variables.begin() + MAX_SHOWN), ", ") +
+           ", ... (" + to_string(variables.size()) + " variables)";
+}
+
+bool ExplainCommand::execute(const string &expression, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(expression, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    const EvaluationOptions options = getEvaluationOptions(runtime);
+    const unique_ptr<Expression> compiled = BooleanFunctionParser(options).compile(expression, [&](const string &functionName) -> const BooleanFunction& {
+        return runtime.get(functionName);
+    });
+    vector<ExplainStep> steps;
+    getExplainSteps(*compiled, false, steps);
+    const uint64_t peakMemory = compiled->estimatePeakMemoryUsage();
+    const uint64_t duration = (uint64_t) Expression::estimateDuration(compiled->estimateTotalWork()).count();
+    const bool fits = peakMemory <= options.memoryBudget;
+
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{\"steps\":[";
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const Expression &step = *steps[i].expression;
+            out << (i == 0 ? "" : ",") << "{\"step\":" << i + 1
+                << ",\"operation\":" << toJson(step.getDescription())
+                << ",\"inputs\":[" << join(steps[i].inputs, ",") << "]"
+                << ",\"variables\":" << toJson(step.getVariables())
+                << ",\"rows\":" << steps[i].getRows()
+                << ",\"bytes\":" << steps[i].getBytes()
+                << ",\"time_ns\":" << Expression::estimateDuration(steps[i].getWork()).count() << "}";
+        }
+        out << "],\"peak_bytes\":" << peakMemory
+            << ",\"time_ns\":" << duration
+            << ",\"available_bytes\":" << options.memoryBudget
+            << ",\"fits\":" << (fits ? "true" : "false") << "}" << endl;
+        return true;
+    }
+
+    const ios::fmtflags flags = out.flags();
+    out << left << setw(6) << "step" << setw(28) << "operation" << setw(10) << "inputs" << right << setw(22) << "rows"
+        << setw(12) << "bytes" << setw(16) << "time" << "  variables" << endl;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const Expression &step = *steps[i].expression;
+        const bool isLeaf = steps[i].inputs.empty();
+        out << left << setw(6) << i + 1 << setw(28) << step.getDescription() << setw(10) << join(steps[i].inputs, ", ")
+            << right << setw(22) << steps[i].getRows() << setw(12) << formatBytes(steps[i].getBytes())
+            << setw(16) << (isLeaf ? "-" : formatDuration((uint64_t) Expression::estimateDuration(steps[i].getWork()).count()))
+            << "  " << getExplainVariables(step.getVariables()) << endl;
+    }
+    out.flags(flags);
+    out << "Estimated peak memory: " << formatBytes(peakMemory) << ", time: " << formatDuration(duration) << endl;
+    if (!fits) {
+        out << "Would fail: only " << formatBytes(options.memoryBudget) << " of memory is available" << endl;
+    }
+    return true;
+}
+
+bool CountCommand::execute(const string &expression, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(expression, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    const EvaluationOptions options = getEvaluationOptions(runtime);
+    const unique_ptr<Expression> compiled = BooleanFunctionParser(options).compile(expression, [&](const string &functionName) -> const BooleanFunction& {
+        return runtime.get(functionName);
+    });
+    const TruthTableUInt lines = count(*compiled, options);
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{\"count\":" << lines << ",\"variables\":" << compiled->getVariables().size() << "}" << endl;
+    } else {
+        out << lines << endl;
+    }
+    return true;
+}
+
+// Prints whether the property holds, and the line that shows it, if found: "1 [a = 1, b = 0]", with the values of the
+// expression's variables in the same form as the conditions that select it
+static void printCheck(const string &property, const bool holds, const string &lineName, const bool found,
+                       const VariableAssignment &line, const vector<string> &variables, Runtime &runtime, ostream &out) {
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{" << toJson(property) << ":" << (holds ? "true" : "false");
+        if (found) {
+            out << "," << toJson(lineName) << ":{";
+            for (size_t i = 0; i < variables.size(); ++i) {
+                out << (i == 0 ? "" : ",") << toJson(variables[i]) << ":" << (line.at(variables[i]) ? "true" : "false");
+            }
+            out << "}";
+        }
+        out << "}" << endl;
+        return;
+    }
+
+    out << (holds ? "1" : "0");
+    if (found && !variables.empty()) {
+        vector<string> values;
+        for (const string &variable : variables) {
+            values.push_back(variable + " = " + (line.at(variable) ? "1" : "0"));
+        }
+        out << " [" << join(values, ", ") << "]";
+    }
+    out << endl;
+}
+
+bool SatCommand::execute(const string &expression, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(expression, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    const EvaluationOptions options = getEvaluationOptions(runtime);
+    const unique_ptr<Expression> compiled = BooleanFunctionParser(options).compile(expression, [&](const string &functionName) -> const BooleanFunction& {
+        return runtime.get(functionName);
+    });
+    VariableAssignment witness;
+    const bool satisfiable = isSatisfiable(*compiled, witness, options);
+    printCheck("satisfiable", satisfiable, "witness", satisfiable, witness, compiled->getVariables(), runtime, out);
+    return true;
+}
+
+bool TautCommand::execute(const string &expression, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(expression, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    const EvaluationOptions options = getEvaluationOptions(runtime);
+    const unique_ptr<Expression> compiled = BooleanFunctionParser(options).compile(expression, [&](const string &functionName) -> const BooleanFunction& {
+        return runtime.get(functionName);
+    });
+    VariableAssignment counterexample;
+    const bool tautology = isTautology(*compiled, counterexample, options);
+    printCheck("tautology", tautology, "counterexample", !tautology, counterexample, compiled->getVariables(), runtime, out);
+    return true;
+}
+
+bool BitmapCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(args, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    // <output> = <expression> with <variable> = <column>, ... The expression ends at the last "with".
+    static const regex bitmapArgsRegex("\\s*(\\S+?)\\s*[=]\\s*(.+)\\s+with\\s+(.+?)\\s*");
+    smatch sm;
+    if (!regex_match(args, sm, bitmapArgsRegex)) {
+        throw BadCommandArgumentsException("Unknown args to command 'bitmap': " + args);
+    }
+    const string outputPath = sm[1];
+    const string expression = sm[2];
+
+    static const regex bindingRegex("\\s*(" + VARIABLE_REGEX + ")\\s*[=]\\s*(.*?)\\s*");
+    unordered_map<string, string> columns;
+    for (const string &binding : split(sm[3], ',')) {
+        smatch bindingMatch;
+        if (!regex_match(binding, bindingMatch, bindingRegex) || bindingMatch[2].length() == 0) {
+            throw BadCommandArgumentsException("Bad column binding to command 'bitmap': " + binding);
+        }
+        if (!columns.emplace(bindingMatch[1], bindingMatch[2]).second) {
+            throw BadCommandArgumentsException("The variable " + string(bindingMatch[1]) + " is bound more than once.");
+        }
+    }
+
+    const EvaluationOptions options = getEvaluationOptions(runtime);
+    const BitmapEvaluationResult result = evaluateBitmaps(parse(expression, runtime), columns, outputPath, options.threadPool);
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{\"output\":" << toJson(outputPath) << ",\"records\":" << result.numRecords
+            << ",\"count\":" << result.count << "}" << endl;
+    } else {
+        out << result.count << " of " << result.numRecords << " records" << endl;
+    }
+    return true;
+}
+
+bool EmitCommand::execute(const string &args, Runtime &runtime, ostream &out, function<bool (istream &)> interpreter) {
+    Command::execute(args, runtime, out, interpreter);
+    UNUSED(interpreter);
+
+    static const regex emitArgsRegex("\\s*(\\S+)\\s+(.+?)\\s*");
+    smatch sm;
+    if (!regex_match(args, sm, emitArgsRegex)) {
+        throw BadCommandArgumentsException("Unknown args to command 'emit': " + args);
+    } else if (sm[1] != "c") {
+        throw BadCommandArgumentsException("Unknown language to command 'emit': " + string(sm[1]) + ". Only c is supported.");
+    }
+    const string expression = sm[2];
+
+    // A function emitted by its reference keeps its name
+    static const regex referenceRegex("[\\$](" + VARIABLE_REGEX + ")");
+    const string name = regex_match(expression, sm, referenceRegex) ? string(sm[1]) : "function";
+    const string source = generateC(parse(expression, runtime), name);
+    if (runtime.getOutputFormat() == OutputFormat::Json) {
+        out << "{\"language\":\"c\",\"source\":" << toJson(source) << "}" << endl;
+    } else {
+        out << source;
+    }
     return true;
 }
 
@@ -156,6 +542,7 @@ bool IfCommand::execute(const string &args, Runtime &runtime, ostream &out, func
 
     bool _continue = true;
     if (conditionFunction.getConstantValue()) {
+        TraceSpan span(runtime.getEvaluationOptions().tracer, "if block", "block");
         stringstream ss;
         ss << parsedArgs.second;
         _continue = interpreter(ss);
@@ -175,7 +562,7 @@ bool WhileCommand::execute(const string &args, Runtime &runtime, ostream &out, f
 
     const auto parsedArgs = getConditionalCommandArgs(args, "while");
 
-    while (true) {
+    for (uint64_t iteration = 0; ; ++iteration) {
         BooleanFunction conditionFunction = parse(parsedArgs.first, runtime);
         if (!conditionFunction.isConstant()) {
             throw BadCommandArgumentsException("The condition to the 'while' command needs to evaluate to a constant value Boolean function.");
@@ -185,6 +572,8 @@ bool WhileCommand::execute(const string &args, Runtime &runtime, ostream &out, f
             break;
         }
 
+        TraceSpan span(runtime.getEvaluationOptions().tracer, "while iteration", "block");
+        span.addArgument("iteration", iteration);
         stringstream ss;
         ss << parsedArgs.second;
         if (!interpreter(ss)) {
@@ -234,6 +623,7 @@ bool ElseCommand::execute(const string &args, Runtime &runtime, ostream &out, fu
         throw BadCommandArgumentsException("Expected a conditional 'if' or unconditional block after the 'else' command.");
     }
 
+    TraceSpan span(runtime.getEvaluationOptions().tracer, "else block", "block");
     return interpreter(ss);
 }
 }
@@ -20,17 +20,26 @@
 using namespace std;
 
 namespace Logic {
-void DispatchTable::registerCommand(const vector<string> &symbols, function<unique_ptr<Command> ()> commandFactory) {
+void DispatchTable::registerCommand(const vector<string> &symbols, shared_ptr<Command> command) {
     for (const string &symbol : symbols) {
-        table[symbol] = commandFactory;
+        table[symbol] = command;
+        names[symbol] = symbols.front();
     }
 }
 
-unique_ptr<Command> DispatchTable::getCommand(const string &token) {
+Command &DispatchTable::getCommand(const string &token) {
     const auto search = table.find(token);
     if (search == table.end()) {
         throw UnknownCommandException("Unknown command: " + token);
     }
-    return search->second();
+    return *search->second;
+}
+
+const string &DispatchTable::getCommandName(const string &token) const {
+    const auto search = names.find(token);
+    if (search == names.end()) {
+        throw UnknownCommandException("Unknown command: " + token);
+    }
+    return search->second;
 }
 }
@@ -19,6 +19,13 @@
 #include <core/Utils.hpp>
 #include <lang/Exceptions.hpp>
 #include <sstream>
+#include <memory>
+#include <future>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+#include <core/Profiler.hpp>
+#include <core/Tracer.hpp>
 
 using namespace std;
 
@@ -102,22 +109,257 @@ void Interpreter::start() {
     printPromptsIfNeeded();
 }
 
+// Splits a line into the command name and its args
+static pair<string, string> splitStatement(const string &line) {
+    uint64_t argLocation = 0;
+    for (; argLocation < line.length() && !isWhitespace(line.at(argLocation)); ++argLocation);
+
+    return make_pair(line.substr(0, argLocation), trim(line.substr(argLocation, string::npos)));
+}
+
+// Executes the statement, reporting it to the observer and the runtime's profiler and tracer, if any
+static bool executeStatement(Command &command, const string &commandName, const string &args, Runtime &runtime, ostream &out,
+                             function<bool (istream &)> interpreter, CommandObserver *observer) {
+    Profiler *profiler = runtime.getEvaluationOptions().profiler;
+    Tracer *tracer = runtime.getEvaluationOptions().tracer;
+    if (observer == nullptr && profiler == nullptr && tracer == nullptr) {
+        return command.execute(args, runtime, out, interpreter);
+    }
+
+    TraceSpan span(tracer, commandName, "statement");
+    span.addArgument("args", args);
+
+    // The counters of a nested statement also count towards the statement it's nested in
+    ProfileCounters *parentCounters = Profiler::getCurrentCounters();
+    ProfileCounters counters;
+    const auto start = chrono::steady_clock::now();
+    unique_ptr<ProfileMeasurement> measurement(profiler == nullptr ? nullptr : new ProfileMeasurement(*profiler));
+    auto finish = [&]() {
+        if (observer != nullptr) {
+            observer->onCommandExecuted(commandName, chrono::steady_clock::now() - start);
+        }
+        if (profiler != nullptr) {
+            profiler->recordCommand(commandName, *measurement, counters);
+            if (parentCounters != nullptr) {
+                parentCounters->rows += counters.rows;
+                parentCounters->resultBytes += counters.resultBytes;
+            }
+        }
+    };
+
+    bool _continue;
+    try {
+        ScopedProfileCounters scope(&counters);
+        _continue = command.execute(args, runtime, out, interpreter);
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    return _continue;
+}
+
 bool Interpreter::executeCode(istream &in) {
     string line;
     while ((line = nextLine(in)).length() > 0) {
-        uint64_t argLocation = 0;
-        for (; argLocation < line.length() && !isWhitespace(line.at(argLocation)); ++argLocation);
-
-        string commandName = line.substr(0, argLocation);
-        string args = trim(line.substr(argLocation, string::npos));
-        if (!dispatchTable.getCommand(commandName)->execute(args, runtime, out, [&](istream &in) { return executeCode(in); })) {
+        const auto statement = splitStatement(line);
+        if (!executeStatement(dispatchTable.getCommand(statement.first), dispatchTable.getCommandName(statement.first), statement.second,
+                              runtime, out, [&](istream &in) { return executeCode(in); }, observer)) {
             return false;
         }
     }
     return true;
 }
 
+// Records what a statement reports to the observer, to report it once the statement is known to be a part of the
+// sequential execution
+class RecordingObserver : public CommandObserver {
+public:
+    virtual void onCommandExecuted(const string &command, const chrono::steady_clock::duration &elapsed) {
+        executed.push_back(make_pair(command, elapsed));
+    }
+
+    vector<pair<string, chrono::steady_clock::duration>> executed;
+};
+
+// A statement that is executed concurrently with its neighbours
+struct ScheduledStatement {
+    // The position of the statement in its batch
+    size_t index = 0;
+    // The function defined by this statement. Empty if the statement only reads from the runtime.
+    string definedFunction;
+    // The private runtime that the statement is executed against. It references the functions the statement
+    // references, and once it is done, holds the function it defines.
+    Runtime scope;
+    stringstream out;
+    // What the statement reported to the observer and the profiler. A statement may already be running when an
+    // earlier one fails, so these are only applied once it's known that it would've run in a sequential execution.
+    RecordingObserver observed;
+    unique_ptr<Profiler> profiler;
+    // False if the statement was skipped, because an earlier one failed
+    bool executed = false;
+    shared_future<void> done;
+};
+
+// Lowers the index of the first failed statement to the given one, if it's earlier
+static void setFailure(atomic<size_t> &firstFailure, const size_t index) {
+    size_t failure = firstFailure.load();
+    while (index < failure && !firstFailure.compare_exchange_weak(failure, index));
+}
+
+bool Interpreter::executeCodeConcurrently(istream &in) {
+    // The statements scheduled since the last barrier, in the program order
+    vector<shared_ptr<ScheduledStatement>> batch;
+    // The latest statement in the batch defining a function
+    unordered_map<string, shared_ptr<ScheduledStatement>> definitions;
+    // The index of the first statement in the batch that failed, if any. The statements after it are skipped, unless
+    // they've already started, and their results are discarded.
+    atomic<size_t> firstFailure(numeric_limits<size_t>::max());
+
+    // Waits for the batch, and then applies the results to the runtime, the output, the observer and the profiler in
+    // the program order. The first failed statement's error is rethrown after the statements before it are applied.
+    auto commitBatch = [&]() {
+        vector<shared_ptr<ScheduledStatement>> statements;
+        statements.swap(batch);
+        definitions.clear();
+
+        // The scheduled statements read from the runtime, so it cannot be touched until all of them are done
+        for (const auto &statement : statements) {
+            statement->done.wait();
+        }
+        firstFailure = numeric_limits<size_t>::max();
+
+        if (!statements.empty()) {
+            // Same as what each of these commands would've done to the runtime
+            runtime.clearFlags();
+        }
+
+        Profiler *profiler = runtime.getEvaluationOptions().profiler;
+        for (const auto &statement : statements) {
+            // The failed statement is reported too, like in a sequential execution, but none after it
+            if (statement->executed) {
+                if (observer != nullptr) {
+                    for (const auto &executed : statement->observed.executed) {
+                        observer->onCommandExecuted(executed.first, executed.second);
+                    }
+                }
+                if (profiler != nullptr) {
+                    profiler->add(*statement->profiler);
+                }
+            }
+            statement->done.get();
+            out << statement->out.str();
+            if (!statement->definedFunction.empty()) {
+                const BooleanFunction &function = statement->scope.get(statement->definedFunction);
+                const uint64_t replaced = runtime.contains(statement->definedFunction) ? runtime.get(statement->definedFunction).getMemoryUsage() : 0;
+                if (runtime.getMemoryUsage() - replaced + function.getMemoryUsage() > runtime.getMaxMemory()) {
+                    throw MemoryLimitExceededException("Saving " + statement->definedFunction + " needs " + formatBytes(function.getMemoryUsage()) +
+                                                       " of memory, but only " + formatBytes(runtime.getAvailableMemory() + replaced) + " is available.");
+                }
+                runtime.save(statement->definedFunction, function);
+            }
+        }
+    };
+
+    try {
+        string line;
+        while ((line = nextLine(in)).length() > 0) {
+            if (firstFailure.load() != numeric_limits<size_t>::max()) {
+                // Nothing after a failed statement is scheduled. Rethrows its error.
+                commitBatch();
+            }
+
+            const auto statement = splitStatement(line);
+            Command &command = dispatchTable.getCommand(statement.first);
+            const string commandName = dispatchTable.getCommandName(statement.first);
+
+            // Under a memory limit, what a statement may allocate depends on the functions saved before it, so the ones
+            // that save a function are executed one at a time, as in a sequential execution. The rest can't change it.
+            const bool limited = runtime.getMaxMemory() != numeric_limits<uint64_t>::max();
+            if (!command.isIsolated(statement.second) || (limited && !command.getDefinedFunction(statement.second).empty())) {
+                // Anything else may read or modify the whole runtime (or the flags), so it acts as a barrier
+                commitBatch();
+                if (!executeStatement(command, commandName, statement.second, runtime, out, [&](istream &in) { return executeCode(in); }, observer)) {
+                    return false;
+                }
+                continue;
+            }
+
+            shared_ptr<ScheduledStatement> scheduled = make_shared<ScheduledStatement>();
+            scheduled->index = batch.size();
+            scheduled->definedFunction = command.getDefinedFunction(statement.second);
+            EvaluationOptions options = runtime.getEvaluationOptions();
+            if (options.profiler != nullptr) {
+                scheduled->profiler.reset(new Profiler(options.profiler->usesHardwareCounters()));
+                options.profiler = scheduled->profiler.get();
+            }
+            scheduled->scope.setEvaluationOptions(options);
+            scheduled->scope.setOutputFormat(runtime.getOutputFormat());
+            scheduled->scope.setMaxMemory(runtime.getAvailableMemory());
+
+            // Each referenced function comes from either the latest statement in the batch that defines it, or the runtime
+            vector<pair<string, const ScheduledStatement *>> inputs;
+            for (const string &name : command.getReferencedFunctions(statement.second)) {
+                const auto found = definitions.find(name);
+                inputs.push_back(make_pair(name, found == definitions.end() ? nullptr : found->second.get()));
+            }
+
+            // Raw pointers are safe here, because commitBatch() outlives all the statements in the batch
+            ScheduledStatement *target = scheduled.get();
+            Command *targetCommand = &command;
+            const Runtime *base = &runtime;
+            atomic<size_t> *failure = &firstFailure;
+            const bool observed = observer != nullptr;
+            const string args = statement.second;
+            scheduled->done = threadPool->submit([target, targetCommand, commandName, base, args, inputs, failure, observed]() {
+                for (const auto &input : inputs) {
+                    if (input.second != nullptr) {
+                        input.second->done.wait();
+                    }
+                }
+                // A statement fails before it's done, so this also skips the statements that depend on a failed one
+                if (failure->load() < target->index) {
+                    return;
+                }
+
+                // The inputs are shared, since neither the runtime nor the finished statements change until the commit
+                for (const auto &input : inputs) {
+                    if (input.second != nullptr) {
+                        target->scope.reference(input.first, input.second->scope.get(input.first));
+                    } else if (base->contains(input.first)) {
+                        target->scope.reference(input.first, base->get(input.first));
+                    }
+                }
+                target->executed = true;
+                try {
+                    executeStatement(*targetCommand, commandName, args, target->scope, target->out, function<bool (istream &)>(),
+                                     observed ? &target->observed : nullptr);
+                } catch (...) {
+                    setFailure(*failure, target->index);
+                    throw;
+                }
+            }).share();
+
+            if (!scheduled->definedFunction.empty()) {
+                definitions[scheduled->definedFunction] = scheduled;
+            }
+            batch.push_back(scheduled);
+        }
+    } catch (...) {
+        // The statements scheduled before the failure come first in the program order, and so do their errors
+        commitBatch();
+        throw;
+    }
+
+    commitBatch();
+    return true;
+}
+
 void Interpreter::run() {
-    executeCode(this->in);
+    if (threadPool == nullptr) {
+        executeCode(this->in);
+    } else {
+        executeCodeConcurrently(this->in);
+    }
 }
 }
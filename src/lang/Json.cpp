@@ -0,0 +1,349 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <lang/Json.hpp>
+#include <core/Utils.hpp>
+#include <cctype>
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <stdint.h>
+
+using namespace std;
+
+namespace Logic {
+string toJson(const string &value) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    string result = "\"";
+    for (const char c : value) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    result += "\\u00";
+                    result += HEX_DIGITS[((unsigned char) c) >> 4];
+                    result += HEX_DIGITS[((unsigned char) c) & 0xf];
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
+string toJson(const vector<string> &values) {
+    vector<string> quoted;
+    for (const string &value : values) {
+        quoted.push_back(toJson(value));
+    }
+    return "[" + join(quoted, ",") + "]";
+}
+
+string toJson(const vector<TruthTableUInt> &values) {
+    return "[" + join(values, ",") + "]";
+}
+
+string toJson(const BooleanFunction &function) {
+    if (function.isConstant()) {
+        return string("{\"value\":") + (function.getConstantValue() ? "1" : "0") + "}";
+    }
+
+    const TruthTable &table = function.getTruthTable();
+    string values;
+    values.reserve(table.size());
+    for (TruthTableUInt i = 0; i < table.size(); ++i) {
+        values += table[i] ? '1' : '0';
+    }
+    return "{\"variables\":" + toJson(table.getVariables()) + ",\"values\":\"" + values + "\"}";
+}
+
+static string toJson(const map<string, ProfileEntry> &entries) {
+    stringstream json;
+    json << '{';
+    bool first = true;
+    for (const auto &entry : entries) {
+        const LatencyHistogram &latencies = entry.second.latencies;
+        json << (first ? "" : ",") << toJson(entry.first) << ":{"
+             << "\"count\":" << latencies.getCount()
+             << ",\"total_ns\":" << latencies.getTotal()
+             << ",\"p50_ns\":" << latencies.getPercentile(50)
+             << ",\"p90_ns\":" << latencies.getPercentile(90)
+             << ",\"p99_ns\":" << latencies.getPercentile(99)
+             << ",\"max_ns\":" << latencies.getMax()
+             << ",\"rows\":" << entry.second.rows
+             << ",\"result_bytes\":" << entry.second.resultBytes;
+        static const char *counterNames[NUM_HARDWARE_COUNTERS] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+        for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+            if (entry.second.counters.available[i]) {
+                json << ",\"" << counterNames[i] << "\":" << entry.second.counters.values[i];
+            }
+        }
+        json << '}';
+        first = false;
+    }
+    json << '}';
+    return json.str();
+}
+
+string toJson(const Profiler &profiler) {
+    return "{\"commands\":" + toJson(profiler.getCommands()) + ",\"operators\":" + toJson(profiler.getOperators()) + "}";
+}
+
+void writeChromeTrace(const Tracer &tracer, ostream &os) {
+    const ios::fmtflags flags = os.flags();
+    const streamsize precision = os.precision();
+    os << fixed << setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const TraceThread &thread : tracer.getThreads()) {
+        os << (first ? "" : ",") << endl
+           << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+           << ",\"args\":{\"name\":" << toJson("thread " + to_string(thread.id)) << "}}";
+        first = false;
+
+        for (const TraceEvent &event : thread.events) {
+            // The timestamps are in microseconds
+            os << "," << endl
+               << "{\"name\":" << toJson(event.name)
+               << ",\"cat\":" << toJson(event.category)
+               << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.id
+               << ",\"ts\":" << (double) event.start.count() / 1000
+               << ",\"dur\":" << (double) event.duration.count() / 1000
+               << ",\"args\":{";
+            for (size_t i = 0; i < event.arguments.size(); ++i) {
+                const TraceArgument &argument = event.arguments[i];
+                os << (i == 0 ? "" : ",") << toJson(argument.key) << ":" << (argument.isNumber ? argument.value : toJson(argument.value));
+            }
+            os << "}}";
+        }
+    }
+    os << endl << "]}" << endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+class JsonReader {
+public:
+    JsonReader(const string &json) : json(json), position(0) {
+    }
+
+    unordered_map<string, JsonMember> readObject() {
+        unordered_map<string, JsonMember> members;
+        expect('{');
+        if (peek() == '}') {
+            ++position;
+        } else {
+            while (true) {
+                if (peek() != '"') {
+                    fail("Expected a member name");
+                }
+                const string name = readString();
+                expect(':');
+                members[name] = readValue();
+
+                const char next = peek();
+                ++position;
+                if (next == '}') {
+                    break;
+                } else if (next != ',') {
+                    fail("Expected ',' or '}'");
+                }
+            }
+        }
+
+        if (peek() != '\0') {
+            fail("Unexpected trailing characters");
+        }
+        return members;
+    }
+
+private:
+    const string &json;
+    size_t position;
+
+    [[noreturn]] void fail(const string &message) {
+        throw invalid_argument(message + " at index " + to_string(position) + " in the JSON");
+    }
+
+    // Skips the whitespace, and returns the next char (or '\0' at the end)
+    char peek() {
+        while (position < json.length() && isWhitespace(json[position])) {
+            ++position;
+        }
+        return position < json.length() ? json[position] : '\0';
+    }
+
+    void expect(const char c) {
+        if (peek() != c) {
+            fail(string("Expected '") + c + "'");
+        }
+        ++position;
+    }
+
+    JsonMember readValue() {
+        const char next = peek();
+        const size_t start = position;
+        JsonMember member;
+        member.isString = next == '"';
+        if (member.isString) {
+            member.value = readString();
+        } else {
+            skipValue();
+            member.value = json.substr(start, position - start);
+        }
+        member.raw = json.substr(start, position - start);
+        return member;
+    }
+
+    void skipValue() {
+        const char next = peek();
+        if (next == '"') {
+            readString();
+        } else if (next == '{' || next == '[') {
+            const char close = next == '{' ? '}' : ']';
+            ++position;
+            if (peek() == close) {
+                ++position;
+                return;
+            }
+            while (true) {
+                if (next == '{') {
+                    readString();
+                    expect(':');
+                }
+                skipValue();
+                const char separator = peek();
+                ++position;
+                if (separator == close) {
+                    return;
+                } else if (separator != ',') {
+                    fail(string("Expected ',' or '") + close + "'");
+                }
+            }
+        } else {
+            const size_t start = position;
+            while (position < json.length() && (isalnum(json[position]) || json[position] == '-' || json[position] == '+' || json[position] == '.')) {
+                ++position;
+            }
+            const string literal = json.substr(start, position - start);
+            if (literal.empty() || (!isdigit(literal[0]) && literal[0] != '-' && literal != "true" && literal != "false" && literal != "null")) {
+                fail("Unexpected value");
+            }
+        }
+    }
+
+    string readString() {
+        expect('"');
+        string result;
+        while (position < json.length() && json[position] != '"') {
+            char c = json[position++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+
+            if (position >= json.length()) {
+                break;
+            }
+            c = json[position++];
+            switch (c) {
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'u': result += readCodePoint(); break;
+                case '"': case '\\': case '/': result += c; break;
+                default: fail("Bad escape");
+            }
+        }
+        if (position >= json.length()) {
+            fail("Unterminated string");
+        }
+        ++position;
+        return result;
+    }
+
+    // Reads the 4 hex digits following a "\u"
+    uint32_t readCodeUnit() {
+        if (position + 4 > json.length()) {
+            fail("Bad unicode escape");
+        }
+        uint32_t codeUnit = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            const char c = json[position++];
+            codeUnit <<= 4;
+            if (isdigit(c)) {
+                codeUnit |= (uint32_t) (c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                codeUnit |= (uint32_t) (c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                codeUnit |= (uint32_t) (c - 'A' + 10);
+            } else {
+                fail("Bad unicode escape");
+            }
+        }
+        return codeUnit;
+    }
+
+    // Reads the escape following a "\u", along with the low surrogate's escape that follows a high one, and returns the
+    // UTF-8 encoding of the code point. A surrogate without its pair isn't a character, so it's rejected.
+    string readCodePoint() {
+        uint32_t codePoint = readCodeUnit();
+        if (codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+            fail("Unpaired low surrogate in unicode escape");
+        } else if (codePoint >= 0xd800 && codePoint <= 0xdbff) {
+            if (json.compare(position, 2, "\\u") != 0) {
+                fail("Unpaired high surrogate in unicode escape");
+            }
+            position += 2;
+            const uint32_t low = readCodeUnit();
+            if (low < 0xdc00 || low > 0xdfff) {
+                fail("Unpaired high surrogate in unicode escape");
+            }
+            codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+        }
+
+        string result;
+        if (codePoint < 0x80) {
+            result += (char) codePoint;
+        } else if (codePoint < 0x800) {
+            result += (char) (0xc0 | (codePoint >> 6));
+            result += (char) (0x80 | (codePoint & 0x3f));
+        } else if (codePoint < 0x10000) {
+            result += (char) (0xe0 | (codePoint >> 12));
+            result += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+            result += (char) (0x80 | (codePoint & 0x3f));
+        } else {
+            result += (char) (0xf0 | (codePoint >> 18));
+            result += (char) (0x80 | ((codePoint >> 12) & 0x3f));
+            result += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+            result += (char) (0x80 | (codePoint & 0x3f));
+        }
+        return result;
+    }
+};
+
+unordered_map<string, JsonMember> parseJsonObject(const string &json) {
+    return JsonReader(json).readObject();
+}
+}
@@ -16,6 +16,7 @@
 
 #include <lang/Runtime.hpp>
 #include <lang/Exceptions.hpp>
+#include <algorithm>
 
 using namespace std;
 
@@ -25,8 +26,14 @@ void Runtime::save(const string &variableName, const BooleanFunction &function)
     if (found == workspace.end()) {
         workspace.insert(make_pair(variableName, function));
     } else {
+        memoryUsage -= found->second.getMemoryUsage();
         found->second = function;
     }
+    memoryUsage += function.getMemoryUsage();
+}
+
+void Runtime::reference(const string &variableName, const BooleanFunction &function) {
+    references[variableName] = &function;
 }
 
 BooleanFunction &Runtime::get(const string &variableName) {
@@ -40,13 +47,17 @@ BooleanFunction &Runtime::get(const string &variableName) {
 const BooleanFunction &Runtime::get(const string &variableName) const {
     const auto found = workspace.find(variableName);
     if (found == workspace.end()) {
+        const auto referenced = references.find(variableName);
+        if (referenced != references.end()) {
+            return *referenced->second;
+        }
         throw BooleanFunctionNotFoundException("Boolean Function not found in the current workspace: " + variableName);
     }
     return found->second;
 }
 
 bool Runtime::contains(const string &variableName) const {
-    return workspace.find(variableName) != workspace.end();
+    return workspace.find(variableName) != workspace.end() || references.find(variableName) != references.end();
 }
 
 void Runtime::erase(const string &variableName) {
@@ -54,9 +65,22 @@ void Runtime::erase(const string &variableName) {
     if (found == workspace.end()) {
         throw BooleanFunctionNotFoundException("Boolean Function not found in the current workspace: " + variableName);
     }
+    memoryUsage -= found->second.getMemoryUsage();
     workspace.erase(found);
 }
 
+vector<pair<string, uint64_t>> Runtime::getFunctionsByMemoryUsage() const {
+    vector<pair<string, uint64_t>> functions;
+    for (const auto &function : workspace) {
+        functions.push_back(make_pair(function.first, function.second.getMemoryUsage()));
+    }
+    sort(functions.begin(), functions.end(), [](const pair<string, uint64_t> &first, const pair<string, uint64_t> &second) {
+        // Ties are broken by the name, for a stable listing
+        return first.second != second.second ? first.second > second.second : first.first < second.first;
+    });
+    return functions;
+}
+
 void Runtime::flag(const string &flagName) {
     flags.insert(flagName);
 }
@@ -0,0 +1,149 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <app/Framing.hpp>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Logic;
+
+static bool writeRaw(const int fd, const string &bytes) {
+    return write(fd, bytes.data(), bytes.size()) == (ssize_t) bytes.size();
+}
+
+SCENARIO("Frames written to a socket are read back intact", "[Framing]") {
+    GIVEN("A connected pair of sockets") {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        string payload;
+
+        WHEN("Several frames are written, including an empty one and one with new lines and NUL bytes") {
+            const string binary("a\0b\nc", 5);
+            REQUIRE(writeFrame(fds[0], "w\np a & b;"));
+            REQUIRE(writeFrame(fds[0], ""));
+            REQUIRE(writeFrame(fds[0], binary));
+
+            THEN("They're read back in order with the same payloads") {
+                REQUIRE(readFrame(fds[1], payload));
+                REQUIRE(payload == "w\np a & b;");
+                REQUIRE(readFrame(fds[1], payload));
+                REQUIRE(payload.empty());
+                REQUIRE(readFrame(fds[1], payload));
+                REQUIRE(payload == binary);
+            }
+        }
+
+        WHEN("A frame larger than the socket's buffer is written while it's read") {
+            string large(3 * 1024 * 1024, 'x');
+            for (size_t i = 0; i < large.size(); i += 4093) {
+                large[i] = (char) i;
+            }
+            bool written = false;
+            thread writer([&]() { written = writeFrame(fds[0], large); });
+            const bool read = readFrame(fds[1], payload);
+            writer.join();
+
+            THEN("It's read back whole") {
+                REQUIRE(written);
+                REQUIRE(read);
+                REQUIRE(payload == large);
+            }
+        }
+
+        WHEN("The header is split across writes") {
+            REQUIRE(writeRaw(fds[0], string("\0\0", 2)));
+            bool written = false;
+            thread writer([&]() {
+                this_thread::sleep_for(chrono::milliseconds(10));
+                written = writeRaw(fds[0], string("\0\3abc", 5));
+            });
+            const bool read = readFrame(fds[1], payload);
+            writer.join();
+
+            THEN("The frame is still read") {
+                REQUIRE(written);
+                REQUIRE(read);
+                REQUIRE(payload == "abc");
+            }
+        }
+
+        WHEN("A header declares a frame larger than the limit") {
+            const uint32_t size = MAX_FRAME_SIZE + 1;
+            const char header[4] = { (char) (size >> 24), (char) (size >> 16), (char) (size >> 8), (char) size };
+            REQUIRE(writeRaw(fds[0], string(header, 4)));
+
+            THEN("The frame is rejected without reading its payload") {
+                REQUIRE_FALSE(readFrame(fds[1], payload));
+            }
+        }
+
+        WHEN("A frame larger than the limit is written") {
+            const bool written = writeFrame(fds[0], string(MAX_FRAME_SIZE + 1, 'x'));
+            REQUIRE(writeFrame(fds[0], "next"));
+
+            THEN("It's refused without writing anything, so the next frame is still read") {
+                REQUIRE_FALSE(written);
+                REQUIRE(readFrame(fds[1], payload));
+                REQUIRE(payload == "next");
+            }
+        }
+
+        WHEN("The writer hangs up in the middle of a frame") {
+            REQUIRE(writeRaw(fds[0], string("\0\0\0\12abc", 7)));
+            close(fds[0]);
+            fds[0] = -1;
+
+            THEN("The frame is not read") {
+                REQUIRE_FALSE(readFrame(fds[1], payload));
+            }
+        }
+
+        WHEN("The writer hangs up after a whole frame") {
+            REQUIRE(writeFrame(fds[0], "last"));
+            close(fds[0]);
+            fds[0] = -1;
+
+            THEN("The frame is read, and then the end of the stream is reported") {
+                REQUIRE(readFrame(fds[1], payload));
+                REQUIRE(payload == "last");
+                REQUIRE_FALSE(readFrame(fds[1], payload));
+            }
+        }
+
+        WHEN("The reader has hung up") {
+            close(fds[1]);
+            fds[1] = -1;
+
+            THEN("Writing a frame fails") {
+                // Without a SIGPIPE, like in the server
+                void (*previous)(int) = signal(SIGPIPE, SIG_IGN);
+                REQUIRE_FALSE(writeFrame(fds[0], "lost"));
+                signal(SIGPIPE, previous);
+            }
+        }
+
+        if (fds[0] >= 0) {
+            close(fds[0]);
+        }
+        if (fds[1] >= 0) {
+            close(fds[1]);
+        }
+    }
+}
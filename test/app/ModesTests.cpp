@@ -0,0 +1,113 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <app/Modes.hpp>
+#include <core/Utils.hpp>
+#include <lang/Json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace Logic;
+
+SCENARIO("The JSON lines mode answers every request in order", "[Modes]") {
+    GIVEN("Good requests, and bad ones with and without a readable id") {
+        stringstream in("{\"id\": 1, \"script\": \"p a & b;\"}\n"
+                        "{\"id\": {\"n\": 2}, \"script\": 5}\n"
+                        "{\"id\": \"three\", \"script\": \"p 1;\", \"format\": \"xml\"}\n"
+                        "{\"id\": 4, \"script\": \n"
+                        "{\"id\": 5, \"script\": \"p $missing;\"}\n");
+        stringstream out;
+
+        WHEN("They're executed") {
+            REQUIRE(JsonLinesMode(2, 1 << 20, in, out).run() == 0);
+            vector<string> responses = split(out.str(), '\n');
+            responses.erase(remove_if(responses.begin(), responses.end(), [](const string &line) { return line.empty(); }), responses.end());
+
+            THEN("Every response echoes its request's id, including the bad requests' responses") {
+                REQUIRE(responses.size() == 5);
+                vector<string> ids;
+                for (const string &response : responses) {
+                    ids.push_back(parseJsonObject(response).at("id").raw);
+                }
+                REQUIRE(ids == vector<string>({ "1", "{\"n\": 2}", "\"three\"", "null", "5" }));
+                REQUIRE(parseJsonObject(responses[0]).at("ok").raw == "true");
+                for (size_t i = 1; i < responses.size(); ++i) {
+                    REQUIRE(parseJsonObject(responses[i]).at("ok").raw == "false");
+                }
+                REQUIRE(parseJsonObject(responses[1]).at("error").value.find("Bad request") == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("The batch mode executes every script in its own workspace", "[Modes]") {
+    GIVEN("Scripts in files") {
+        char directory[] = "/tmp/logic_batch_XXXXXX";
+        const string path = mkdtemp(directory);
+        vector<string> scripts;
+        auto addScript = [&](const string &code) {
+            scripts.push_back(path + "/" + to_string(scripts.size()) + ".lgc");
+            ofstream(scripts.back()) << code;
+            return scripts.back();
+        };
+        stringstream out;
+        stringstream err;
+
+        WHEN("They all succeed") {
+            for (size_t i = 0; i < 20; ++i) {
+                addScript("let x = x" + to_string(i % 5) + " | x4; min $x;");
+            }
+            const int returnCode = BatchMode(4, vector<string>(scripts), 1 << 20, out, err).run();
+
+            THEN("Their outputs are printed in the order of the scripts, and the exit status is 0") {
+                REQUIRE(returnCode == 0);
+                REQUIRE(err.str().empty());
+                string expected;
+                for (size_t i = 0; i < 20; ++i) {
+                    expected += i % 5 == 4 ? "1\n" : "1, 2, 3\n";
+                }
+                REQUIRE(out.str() == expected);
+            }
+        }
+
+        WHEN("A script in the middle of the batch fails") {
+            addScript("let x = a & b; min $x;");
+            const string failing = addScript("min a; let y = $missing; min b;");
+            addScript("min $x;");
+            addScript("min a | b;");
+            const string missing = path + "/missing.lgc";
+            scripts.push_back(missing);
+            const int returnCode = BatchMode(2, vector<string>(scripts), 1 << 20, out, err).run();
+
+            THEN("Its output up to the failure is kept, the other scripts are unaffected, and the exit status is 1") {
+                REQUIRE(returnCode == 1);
+                REQUIRE(out.str() == "3\n1\n1, 2, 3\n");
+                REQUIRE(err.str() == "ERROR: " + failing + ": Boolean Function not found in the current workspace: missing\n"
+                                     "ERROR: " + scripts[2] + ": Boolean Function not found in the current workspace: x\n"
+                                     "ERROR: " + missing + ": Cannot open the file.\n");
+            }
+        }
+
+        for (const string &script : scripts) {
+            remove(script.c_str());
+        }
+        rmdir(path.c_str());
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <app/Workspaces.hpp>
+#include <thread>
+#include <vector>
+
+using namespace Logic;
+
+SCENARIO("Workspaces keep the functions defined by earlier scripts", "[Workspaces]") {
+    GIVEN("Workspaces") {
+        Workspaces workspaces;
+
+        WHEN("A function is defined by a script, and read by a later one in the same workspace") {
+            const ScriptResult defined = workspaces.execute("w", "let x = a & b;");
+            const ScriptResult printed = workspaces.execute("w", "min $x;");
+
+            THEN("The later script sees it") {
+                REQUIRE(defined.error.empty());
+                REQUIRE(defined.output.empty());
+                REQUIRE(printed.error.empty());
+                REQUIRE(printed.output == "3\n");
+            }
+        }
+
+        WHEN("A function is read from another workspace") {
+            workspaces.execute("w", "let x = a & b;");
+            const ScriptResult result = workspaces.execute("other", "min $x;");
+
+            THEN("It isn't found") {
+                REQUIRE(result.error == "Boolean Function not found in the current workspace: x");
+                REQUIRE(result.output.empty());
+            }
+        }
+
+        WHEN("A script fails after writing to the workspace") {
+            const ScriptResult failed = workspaces.execute("w", "let x = a | b; min $x; let y = $missing; let z = a;");
+            const ScriptResult later = workspaces.execute("w", "min $x; min $z;");
+
+            THEN("The output and the changes before the failure are kept, and the ones after it are not made") {
+                REQUIRE(failed.error == "Boolean Function not found in the current workspace: missing");
+                REQUIRE(failed.output == "1, 2, 3\n");
+                REQUIRE(later.output == "1, 2, 3\n");
+                REQUIRE(later.error == "Boolean Function not found in the current workspace: z");
+            }
+        }
+
+        WHEN("A function is redefined") {
+            workspaces.execute("w", "let x = a & b;");
+            workspaces.execute("w", "let x = a ^ b;");
+            const ScriptResult result = workspaces.execute("w", "min $x;");
+
+            THEN("The latest definition is read") {
+                REQUIRE(result.output == "1, 2\n");
+            }
+        }
+
+        WHEN("A script is executed with the JSON output format") {
+            workspaces.execute("w", "let x = a & b;");
+            const ScriptResult json = workspaces.execute("w", "p $x; min $x;", OutputFormat::Json);
+            const ScriptResult text = workspaces.execute("w", "min $x;");
+
+            THEN("The results are JSON values, and the format doesn't stick to the workspace") {
+                REQUIRE(json.error.empty());
+                REQUIRE(json.output == "{\"variables\":[\"a\",\"b\"],\"values\":\"0001\"}\n[3]\n");
+                REQUIRE(text.output == "3\n");
+            }
+        }
+
+        WHEN("Many scripts extend the same workspace concurrently") {
+            vector<thread> threads;
+            for (size_t i = 0; i < 8; ++i) {
+                threads.push_back(thread([&workspaces, i]() {
+                    workspaces.execute("shared", "let f" + to_string(i) + " = x" + to_string(i) + ";");
+                }));
+            }
+            for (thread &thread : threads) {
+                thread.join();
+            }
+            const ScriptResult result = workspaces.execute("shared", "let all = $f0 & $f1 & $f2 & $f3 & $f4 & $f5 & $f6 & $f7; min $all;");
+
+            THEN("None of the definitions are lost") {
+                REQUIRE(result.error.empty());
+                REQUIRE(result.output == "255\n");
+            }
+        }
+    }
+}
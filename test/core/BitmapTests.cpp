@@ -0,0 +1,186 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <core/Bitmap.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace Logic;
+
+static vector<uint8_t> readBitmap(const string &path) {
+    ifstream file(path, ios::binary);
+    return vector<uint8_t>(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+static void writeBitmap(const string &path, const vector<uint8_t> &bitmap) {
+    ofstream file(path, ios::binary);
+    file.write((const char *) bitmap.data(), (streamsize) bitmap.size());
+}
+
+static bool getRecord(const vector<uint8_t> &bitmap, const uint64_t record) {
+    return ((bitmap[record / 8] >> (record % 8)) & 1) != 0;
+}
+
+// A temporary directory with a random column for each variable, named after it
+class Dataset {
+public:
+    Dataset(const vector<string> &variables, const size_t size) : variables(variables) {
+        char path[] = "/tmp/logic_bitmap_XXXXXX";
+        directory = mkdtemp(path);
+        mt19937 random(42);
+        for (const string &variable : variables) {
+            vector<uint8_t> column(size);
+            for (uint8_t &byte : column) {
+                byte = (uint8_t) random();
+            }
+            writeBitmap(getPath(variable), column);
+            columns[variable] = getPath(variable);
+        }
+    }
+
+    ~Dataset() {
+        for (const string &variable : variables) {
+            remove(getPath(variable).c_str());
+        }
+        remove(getPath("output").c_str());
+        rmdir(directory.c_str());
+    }
+
+    string getPath(const string &name) const {
+        return directory + "/" + name + ".bin";
+    }
+
+    // The value of the function at every record of the columns
+    vector<uint8_t> evaluate(const BooleanFunction &function) const {
+        vector<vector<uint8_t>> bound;
+        if (function.hasTruthTable()) {
+            for (const string &variable : function.getTruthTable().getVariables()) {
+                bound.push_back(readBitmap(getPath(variable)));
+            }
+        }
+
+        vector<uint8_t> result(readBitmap(getPath(variables.front())).size());
+        for (uint64_t record = 0; record < result.size() * 8; ++record) {
+            TruthTableUInt line = 0;
+            for (size_t i = 0; i < bound.size(); ++i) {
+                line |= ((TruthTableUInt) getRecord(bound[i], record)) << i;
+            }
+            const bool value = function.hasTruthTable() ? function.getTruthTable()[line] : function.getConstantValue();
+            result[record / 8] = (uint8_t) (result[record / 8] | value << (record % 8));
+        }
+        return result;
+    }
+
+    vector<string> variables;
+    string directory;
+    unordered_map<string, string> columns;
+};
+
+SCENARIO("A function is evaluated at every record of bitmap columns", "[Bitmap]") {
+    GIVEN("Columns of a number of records that isn't a multiple of the word size") {
+        Dataset dataset({"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l"}, 1001);
+        BooleanFunctionParser parser;
+
+        TruthTable random({"c", "h", "a", "l", "b", "k", "d", "j", "e", "i", "f", "g"});
+        mt19937 values(7);
+        for (TruthTableUInt line = 0; line < random.size(); ++line) {
+            random[line] = values() % 2 == 1;
+        }
+
+        // Multiplexed within a word of the table, across the words, and looked up
+        const vector<BooleanFunction> functions = {
+            parser.parse("!a"), parser.parse("(a & b) | !c"), parser.parse("a ^ b ^ c ^ d ^ e ^ f"),
+            parser.parse("(a & b & c & d & e & f & g & h & i & j) | (k ^ l)"), BooleanFunction(random), BooleanFunction(true)
+        };
+        ThreadPool pool(3);
+
+        WHEN("The functions are evaluated, with and without a thread pool") {
+            THEN("The output holds each one's value at every record, and the count is the number of 1s") {
+                for (ThreadPool *threadPool : { (ThreadPool *) nullptr, &pool }) {
+                    for (const BooleanFunction &function : functions) {
+                        const BitmapEvaluationResult result = evaluateBitmaps(function, dataset.columns, dataset.getPath("output"), threadPool);
+                        const vector<uint8_t> output = readBitmap(dataset.getPath("output"));
+                        REQUIRE(output == dataset.evaluate(function));
+                        REQUIRE(result.numRecords == 8008);
+
+                        uint64_t count = 0;
+                        for (uint64_t record = 0; record < result.numRecords; ++record) {
+                            count += getRecord(output, record);
+                        }
+                        REQUIRE(result.count == count);
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("The chunks of the records are evaluated concurrently", "[Bitmap]") {
+    GIVEN("Columns of more records than a chunk holds") {
+        Dataset dataset({"a", "b", "c"}, 300001);
+        const BooleanFunction function = BooleanFunctionParser().parse("(a & b) | !c");
+        ThreadPool pool(3);
+
+        WHEN("The function is evaluated on a thread pool") {
+            const BitmapEvaluationResult result = evaluateBitmaps(function, dataset.columns, dataset.getPath("output"), &pool);
+
+            THEN("The result is the same as evaluating it sequentially") {
+                const vector<uint8_t> output = readBitmap(dataset.getPath("output"));
+                REQUIRE(output == dataset.evaluate(function));
+                REQUIRE(result.numRecords == 2400008);
+                REQUIRE(result.count == evaluateBitmaps(function, dataset.columns, dataset.getPath("output")).count);
+            }
+        }
+    }
+}
+
+SCENARIO("Bad column bindings are rejected before writing anything", "[Bitmap]") {
+    GIVEN("Columns of a few records") {
+        Dataset dataset({"a", "b"}, 16);
+        BooleanFunctionParser parser;
+
+        WHEN("A variable isn't bound") {
+            THEN("It throws") {
+                CHECK_THROWS_AS(evaluateBitmaps(parser.parse("a & c"), dataset.columns, dataset.getPath("output")), invalid_argument);
+                CHECK_THROWS_AS(evaluateBitmaps(parser.parse("1"), {}, dataset.getPath("output")), invalid_argument);
+            }
+        }
+
+        WHEN("The columns have different sizes") {
+            writeBitmap(dataset.getPath("b"), vector<uint8_t>(8));
+
+            THEN("It throws") {
+                CHECK_THROWS_AS(evaluateBitmaps(parser.parse("a & b"), dataset.columns, dataset.getPath("output")), invalid_argument);
+            }
+        }
+
+        WHEN("The output is one of the columns, or a column doesn't exist") {
+            const vector<uint8_t> column = readBitmap(dataset.getPath("a"));
+
+            THEN("It throws, and leaves the columns as they were") {
+                CHECK_THROWS_AS(evaluateBitmaps(parser.parse("a & b"), dataset.columns, dataset.getPath("a")), invalid_argument);
+                REQUIRE(readBitmap(dataset.getPath("a")) == column);
+                CHECK_THROWS_AS(evaluateBitmaps(parser.parse("a"), {{"a", dataset.getPath("missing")}}, dataset.getPath("output")), runtime_error);
+            }
+        }
+    }
+}
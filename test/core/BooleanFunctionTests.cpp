@@ -73,3 +73,35 @@ SCENARIO("A BooleanFunction contains the correct TruthTable", "[BooleanFunction]
         }
     }
 }
+
+SCENARIO("A BooleanFunction's support is reduced", "[BooleanFunction]") {
+    GIVEN("A function of x & !z, with an unrelated y") {
+        TruthTable table({"x", "y", "z"});
+        table[1] = true;
+        table[3] = true;
+        const BooleanFunction function(table);
+
+        WHEN("Its support is reduced") {
+            const BooleanFunction reduced = reduceSupport(function);
+
+            THEN("It's the same function of x and z") {
+                TruthTable expected({"x", "z"});
+                expected[1] = true;
+                REQUIRE(reduced == BooleanFunction(expected));
+                REQUIRE(reduceSupport(reduced) == reduced);
+            }
+        }
+    }
+
+    GIVEN("A function that depends on none of its variables") {
+        TruthTable table({"a", "b"});
+        for (TruthTableUInt i = 0; i < table.size(); ++i) {
+            table[i] = true;
+        }
+
+        THEN("Its reduced support is a constant value function") {
+            REQUIRE(reduceSupport(BooleanFunction(table)) == BooleanFunction(true));
+            REQUIRE(reduceSupport(BooleanFunction(false)) == BooleanFunction(false));
+        }
+    }
+}
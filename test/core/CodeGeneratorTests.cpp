@@ -0,0 +1,285 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <core/CodeGenerator.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace Logic;
+
+// The body of the generated function whose signature starts with the prefix
+static string getBody(const string &source, const string &signaturePrefix) {
+    const size_t start = source.find(signaturePrefix);
+    REQUIRE(start != string::npos);
+    const size_t open = source.find("{\n", start) + 2;
+    return source.substr(open, source.find("\n}\n", open) - open + 1);
+}
+
+// The parameter names of the generated function whose signature starts with the prefix
+static vector<string> getParameters(const string &source, const string &signaturePrefix) {
+    const size_t start = source.find(signaturePrefix) + signaturePrefix.length();
+    const string parameters = source.substr(start, source.find(')', start) - start);
+    vector<string> names;
+    const regex parameterRegex("(bool|uint64_t) ([A-Za-z0-9_]+)");
+    for (sregex_iterator it(parameters.begin(), parameters.end(), parameterRegex), end; it != end; ++it) {
+        names.push_back((*it)[2]);
+    }
+    return names;
+}
+
+/**
+ * The straight-line bitwise body of a generated function, interpreted at 64 assignments at once. A bool function's
+ * operations are the same as the bit-sliced ones applied to every bit, so both are interpreted on words.
+ */
+class GeneratedGates {
+public:
+    GeneratedGates(const string &body) {
+        const regex gateRegex(" *const (bool|uint64_t) ([A-Za-z0-9_]+) = ([^ ]+) ([&|^]) ([^ ]+);");
+        const regex returnRegex(" *return (.+);");
+        stringstream lines(body);
+        string line;
+        smatch sm;
+        while (getline(lines, line)) {
+            if (regex_match(line, sm, gateRegex)) {
+                gates.push_back(Gate{sm[2], sm[3], sm.str(4)[0], sm[5]});
+            } else if (regex_match(line, sm, returnRegex)) {
+                output = sm[1];
+            } else {
+                REQUIRE(line.find("(void) ") != string::npos);
+            }
+        }
+        REQUIRE_FALSE(output.empty());
+    }
+
+    uint64_t evaluate(unordered_map<string, uint64_t> values) const {
+        for (const Gate &gate : gates) {
+            const uint64_t first = getOperand(gate.first, values);
+            const uint64_t second = getOperand(gate.second, values);
+            values[gate.output] = gate.op == '&' ? first & second : (gate.op == '|' ? first | second : first ^ second);
+        }
+        return getOperand(output, values);
+    }
+
+private:
+    struct Gate {
+        string output;
+        string first;
+        char op;
+        string second;
+    };
+
+    vector<Gate> gates;
+    string output;
+
+    static uint64_t getOperand(const string &operand, const unordered_map<string, uint64_t> &values) {
+        if (operand == "0") {
+            return 0;
+        } else if (operand == "1" || operand == "~(uint64_t) 0") {
+            return ~(uint64_t) 0;
+        } else if (operand[0] == '~' || operand[0] == '!') {
+            return ~values.at(operand.substr(1));
+        }
+        return values.at(operand);
+    }
+};
+
+// The packed table of a looked up function, and the shift of every variable in the line it computes
+class GeneratedLookup {
+public:
+    GeneratedLookup(const string &source, const vector<string> &parameters) : shifts(parameters.size(), 64) {
+        const regex wordRegex("UINT64_C\\(0x([0-9a-f]{16})\\)");
+        for (sregex_iterator it(source.begin(), source.end(), wordRegex), end; it != end; ++it) {
+            words.push_back(stoull((*it)[1], nullptr, 16));
+        }
+
+        // "(uint64_t) a | (uint64_t) b << 1 | ..."
+        const string body = getBody(source, "static inline bool f(");
+        const size_t start = body.find("line = ") + 7;
+        const string line = body.substr(start, body.find(';', start) - start);
+        const regex termRegex("\\(uint64_t\\) ([A-Za-z0-9_]+)(?: << ([0-9]+))?");
+        for (sregex_iterator it(line.begin(), line.end(), termRegex), end; it != end; ++it) {
+            const size_t variable = (size_t) (find(parameters.begin(), parameters.end(), (*it)[1]) - parameters.begin());
+            REQUIRE(variable < parameters.size());
+            shifts[variable] = (*it)[2].matched ? stoul((*it)[2]) : 0;
+        }
+    }
+
+    bool evaluate(const TruthTableUInt line) const {
+        TruthTableUInt index = 0;
+        for (size_t i = 0; i < shifts.size(); ++i) {
+            index |= ((line >> i) & 1) << shifts[i];
+        }
+        return index / 64 < words.size() && ((words[index / 64] >> (index % 64)) & 1) == 1;
+    }
+
+private:
+    vector<uint64_t> words;
+    vector<size_t> shifts;
+};
+
+// Both generated variants of the function compute its truth table at every line
+static void requireGeneratedMatches(const TruthTable &table) {
+    const string source = generateC(BooleanFunction(table), "f");
+    const bool lookedUp = source.find("looked up in a packed truth table") != string::npos;
+    const vector<string> parameters = getParameters(source, "static inline bool f(");
+    REQUIRE(parameters.size() == table.getVariables().size());
+    REQUIRE(getParameters(source, "static inline uint64_t f_64(") == parameters);
+    const GeneratedGates sliced(getBody(source, "static inline uint64_t f_64("));
+    unique_ptr<GeneratedGates> scalar(lookedUp ? nullptr : new GeneratedGates(getBody(source, "static inline bool f(")));
+    unique_ptr<GeneratedLookup> lookup(lookedUp ? new GeneratedLookup(source, parameters) : nullptr);
+
+    for (TruthTableUInt base = 0; base < table.size(); base += 64) {
+        const TruthTableUInt numLines = min(table.size() - base, (TruthTableUInt) 64);
+        const uint64_t mask = numLines == 64 ? ~(uint64_t) 0 : (((uint64_t) 1) << numLines) - 1;
+        // The bit j of a variable's word is its value at the line base + j
+        unordered_map<string, uint64_t> values;
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            uint64_t word = 0;
+            for (TruthTableUInt j = 0; j < numLines; ++j) {
+                word |= (((base + j) >> i) & 1) << j;
+            }
+            values[parameters[i]] = word;
+        }
+
+        uint64_t expected = 0;
+        uint64_t looked = 0;
+        for (TruthTableUInt j = 0; j < numLines; ++j) {
+            expected |= ((uint64_t) table[base + j]) << j;
+            looked |= ((uint64_t) (lookup && lookup->evaluate(base + j))) << j;
+        }
+        INFO("Lines " << base << " to " << base + numLines - 1);
+        REQUIRE((sliced.evaluate(values) & mask) == expected);
+        REQUIRE(((lookedUp ? looked : scalar->evaluate(values)) & mask) == expected);
+    }
+}
+
+SCENARIO("C code is generated for Boolean functions", "[CodeGenerator]") {
+    GIVEN("A function of a few variables") {
+        const BooleanFunction function = BooleanFunctionParser().parse("(a & b) | !c");
+
+        WHEN("Its code is generated") {
+            const string source = generateC(function, "f");
+
+            THEN("Both variants are straight-line bitwise expressions") {
+                REQUIRE(source ==
+                    "/* Generated by logic: a function of 3 variables, as bitwise operations. */\n"
+                    "#include <stdbool.h>\n"
+                    "#include <stdint.h>\n"
+                    "\n"
+                    "static inline bool f(bool a, bool b, bool c) {\n"
+                    "    const bool t0 = b & a;\n"
+                    "    const bool t1 = !c | t0;\n"
+                    "    return t1;\n"
+                    "}\n"
+                    "\n"
+                    "/* The bit i of the result is the function's value at the bit i of the variables. */\n"
+                    "static inline uint64_t f_64(uint64_t a, uint64_t b, uint64_t c) {\n"
+                    "    const uint64_t t0 = b & a;\n"
+                    "    const uint64_t t1 = ~c | t0;\n"
+                    "    return t1;\n"
+                    "}\n");
+            }
+        }
+    }
+
+    GIVEN("A function of a few variables with no structure") {
+        TruthTable table({"a", "b", "c", "d", "e", "f", "g"});
+        mt19937 random(42);
+        for (TruthTableUInt line = 0; line < table.size(); ++line) {
+            table[line] = random() % 2 == 1;
+        }
+
+        WHEN("Its code is generated") {
+            const string source = generateC(BooleanFunction(table), "f");
+
+            THEN("The function looks its line up in the packed table, and the bit-sliced one is still bitwise") {
+                REQUIRE(source.find("static const uint64_t f_table[2] = {\n    UINT64_C(0x") != string::npos);
+                REQUIRE(source.find("return (f_table[line / 64] >> (line % 64)) & 1;") != string::npos);
+                REQUIRE(source.find("static inline uint64_t f_64(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f_, uint64_t g) {") != string::npos);
+                REQUIRE(source.find("f_table", source.find("f_64")) == string::npos);
+            }
+        }
+    }
+
+    GIVEN("Functions with unusual variables") {
+        BooleanFunctionParser parser;
+
+        WHEN("The variables are C keywords or collide with the generated names") {
+            const string source = generateC(parser.parse("(int & f_64) | t"), "f");
+
+            THEN("They are renamed, and the temporaries don't collide with them") {
+                REQUIRE(source.find("static inline bool f(bool int_, bool f_64_, bool t) {") != string::npos);
+                REQUIRE(source.find("const bool t_0 = ") != string::npos);
+            }
+        }
+
+        WHEN("The function doesn't depend on some of its variables, or is constant") {
+            const string unused = generateC(parser.parse("a | (b & !b)"), "f");
+            const string constant = generateC(parser.parse("1"), "f");
+
+            THEN("They are still parameters, and the constant has none") {
+                REQUIRE(unused.find("static inline bool f(bool a, bool b) {\n    (void) b;\n    return a;\n}") != string::npos);
+                REQUIRE(constant.find("static inline bool f(void) {\n    return 1;\n}") != string::npos);
+                REQUIRE(constant.find("static inline uint64_t f_64(void) {\n    return ~(uint64_t) 0;\n}") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("Random functions on both sides of the lookup table's limit of 10 variables") {
+        mt19937 random(7);
+        vector<string> names = {"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m"};
+
+        WHEN("Their code is generated") {
+            THEN("Both variants compute the functions, whether the scalar one is looked up or not") {
+                for (const size_t numVariables : vector<size_t>({ 1, 3, 6, 7, 9, 10, 11, 12, 13 })) {
+                    // Dense tables have no structure, and sparse ones have constant and implied cofactors
+                    for (const uint32_t density : vector<uint32_t>({ 2, 5 })) {
+                        TruthTable table(vector<string>(names.begin(), names.begin() + (long) numVariables));
+                        for (TruthTableUInt line = 0; line < table.size(); ++line) {
+                            table[line] = random() % density == 0;
+                        }
+                        INFO(numVariables << " variables, a 1 in " << density << " lines");
+                        requireGeneratedMatches(table);
+                    }
+                }
+            }
+        }
+
+        WHEN("The functions have structure") {
+            BooleanFunctionParser parser;
+
+            THEN("The shared and implied cofactors still compute them") {
+                const vector<string> functions = {
+                    "(a & !b) | (c ^ d) | (e & f & g & h & i & j & k)",
+                    "(a ^ b ^ c ^ d ^ e ^ f) & (g | h | i | j | k | l)",
+                    "(a & b) | (c & d) | (e & f) | (g & h) | (i & j)",
+                    "!((a | b) & (c | d) & (e | f) & (g | h) & (i | j) & (k | l))"
+                };
+                for (const string &function : functions) {
+                    INFO(function);
+                    requireGeneratedMatches(parser.parse(function).getTruthTable());
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,494 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <core/Expression.hpp>
+#include <core/Exceptions.hpp>
+#include <core/ThreadPool.hpp>
+#include <algorithm>
+#include <limits>
+
+using namespace Logic;
+
+SCENARIO("A compiled expression knows the variables of its result", "[Expression]") {
+    GIVEN("A BooleanFunctionParser and a workspace function") {
+        BooleanFunctionParser parser;
+        const BooleanFunction x = parser.parse("a & d");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Expressions are compiled") {
+            THEN("The variables match the ones of the evaluated result") {
+                for (const string function : { "a & b", "(a & b) | (c ^ $x)", "!a ^ (b | a)", "$x[1]", "(a | b | c)[b = 1]",
+                                               "(a | b)[a = 1, b = 0]", "a == b", "1 & a", "a & 0", "!1" }) {
+                    unique_ptr<Expression> expression = parser.compile(function, lookup);
+                    BooleanFunction result = expression->evaluate(EvaluationOptions());
+                    REQUIRE(result == parser.parse(function, lookup));
+                    if (result.isConstant()) {
+                        REQUIRE(expression->getVariables().empty());
+                        REQUIRE(expression->size() == 1);
+                    } else {
+                        REQUIRE(expression->getVariables() == result.getTruthTable().getVariables());
+                        REQUIRE(expression->size() == result.getTruthTable().size());
+                    }
+                }
+            }
+        }
+
+        WHEN("An expression is compiled without fusing its operators") {
+            EvaluationOptions options;
+            options.fuseOperators = false;
+            unique_ptr<Expression> expression = BooleanFunctionParser(options).compile("(a & b) ^ $x", lookup);
+
+            THEN("The tree has the expected shape") {
+                const BinaryOperatorExpression *root = dynamic_cast<const BinaryOperatorExpression *>(expression.get());
+                REQUIRE(root != nullptr);
+                REQUIRE(dynamic_cast<const Xor *>(&root->getOperator()));
+                REQUIRE(dynamic_cast<const BinaryOperatorExpression *>(&root->getFirst()));
+                const FunctionReferenceExpression *reference = dynamic_cast<const FunctionReferenceExpression *>(&root->getSecond());
+                REQUIRE(reference != nullptr);
+                REQUIRE(reference->getName() == "x");
+                REQUIRE(&reference->getFunction() == &x);
+            }
+        }
+    }
+}
+
+SCENARIO("Independent subexpressions can be evaluated concurrently", "[Expression]") {
+    GIVEN("A parser that forks every binary operation onto a ThreadPool") {
+        ThreadPool pool(3);
+        EvaluationOptions options;
+        options.threadPool = &pool;
+        options.forkThreshold = 1;
+        BooleanFunctionParser concurrentParser(options);
+        BooleanFunctionParser parser;
+
+        WHEN("Expressions are parsed") {
+            THEN("The result is the same as that of the sequential evaluation") {
+                for (const string function : { "(a & b) ^ (c | d)", "((a & b) ^ (c | d)) & (!(e ^ a) | (b & f))",
+                                               "((a | b) == (b | a)) & (c ^ d)", "(((a & b) | (c & d)) ^ ((e & f) | (g & h)))[c = 1, e = 0]" }) {
+                    REQUIRE(concurrentParser.parse(function) == parser.parse(function));
+                }
+            }
+        }
+
+        WHEN("Both the operands of a forked operation fail") {
+            THEN("The first operand's error is reported, as in the sequential evaluation") {
+                CHECK_THROWS_AS(concurrentParser.parse("((a & b)[c = 1] | a) & ((a | b)[0] & !1)[a = 1]"), invalid_argument);
+                CHECK_THROWS_AS(concurrentParser.parse("((a | b)[0] & !1)[a = 1] & ((a & b)[c = 1] | a)"), IllegalStateException);
+            }
+        }
+    }
+}
+
+SCENARIO("The peak memory of an evaluation is estimated before evaluating it", "[Expression]") {
+    GIVEN("A BooleanFunctionParser") {
+        BooleanFunctionParser parser;
+        auto lookup = [](const string &name) -> const BooleanFunction& {
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Expressions are compiled") {
+            THEN("The estimate covers at least the result, and grows with the number of variables") {
+                for (const string function : { "a & b", "(a & b) | (c ^ d)", "!a ^ (b | a)", "(a | b | c)[b = 1]", "a == b", "1 & a", "!1" }) {
+                    unique_ptr<Expression> expression = parser.compile(function, lookup);
+                    const BooleanFunction result = expression->evaluate(EvaluationOptions());
+                    REQUIRE(expression->estimatePeakMemoryUsage() >= expression->getResultMemoryUsage());
+                    if (result.hasTruthTable()) {
+                        REQUIRE(expression->getResultMemoryUsage() == TruthTable::getValuesMemoryUsage(result.getTruthTable().size()));
+                    } else {
+                        REQUIRE(expression->getResultMemoryUsage() == 0);
+                    }
+                }
+                REQUIRE(parser.compile("a & b & c & d & e & f & g & h & i & j", lookup)->estimatePeakMemoryUsage() >
+                        parser.compile("a & b & c & d & e", lookup)->estimatePeakMemoryUsage());
+            }
+
+            THEN("The estimate saturates instead of overflowing") {
+                string function = "v0";
+                for (int i = 1; i < 80; ++i) {
+                    function += " & v" + to_string(i);
+                }
+                REQUIRE(parser.compile(function, lookup)->estimatePeakMemoryUsage() == numeric_limits<uint64_t>::max());
+            }
+        }
+
+        WHEN("A function is parsed with a memory budget smaller than the estimate") {
+            EvaluationOptions options;
+            options.memoryBudget = 1024;
+            BooleanFunctionParser limitedParser(options);
+
+            THEN("It fails before evaluating, and smaller functions still fit") {
+                REQUIRE_THROWS_AS(limitedParser.parse("a & b & c & d & e & f & g & h & i & j & k & l & m & n & o & p"), MemoryLimitExceededException);
+                REQUIRE(limitedParser.parse("a & b") == parser.parse("a & b"));
+            }
+        }
+    }
+}
+
+SCENARIO("The work and the time of an evaluation are estimated before evaluating it", "[Expression]") {
+    GIVEN("A BooleanFunctionParser that doesn't rewrite the expressions, and a workspace function") {
+        EvaluationOptions options;
+        options.fuseOperators = false;
+        options.pushDownConditions = false;
+        BooleanFunctionParser parser(options);
+        const BooleanFunction x = parser.parse("a & b & c");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("An expression is compiled") {
+            unique_ptr<Expression> expression = parser.compile("($x | d)[a = 1] ^ !e", lookup);
+            const BinaryOperatorExpression &root = dynamic_cast<const BinaryOperatorExpression &>(*expression);
+
+            THEN("Every node describes itself, and the leaves take no work") {
+                REQUIRE(root.getDescription() == "Xor");
+                REQUIRE(root.getFirst().getDescription() == "Conditions[a = 1]");
+                REQUIRE(root.getSecond().getDescription() == "Not");
+                REQUIRE(parser.compile("$x[2]", lookup)->getDescription() == "Index[2]");
+                REQUIRE(parser.compile("$x", lookup)->getDescription() == "$x");
+                REQUIRE(parser.compile("1", lookup)->getDescription() == "1");
+                REQUIRE(parser.compile("$x", lookup)->estimateTotalWork() == 0);
+            }
+
+            THEN("The total work is the sum of the nodes' work, and the time grows with it") {
+                REQUIRE(root.estimateTotalWork() == root.estimateWork() + root.getFirst().estimateTotalWork() + root.getSecond().estimateTotalWork());
+                REQUIRE(root.estimateWork() >= root.size());
+                REQUIRE(Expression::estimateDuration(root.estimateTotalWork()) > Expression::estimateDuration(root.estimateWork()));
+                REQUIRE(Expression::estimateDuration(numeric_limits<TruthTableUInt>::max()) == chrono::nanoseconds::max());
+            }
+        }
+    }
+}
+
+SCENARIO("A single line of an expression is evaluated without its whole truth tables", "[Expression]") {
+    GIVEN("A BooleanFunctionParser and workspace functions") {
+        BooleanFunctionParser parser;
+        const BooleanFunction x = parser.parse("(a & !b) | (c ^ d)");
+        const BooleanFunction y = parser.parse("d | e");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            } else if (name == "y") {
+                return y;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Every line of expressions is evaluated on its own") {
+            THEN("The values are the same as the lines of the evaluated expressions") {
+                for (const string function : { "$x", "!$x & $y", "$x ^ $y ^ a", "($x | f)[c = 1, a = 0]", "$x & ($y == (e | d))", "$y & !$x[3]",
+                                               "(($x & $y)[d = 0] | !a)[e = 1]", "!(1 & $y)", "$x[b = 1] | ($x[0] ^ $y)",
+                                               "($x & $y) exists[a, d]", "($x forall[c] | e) exists[b]" }) {
+                    unique_ptr<Expression> expression = parser.compile(function, lookup);
+                    const BooleanFunction result = expression->evaluate(EvaluationOptions());
+                    const vector<string> &variables = expression->getVariables();
+                    const TruthTableUInt size = result.hasTruthTable() ? result.getTruthTable().size() : 1;
+                    for (TruthTableUInt line = 0; line < size; ++line) {
+                        VariableAssignment assignment;
+                        for (TruthTableVariablesUInt i = 0; i < variables.size(); ++i) {
+                            assignment[variables[i]] = TruthTable::getVariableValueInLine(i, line);
+                        }
+                        const bool expected = result.hasTruthTable() ? (bool) result.getTruthTable()[line] : result.getConstantValue();
+                        REQUIRE(evaluate(*expression, assignment) == expected);
+                    }
+                }
+            }
+
+            THEN("A missing variable is an error") {
+                CHECK_THROWS_AS(evaluate(*parser.compile("$x & $y", lookup), { { "a", true } }), invalid_argument);
+            }
+        }
+
+        WHEN("An operand that the evaluated line doesn't need is invalid") {
+            EvaluationOptions unoptimized;
+            unoptimized.pushDownConditions = false;
+            unoptimized.reorderChains = false;
+            unoptimized.fuseOperators = false;
+
+            THEN("It fails when it's compiled, as evaluating it whole does, with or without rewriting the expression") {
+                for (const BooleanFunctionParser &anyParser : { parser, BooleanFunctionParser(unoptimized) }) {
+                    CHECK_THROWS_AS(anyParser.compile("(0 & (a)[b = 1])[0]", lookup), invalid_argument);
+                    CHECK_THROWS_AS(anyParser.compile("(a & (a)[7])[0]", lookup), out_of_range);
+                    CHECK_THROWS_AS(anyParser.compile("(1 | $y[c = 1])[0]", lookup), invalid_argument);
+                    CHECK_THROWS_AS(anyParser.compile("(!$x | (a ^ (0)[a = 1]))[2]", lookup), IllegalStateException);
+                    CHECK_THROWS_AS(anyParser.compile("(a & !b & (b)[c = 0])[0]", lookup), invalid_argument);
+                    CHECK_THROWS_AS(anyParser.compile("(a & b) exists[a, b][0] & $x[16]", lookup), out_of_range);
+                }
+            }
+        }
+
+        WHEN("An expression of too many variables to evaluate is indexed") {
+            string function = "v0";
+            for (int i = 1; i < 60; ++i) {
+                function += " & v" + to_string(i);
+            }
+            EvaluationOptions options;
+            options.memoryBudget = 1024;
+            BooleanFunctionParser limitedParser(options);
+            const unique_ptr<Expression> expression = limitedParser.compile("(" + function + " & $x)[" + to_string((((TruthTableUInt) 1) << 63) - 1) + "]", lookup);
+
+            THEN("Only the indexed line is evaluated") {
+                REQUIRE(dynamic_cast<const UnaryOperatorExpression &>(*expression).isPointEvaluated());
+                REQUIRE(expression->estimatePeakMemoryUsage() < 1024);
+                REQUIRE(expression->estimateTotalWork() < 1000);
+                REQUIRE(limitedParser.parse("(" + function + ")[" + to_string((((TruthTableUInt) 1) << 60) - 1) + "]", lookup) == BooleanFunction(true));
+                REQUIRE(limitedParser.parse("(" + function + ")[" + to_string((((TruthTableUInt) 1) << 60) - 2) + "]", lookup) == BooleanFunction(false));
+                CHECK_THROWS_AS(limitedParser.parse("(" + function + ")[" + to_string(((TruthTableUInt) 1) << 60) + "]", lookup), out_of_range);
+                CHECK_THROWS_AS(limitedParser.parse(function, lookup), MemoryLimitExceededException);
+            }
+
+            THEN("A quantifier under the index reads the lines with every value of its variables, unless evaluating the table is less work") {
+                REQUIRE(limitedParser.parse("(" + function + ") exists[v0][" + to_string((((TruthTableUInt) 1) << 59) - 1) + "]", lookup) == BooleanFunction(true));
+                REQUIRE(limitedParser.parse("(" + function + ") forall[v0][" + to_string((((TruthTableUInt) 1) << 59) - 1) + "]", lookup) == BooleanFunction(false));
+                REQUIRE(dynamic_cast<const UnaryOperatorExpression &>(*parser.compile("$x exists[a][3]", lookup)).isPointEvaluated());
+                REQUIRE_FALSE(dynamic_cast<const UnaryOperatorExpression &>(*parser.compile("$x exists[a, b, c, d]", lookup)).isPointEvaluated());
+            }
+        }
+    }
+}
+
+SCENARIO("The lines of an expression that are 1 are counted", "[Expression]") {
+    GIVEN("A BooleanFunctionParser and a workspace function") {
+        BooleanFunctionParser parser;
+        const BooleanFunction x = parser.parse("(a & !b) | (c ^ d)");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Expressions are counted, with and without a thread pool") {
+            ThreadPool pool(3);
+            EvaluationOptions concurrent;
+            concurrent.threadPool = &pool;
+            concurrent.forkThreshold = 2;
+
+            THEN("The counts are the number of 1s in the evaluated tables") {
+                for (const string function : { "$x", "!$x & e", "$x ^ (e | f)", "$x | $x[c = 1]", "$x & (e == f)", "($x & e)[0]",
+                                               "!(1 & $x)", "0", "(e & f) | (g & !h) | (i ^ j)" }) {
+                    const unique_ptr<Expression> expression = parser.compile(function, lookup);
+                    const BooleanFunction result = expression->evaluate(EvaluationOptions());
+                    const TruthTableUInt expected = result.hasTruthTable() ? result.getTruthTable().getMinterms().size() : result.getConstantValue();
+                    REQUIRE(count(*expression) == expected);
+                    REQUIRE(count(*expression, concurrent) == expected);
+                }
+            }
+        }
+
+        WHEN("An expression of too many variables to evaluate combines operands that share no variables") {
+            string function = "v0";
+            for (int i = 1; i < 50; ++i) {
+                function += " & v" + to_string(i);
+            }
+            EvaluationOptions options;
+            options.memoryBudget = 1024;
+            const unique_ptr<Expression> expression = parser.compile("!(" + function + ") & ($x | e)", lookup);
+
+            THEN("It's counted from the operands' counts, without evaluating it") {
+                REQUIRE(expression->estimateCountPeakMemoryUsage() < 1024);
+                REQUIRE(count(*expression, options) == ((((TruthTableUInt) 1) << 50) - 1) * 26);
+                CHECK_THROWS_AS(count(*parser.compile("(" + function + ") | $x | a", lookup), options), MemoryLimitExceededException);
+            }
+        }
+    }
+}
+
+SCENARIO("The first line of an expression with a value is found a block at a time", "[Expression]") {
+    GIVEN("A BooleanFunctionParser and a workspace function") {
+        BooleanFunctionParser parser;
+        const BooleanFunction x = parser.parse("(a & !b) | (c ^ d)");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+        auto getLine = [](const vector<string> &variables, const VariableAssignment &assignment) {
+            TruthTableUInt line = 0;
+            for (size_t i = 0; i < variables.size(); ++i) {
+                line |= (assignment.at(variables[i]) ? (TruthTableUInt) 1 : 0) << i;
+            }
+            return line;
+        };
+
+        WHEN("Expressions are checked, with and without a thread pool") {
+            ThreadPool pool(3);
+            EvaluationOptions concurrent;
+            concurrent.threadPool = &pool;
+
+            THEN("The witnesses and the counterexamples are the first minterms and maxterms of the evaluated tables") {
+                for (const string function : { "$x", "!$x & e", "$x | $x[c = 1]", "$x & (e == f)", "($x & e)[0]", "$x | !$x",
+                                               "$x & !$x", "!(1 & $x)", "0", "1", "$x[a = 1, b = 0] | (e & f)",
+                                               "($x & e) exists[a, c]", "$x forall[a, b, c]", "($x ^ e) forall[d] | f" }) {
+                    const unique_ptr<Expression> expression = parser.compile(function, lookup);
+                    const BooleanFunction result = expression->evaluate(EvaluationOptions());
+                    const vector<TruthTableUInt> minterms = result.hasTruthTable() ? result.getTruthTable().getMinterms() :
+                                                            result.getConstantValue() ? vector<TruthTableUInt>({0}) : vector<TruthTableUInt>();
+                    const vector<TruthTableUInt> maxterms = result.hasTruthTable() ? result.getTruthTable().getMaxterms() :
+                                                            result.getConstantValue() ? vector<TruthTableUInt>() : vector<TruthTableUInt>({0});
+                    for (const EvaluationOptions &options : { EvaluationOptions(), concurrent }) {
+                        VariableAssignment witness;
+                        VariableAssignment counterexample;
+                        REQUIRE(isSatisfiable(*expression, witness, options) == !minterms.empty());
+                        REQUIRE(isTautology(*expression, counterexample, options) == maxterms.empty());
+                        if (!minterms.empty()) {
+                            REQUIRE(getLine(expression->getVariables(), witness) == minterms[0]);
+                        }
+                        if (!maxterms.empty()) {
+                            REQUIRE(getLine(expression->getVariables(), counterexample) == maxterms[0]);
+                        }
+                    }
+                }
+            }
+        }
+
+        WHEN("An expression of too many variables to evaluate has an early line with the value") {
+            string function = "v0";
+            for (int i = 1; i < 50; ++i) {
+                function += " & v" + to_string(i);
+            }
+            EvaluationOptions options;
+            options.memoryBudget = 1 << 20;
+            const unique_ptr<Expression> expression = parser.compile("(" + function + ") | !v20 | ($x & v40)", lookup);
+
+            THEN("It's found by evaluating the blocks up to it") {
+                VariableAssignment counterexample;
+                REQUIRE_FALSE(isTautology(*expression, counterexample, options));
+                const vector<string> &variables = expression->getVariables();
+                const TruthTableUInt v20 = (TruthTableUInt) (find(variables.begin(), variables.end(), "v20") - variables.begin());
+                REQUIRE(getLine(variables, counterexample) == ((TruthTableUInt) 1) << v20);
+                VariableAssignment witness;
+                REQUIRE(isSatisfiable(*expression, witness, options));
+                REQUIRE(getLine(variables, witness) == 0);
+                options.memoryBudget = 1024;
+                CHECK_THROWS_AS(isSatisfiable(*expression, witness, options), MemoryLimitExceededException);
+            }
+        }
+
+        WHEN("An expression of too many variables to evaluate has its only line with the value last") {
+            string function = "v0";
+            for (int i = 1; i < 50; ++i) {
+                function += " & v" + to_string(i);
+            }
+            EvaluationOptions options;
+            options.memoryBudget = 1 << 20;
+            options.workBudget = ((TruthTableUInt) 1) << 24;
+            const unique_ptr<Expression> expression = parser.compile(function, lookup);
+
+            THEN("The scan fails once it's evaluated as many lines as the work budget allows, instead of going on for days") {
+                VariableAssignment line;
+                REQUIRE_THROWS_AS(isSatisfiable(*expression, line, options), WorkLimitExceededException);
+                REQUIRE_THROWS_AS(isTautology(*parser.compile("!(" + function + ")", lookup), line, options), WorkLimitExceededException);
+                REQUIRE_FALSE(isTautology(*expression, line, options));
+                REQUIRE(getLine(expression->getVariables(), line) == 0);
+            }
+        }
+    }
+}
+
+
+SCENARIO("Expressions are compared a block at a time, up to the first line they differ at", "[Expression]") {
+    GIVEN("A BooleanFunctionParser and a workspace function") {
+        BooleanFunctionParser parser;
+        const BooleanFunction x = parser.parse("(a & !b) | (c ^ d)");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "x") {
+                return x;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Pairs of expressions are compared, with and without a thread pool") {
+            ThreadPool pool(3);
+            EvaluationOptions concurrent;
+            concurrent.threadPool = &pool;
+            const vector<pair<string, string>> pairs({ { "$x", "$x" }, { "$x", "(c ^ d) | (!b & a)" }, { "$x", "$x | (a & b)" },
+                                                       { "$x", "!$x" }, { "$x[a = 1]", "!b | (d ^ c)" }, { "$x", "$x & e" },
+                                                       { "$x", "1" }, { "a | !a", "1" }, { "0", "$x[3]" }, { "$x & !a", "$x[a = 0] & !a" } });
+
+            THEN("They're equal as their evaluated functions are, and else, they differ at the counterexample first") {
+                for (const pair<string, string> &functions : pairs) {
+                    const unique_ptr<Expression> first = parser.compile(functions.first, lookup);
+                    const unique_ptr<Expression> second = parser.compile(functions.second, lookup);
+                    const bool expected = first->evaluate(EvaluationOptions()) == second->evaluate(EvaluationOptions());
+                    REQUIRE(parser.parse("(" + functions.first + ") == (" + functions.second + ")", lookup) == BooleanFunction(expected));
+                    for (const EvaluationOptions &options : { EvaluationOptions(), concurrent }) {
+                        VariableAssignment counterexample;
+                        REQUIRE(equals(*first, *second, &counterexample, options) == expected);
+                        if (!expected && !counterexample.empty()) {
+                            REQUIRE(evaluate(*first, counterexample) != evaluate(*second, counterexample));
+                            // The first line of their Xor that's 1, in the first expression's variable order
+                            const BooleanFunction difference = parser.parse("(" + functions.first + ") ^ (" + functions.second + ")", lookup);
+                            TruthTableUInt line = 0;
+                            for (size_t i = 0; i < first->getVariables().size(); ++i) {
+                                line |= (counterexample.at(first->getVariables()[i]) ? (TruthTableUInt) 1 : 0) << i;
+                            }
+                            REQUIRE(difference.getTruthTable().getVariables() == first->getVariables());
+                            REQUIRE(line == difference.getTruthTable().getMinterms()[0]);
+                        }
+                    }
+                }
+            }
+        }
+
+        WHEN("An operand of a comparison is invalid") {
+            THEN("It fails as evaluating it whole does, even if the operands' variables already tell them apart") {
+                CHECK_THROWS_AS(parser.parse("a == (b)[c = 1]", lookup), invalid_argument);
+                CHECK_THROWS_AS(parser.parse("a == (a)[5]", lookup), out_of_range);
+                CHECK_THROWS_AS(parser.parse("(b)[c = 1] == a", lookup), invalid_argument);
+                CHECK_THROWS_AS(parser.parse("($x == (1)[a = 0]) | a", lookup), IllegalStateException);
+                CHECK_THROWS_AS(parser.parse("($x[a = 1] == (a)[e = 1])[0]", lookup), invalid_argument);
+            }
+        }
+
+        WHEN("Expressions of too many variables to evaluate differ early") {
+            string conjunction = "v0";
+            string disjunction = "v0";
+            for (int i = 1; i < 40; ++i) {
+                conjunction += " & v" + to_string(i);
+                disjunction += " | v" + to_string(i);
+            }
+            EvaluationOptions options;
+            options.memoryBudget = 1 << 20;
+            BooleanFunctionParser limitedParser(options);
+            const unique_ptr<Expression> first = limitedParser.compile(conjunction, lookup);
+            const unique_ptr<Expression> second = limitedParser.compile("(" + conjunction + ") | (v5 & v20)", lookup);
+
+            THEN("They're compared up to the block they differ at") {
+                REQUIRE(limitedParser.parse("(" + conjunction + ") == (" + disjunction + ")", lookup) == BooleanFunction(false));
+                VariableAssignment counterexample;
+                REQUIRE_FALSE(equals(*first, *second, &counterexample, options));
+                for (int i = 0; i < 40; ++i) {
+                    REQUIRE(counterexample.at("v" + to_string(i)) == (i == 5 || i == 20));
+                }
+                options.memoryBudget = 1024;
+                CHECK_THROWS_AS(equals(*first, *second, &counterexample, options), MemoryLimitExceededException);
+                CHECK_THROWS_AS(BooleanFunctionParser(options).parse("(" + conjunction + ") == (" + disjunction + ")", lookup), MemoryLimitExceededException);
+            }
+        }
+    }
+}
@@ -17,6 +17,7 @@
 #include <catch.hpp>
 #include <core/Operators.hpp>
 #include <core/Utils.hpp>
+#include <memory>
 
 using namespace Logic;
 
@@ -240,10 +241,9 @@ SCENARIO("CombinatoryBinaryOperator work", "[Operator]") {
                     virtual bool operate(const bool value1, const bool value2) const {
                         UNUSED(value1);
                         UNUSED(value2);
-                        // operator will be called 8 times, because it first combines the tables
-                        // (ignoring duplicate variables), and then collapses
+                        // operator will be called once per line of the combined table, in order
                         // Safe to const_cast, because this is a weird case
-                        if (const_cast<MyOperator*>(this)->counter++ < 8) {
+                        if (const_cast<MyOperator*>(this)->counter++ < 4) {
                             return true;
                         }
                         return false;
@@ -266,3 +266,195 @@ SCENARIO("CombinatoryBinaryOperator work", "[Operator]") {
         }
     }
 }
+
+static BooleanFunction createFunction(const vector<string> &variables, unsigned seed) {
+    TruthTable table(variables);
+    for (TruthTableUInt i = 0; i < table.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        table[i] = ((seed >> 16) & 1) == 1;
+    }
+    return BooleanFunction(table);
+}
+
+// The operand's value on a line of a table with the given variables
+static bool getValueInLine(const BooleanFunction &operand, const vector<string> &variables, const TruthTableUInt line) {
+    if (operand.isConstant()) {
+        return operand.getConstantValue();
+    }
+
+    TruthTableUInt operandLine = 0;
+    const vector<string> &operandVariables = operand.getTruthTable().getVariables();
+    for (TruthTableVariablesUInt i = 0; i < operandVariables.size(); ++i) {
+        const size_t column = (size_t) (find(variables.begin(), variables.end(), operandVariables[i]) - variables.begin());
+        operandLine |= (TruthTableUInt) TruthTable::getVariableValueInLine((TruthTableVariablesUInt) column, line) << i;
+    }
+    return operand.getTruthTable()[operandLine];
+}
+
+SCENARIO("CombinatoryBinaryOperators combine chains of operands in a single pass", "[Operator]") {
+    GIVEN("Functions on overlapping variables, in different orders, and constants") {
+        const BooleanFunction small = createFunction({ "x2", "x0" }, 1);
+        const BooleanFunction contiguous = createFunction({ "x0", "x1", "x2", "x3" }, 2);
+        const BooleanFunction wide = createFunction({ "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7" }, 3);
+        const BooleanFunction scattered = createFunction({ "x7", "x1", "x9", "x4" }, 4);
+        const BooleanFunction reversed = createFunction({ "x9", "x8", "x7", "x6", "x5", "x4", "x3", "x2", "x1", "x0" }, 5);
+        const BooleanFunction one(true);
+        const BooleanFunction zero(false);
+
+        WHEN("Chains of And, Or and Xor are combined") {
+            THEN("Every line of the result is the operator applied on the operands' values, from left to right") {
+                const vector<vector<const BooleanFunction *>> chains = {
+                    { &small, &contiguous, &wide }, { &wide, &scattered, &reversed }, { &scattered, &one, &small, &reversed },
+                    { &contiguous, &zero, &scattered }, { &reversed, &wide, &contiguous, &small, &scattered }, { &small, &small }
+                };
+                const vector<CombinatoryBinaryOperator *> operators = { new And(), new Or(), new Xor() };
+                for (const CombinatoryBinaryOperator *_operator : operators) {
+                    for (const vector<const BooleanFunction *> &chain : chains) {
+                        const BooleanFunction result = (*_operator)(chain);
+                        vector<vector<string>> variables;
+                        for (const BooleanFunction *operand : chain) {
+                            variables.push_back(operand->isConstant() ? vector<string>() : operand->getTruthTable().getVariables());
+                        }
+                        REQUIRE(result.getTruthTable().getVariables() == _operator->getResultVariables(variables));
+
+                        for (TruthTableUInt line = 0; line < result.getTruthTable().size(); ++line) {
+                            bool expected = getValueInLine(*chain[0], result.getTruthTable().getVariables(), line);
+                            for (size_t i = 1; i < chain.size(); ++i) {
+                                const bool value = getValueInLine(*chain[i], result.getTruthTable().getVariables(), line);
+                                expected = _operator->getName() == "And" ? expected && value :
+                                           _operator->getName() == "Or" ? expected || value :
+                                           expected != value;
+                            }
+                            REQUIRE(result.getTruthTable()[line] == expected);
+                        }
+                    }
+                    delete _operator;
+                }
+            }
+        }
+
+        WHEN("Only constants are combined") {
+            THEN("The result is a constant") {
+                const BooleanFunction result = Xor()({ &one, &one, &one });
+                REQUIRE(result.isConstant());
+                REQUIRE(result.getConstantValue());
+            }
+        }
+
+        WHEN("An And chain's result is known to be 0 early") {
+            class CountingAnd : public And {
+            public:
+                int calls = 0;
+            private:
+                virtual uint64_t operateWords(const uint64_t first, const uint64_t second, const unsigned numLines) const {
+                    UNUSED(numLines);
+                    // Safe to const_cast, because this is a weird case
+                    ++const_cast<CountingAnd*>(this)->calls;
+                    return first & second;
+                }
+            };
+
+            CountingAnd countingAnd;
+            const BooleanFunction result = countingAnd({ &wide, &zero, &reversed, &scattered });
+
+            THEN("The remaining operands aren't combined") {
+                REQUIRE(result.getTruthTable().getMinterms().empty());
+                REQUIRE(result.getTruthTable().getVariables().size() == 10);
+                REQUIRE(countingAnd.calls == 16);
+            }
+        }
+    }
+}
+
+SCENARIO("Quantifiers combine the cofactors of a function", "[Operator]") {
+    GIVEN("Functions of a few variables and of many words") {
+        const BooleanFunction small = createFunction({ "x0", "x1", "x2" }, 6);
+        vector<string> variables;
+        for (int i = 0; i < 10; ++i) {
+            variables.push_back("x" + to_string(i));
+        }
+        const BooleanFunction wide = createFunction(variables, 7);
+
+        WHEN("Variables within words, across words, and ones the functions don't have are quantified") {
+            THEN("Every line of the result combines the operand's lines with every value of the quantified variables") {
+                const vector<vector<string>> quantifiedLists = {
+                    { "x1" }, { "x7" }, { "x0", "x2" }, { "x9", "x3", "x6", "x0" }, { "x5", "x4", "x3", "x2", "x1" },
+                    { "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9" }, { "x2", "y" }
+                };
+                for (const BooleanFunction *function : { &small, &wide }) {
+                    const vector<string> &functionVariables = function->getTruthTable().getVariables();
+                    for (const vector<string> &quantified : quantifiedLists) {
+                        for (const bool exists : { true, false }) {
+                            unique_ptr<Quantifier> quantifier(exists ? (Quantifier *) new Exists(quantified) : new Forall(quantified));
+                            const BooleanFunction result = (*quantifier)(*function);
+                            const vector<string> resultVariables = quantifier->getResultVariables(functionVariables);
+                            REQUIRE(result.getTruthTable().getVariables() == resultVariables);
+
+                            vector<TruthTableVariablesUInt> columns;
+                            for (TruthTableVariablesUInt i = 0; i < functionVariables.size(); ++i) {
+                                if (!contains(resultVariables, functionVariables[i])) {
+                                    columns.push_back(i);
+                                }
+                            }
+                            for (TruthTableUInt line = 0; line < result.getTruthTable().size(); ++line) {
+                                TruthTableUInt operandLine = 0;
+                                for (TruthTableVariablesUInt i = 0, j = 0; i < functionVariables.size(); ++i) {
+                                    if (contains(resultVariables, functionVariables[i])) {
+                                        operandLine |= ((line >> j++) & 1) << i;
+                                    }
+                                }
+                                bool expected = !exists;
+                                for (TruthTableUInt values = 0; values >> columns.size() == 0; ++values) {
+                                    TruthTableUInt cofactorLine = operandLine;
+                                    for (size_t k = 0; k < columns.size(); ++k) {
+                                        cofactorLine |= ((values >> k) & 1) << columns[k];
+                                    }
+                                    const bool value = function->getTruthTable()[cofactorLine];
+                                    expected = exists ? expected || value : expected && value;
+                                }
+                                REQUIRE(result.getTruthTable()[line] == expected);
+
+                                // The same line without the operand's table
+                                VariableAssignment assignment;
+                                for (TruthTableVariablesUInt i = 0; i < resultVariables.size(); ++i) {
+                                    assignment[resultVariables[i]] = TruthTable::getVariableValueInLine(i, line);
+                                }
+                                REQUIRE(quantifier->evaluateAt(assignment, functionVariables, [&](const VariableAssignment &operandAssignment) {
+                                    TruthTableUInt assignedLine = 0;
+                                    for (TruthTableVariablesUInt i = 0; i < functionVariables.size(); ++i) {
+                                        assignedLine |= (TruthTableUInt) operandAssignment.at(functionVariables[i]) << i;
+                                    }
+                                    return function->getTruthTable()[assignedLine];
+                                }) == expected);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        WHEN("Every variable is quantified") {
+            THEN("The result is a constant") {
+                const BooleanFunction exists = Exists({ "x0", "x1", "x2" })(small);
+                const BooleanFunction forall = Forall({ "x2", "x0", "x1" })(small);
+                REQUIRE(exists.isConstant());
+                REQUIRE(exists.getConstantValue() == !small.getTruthTable().getMinterms().empty());
+                REQUIRE(forall.isConstant());
+                REQUIRE(forall.getConstantValue() == (small.getTruthTable().count() == 8));
+                REQUIRE(Exists({ "x0" })(BooleanFunction(true)).getConstantValue());
+            }
+        }
+
+        WHEN("The operators are created from their symbols") {
+            THEN("The variables are listed once, and must be variable names") {
+                unique_ptr<UnaryOperator> exists(createUnaryOperatorWithSymbol("exists[ a, b,a ]"));
+                REQUIRE(exists->getDescription() == "Exists[a, b]");
+                unique_ptr<UnaryOperator> forall(createUnaryOperatorWithSymbol("forall [c]"));
+                REQUIRE(forall->getDescription() == "Forall[c]");
+                REQUIRE(isKnownSuffixUnaryOperator("exists[a]"));
+                CHECK_THROWS_AS({ createUnaryOperatorWithSymbol("exists[a = 1]"); }, invalid_argument);
+                CHECK_THROWS_AS({ createUnaryOperatorWithSymbol("forall[a,,b]"); }, invalid_argument);
+            }
+        }
+    }
+}
@@ -0,0 +1,287 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <core/Exceptions.hpp>
+#include <core/Optimizer.hpp>
+
+using namespace Logic;
+
+SCENARIO("The chains of associative operators are regrouped, without changing their results", "[Optimizer]") {
+    GIVEN("Parsers with and without the chain regrouping and the fusion, and workspace functions on overlapping variables") {
+        EvaluationOptions unoptimizedOptions;
+        unoptimizedOptions.reorderChains = false;
+        unoptimizedOptions.fuseOperators = false;
+        BooleanFunctionParser unoptimizedParser(unoptimizedOptions);
+        EvaluationOptions regroupingOptions;
+        regroupingOptions.fuseOperators = false;
+        BooleanFunctionParser regroupingParser(regroupingOptions);
+        EvaluationOptions fusionOptions;
+        fusionOptions.reorderChains = false;
+        BooleanFunctionParser fusionParser(fusionOptions);
+        BooleanFunctionParser parser;
+        const BooleanFunction a = parser.parse("x1 & x2 & x3 & x4 & x5 & x6");
+        const BooleanFunction b = parser.parse("y1 | y2 | y3 | y4 | y5 | y6");
+        const BooleanFunction c = parser.parse("x1 ^ x2 ^ x3 ^ x4 ^ x5 ^ x6");
+        const BooleanFunction d = parser.parse("!y1 & y2 & !y3");
+        const BooleanFunction e = parser.parse("x1 & !x2 & z");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "a") {
+                return a;
+            } else if (name == "b") {
+                return b;
+            } else if (name == "c") {
+                return c;
+            } else if (name == "d") {
+                return d;
+            } else if (name == "e") {
+                return e;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Chains are compiled with and without the regrouping") {
+            THEN("The results and their variables' order are the same, with and without the fusion") {
+                for (const string function : { "$a & $b & $c & $d", "$b | $a | $d | $c", "$a ^ $b ^ $c ^ $d", "p & $a & x1 & r",
+                                               "$a & ($b | $c) & $d", "($a & $b) | ($c & $d) | x1", "!($a & $b & $c)[x1 = 1] & $d",
+                                               "$a & $b & $c == $d", "1 & $a & 0 & $b", "r & $a & q & x2", "$a & $b & $e", "$e | $d | $a | $b" }) {
+                    const BooleanFunction unoptimized = unoptimizedParser.compile(function, lookup)->evaluate(EvaluationOptions());
+                    for (const BooleanFunctionParser *optimizedParser : { &regroupingParser, &parser }) {
+                        const BooleanFunction optimized = optimizedParser->compile(function, lookup)->evaluate(EvaluationOptions());
+                        REQUIRE(optimized == unoptimized);
+                        REQUIRE(optimized.hasTruthTable() == unoptimized.hasTruthTable());
+                        if (optimized.hasTruthTable()) {
+                            REQUIRE(optimized.getTruthTable().getVariables() == unoptimized.getTruthTable().getVariables());
+                        }
+                    }
+                }
+            }
+        }
+
+        WHEN("A chain interleaving the operands on two sets of variables is compiled without the fusion") {
+            unique_ptr<Expression> optimized = regroupingParser.compile("$a & $b & $c & $d", lookup);
+            unique_ptr<Expression> unoptimized = unoptimizedParser.compile("$a & $b & $c & $d", lookup);
+
+            THEN("The operands on the same variables are combined first, which allocates less") {
+                const BinaryOperatorExpression &root = dynamic_cast<const BinaryOperatorExpression &>(*optimized);
+                REQUIRE(root.getFirst().getVariables() == a.getTruthTable().getVariables());
+                REQUIRE(root.getSecond().getVariables() == b.getTruthTable().getVariables());
+                REQUIRE(optimized->estimatePeakMemoryUsage() < unoptimized->estimatePeakMemoryUsage());
+                REQUIRE(optimized->estimateTotalWork() < unoptimized->estimateTotalWork());
+            }
+        }
+
+        WHEN("The same chain is compiled with both the regrouping and the fusion") {
+            unique_ptr<Expression> optimized = parser.compile("$a & $b & $c & $d", lookup);
+            unique_ptr<Expression> fused = fusionParser.compile("$a & $b & $c & $d", lookup);
+
+            THEN("The regrouped chain is fused, with the operands on the same variables next to each other") {
+                const FusedOperatorExpression &root = dynamic_cast<const FusedOperatorExpression &>(*optimized);
+                REQUIRE(root.getDescription() == "And");
+                vector<string> operands;
+                for (const unique_ptr<Expression> &operand : root.getOperands()) {
+                    operands.push_back(operand->getDescription());
+                }
+                REQUIRE(operands == vector<string>({ "$a", "$c", "$b", "$d" }));
+                REQUIRE(dynamic_cast<const FusedOperatorExpression &>(*fused).getOperands()[1]->getDescription() == "$b");
+                REQUIRE(optimized->getVariables() == fused->getVariables());
+            }
+        }
+
+        WHEN("The cheapest grouping would change the order of the variables") {
+            unique_ptr<Expression> expression = regroupingParser.compile("$a & $b & $e", lookup);
+
+            THEN("The chain is left as it's parsed") {
+                const BinaryOperatorExpression &root = dynamic_cast<const BinaryOperatorExpression &>(*expression);
+                REQUIRE(root.getFirst().getDescription() == "$a");
+                REQUIRE(root.getSecond().getVariables() == unoptimizedParser.compile("$b & $e", lookup)->getVariables());
+            }
+        }
+    }
+}
+
+SCENARIO("The neighbouring word-wise operators are fused, without changing their results", "[Optimizer]") {
+    GIVEN("Parsers with and without the fusion, and workspace functions on overlapping variables") {
+        EvaluationOptions options;
+        options.reorderChains = false;
+        options.fuseOperators = false;
+        options.pushDownConditions = false;
+        BooleanFunctionParser unoptimizedParser(options);
+        BooleanFunctionParser parser;
+        const BooleanFunction a = parser.parse("x1 & x2 & x3 & x4 & x5 & x6");
+        const BooleanFunction b = parser.parse("y1 | y2 | y3 | y4 | y5 | y6");
+        const BooleanFunction c = parser.parse("x1 ^ x2 ^ x3 ^ x4 ^ x5 ^ x6");
+        const BooleanFunction d = parser.parse("!y1 & y2 & !y3");
+        const BooleanFunction e = parser.parse("x1 & !x2 & z");
+        const BooleanFunction f = parser.parse("w1 | w2 | w3 | w4 | w5 | w6 | w7 | w8");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "a") {
+                return a;
+            } else if (name == "b") {
+                return b;
+            } else if (name == "c") {
+                return c;
+            } else if (name == "d") {
+                return d;
+            } else if (name == "e") {
+                return e;
+            } else if (name == "f") {
+                return f;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Expressions are compiled with and without the fusion") {
+            THEN("The results and their variables' order are the same") {
+                for (const string function : { "$a & $b & $c & $d", "$b | $a | $d | $c", "$a ^ $b ^ $c ^ $d", "p & $a & x1 & r",
+                                               "$a & ($b | $c) & $d", "($a & $b) | ($c & $d) | x1", "!($a & $b & $c)[x1 = 1] & $d",
+                                               "$a & $b & $c == $d", "1 & $a & 0 & $b", "r & $a & q & x2", "$a & $b & $e", "$e | $d | $a | $b",
+                                               "$f & $a & $d", "$d ^ $f ^ $e ^ 1", "$f | $b | x1 | $e", "$a == $c == $e == x1", "$e & ($f & $d)",
+                                               "1 | $a | 1", "0 ^ 1 ^ 1", "a & b & c & d & e & f & g", "!($a & $b)", "!($f | $d)", "!$a | $b",
+                                               "$a & !$c", "($a ^ $b) & $e", "!(!$a ^ !($b | 1)) & !0", "!!$f", "($a & $b)[x1 = 1] | !$c",
+                                               "!($a & ($b | $c)) ^ ($d & !$e)", "!(1 & 0)" }) {
+                    const BooleanFunction optimized = parser.compile(function, lookup)->evaluate(EvaluationOptions());
+                    const BooleanFunction unoptimized = unoptimizedParser.compile(function, lookup)->evaluate(EvaluationOptions());
+                    REQUIRE(optimized == unoptimized);
+                    REQUIRE(optimized.hasTruthTable() == unoptimized.hasTruthTable());
+                    if (optimized.hasTruthTable()) {
+                        REQUIRE(optimized.getTruthTable().getVariables() == unoptimized.getTruthTable().getVariables());
+                    }
+                }
+            }
+        }
+
+        WHEN("A chain is compiled") {
+            EvaluationOptions fusionOptions;
+            fusionOptions.reorderChains = false;
+            unique_ptr<Expression> optimized = BooleanFunctionParser(fusionOptions).compile("$a & $b & ($c & $d)", lookup);
+            unique_ptr<Expression> unoptimized = unoptimizedParser.compile("$a & $b & ($c & $d)", lookup);
+
+            THEN("It's a single operation on all the operands, which allocates and processes less") {
+                const FusedOperatorExpression &root = dynamic_cast<const FusedOperatorExpression &>(*optimized);
+                REQUIRE(root.getDescription() == "And");
+                REQUIRE(root.getOperands().size() == 4);
+                REQUIRE(root.getOperands()[2]->getDescription() == "$c");
+                REQUIRE(optimized->getVariables() == unoptimized->getVariables());
+                REQUIRE(optimized->estimatePeakMemoryUsage() < unoptimized->estimatePeakMemoryUsage());
+                REQUIRE(optimized->estimateTotalWork() < unoptimized->estimateTotalWork());
+            }
+        }
+
+        WHEN("Different operators are nested") {
+            EvaluationOptions fusionOptions;
+            fusionOptions.pushDownConditions = false;
+            unique_ptr<Expression> optimized = BooleanFunctionParser(fusionOptions).compile("!($a & $b) | ($c ^ !$d)[x1 = 1] | $e", lookup);
+            unique_ptr<Expression> unoptimized = unoptimizedParser.compile("!($a & $b) | ($c ^ !$d)[x1 = 1] | $e", lookup);
+
+            THEN("The operators on either side of the other operators are fused separately") {
+                const FusedOperatorExpression &root = dynamic_cast<const FusedOperatorExpression &>(*optimized);
+                REQUIRE(root.getDescription() == "Or(Not(And), _, _)");
+                REQUIRE(root.getOperands().size() == 4);
+                const UnaryOperatorExpression &conditions = dynamic_cast<const UnaryOperatorExpression &>(*root.getOperands()[2]);
+                REQUIRE(conditions.getOperand().getDescription() == "Xor(_, Not)");
+                REQUIRE(optimized->getVariables() == unoptimized->getVariables());
+                REQUIRE(optimized->estimatePeakMemoryUsage() < unoptimized->estimatePeakMemoryUsage());
+            }
+        }
+
+        WHEN("Single operators are separated by other operators") {
+            EvaluationOptions fusionOptions;
+            fusionOptions.pushDownConditions = false;
+            unique_ptr<Expression> expression = BooleanFunctionParser(fusionOptions).compile("($a & $b)[x1 = 1] | $c", lookup);
+
+            THEN("They're left as they are") {
+                const BinaryOperatorExpression &root = dynamic_cast<const BinaryOperatorExpression &>(*expression);
+                REQUIRE(root.getOperator().getName() == "Or");
+                const UnaryOperatorExpression &conditions = dynamic_cast<const UnaryOperatorExpression &>(root.getFirst());
+                REQUIRE(dynamic_cast<const BinaryOperatorExpression &>(conditions.getOperand()).getOperator().getName() == "And");
+            }
+        }
+
+        WHEN("Different operators are mixed") {
+            unique_ptr<Expression> expression = parser.compile("$a | $b & $c & $d", lookup);
+
+            THEN("The lazy precedence is kept") {
+                const FusedOperatorExpression &root = dynamic_cast<const FusedOperatorExpression &>(*expression);
+                REQUIRE(root.getDescription() == "Or(_, And)");
+                REQUIRE(root.getOperands().size() == 4);
+            }
+        }
+    }
+}
+
+SCENARIO("Conditions are pushed down to the leaves, without changing their results", "[Optimizer]") {
+    GIVEN("Parsers with and without the pushdown, and workspace functions on overlapping variables") {
+        EvaluationOptions options;
+        options.pushDownConditions = false;
+        BooleanFunctionParser unoptimizedParser(options);
+        BooleanFunctionParser parser;
+        const BooleanFunction a = parser.parse("(x1 & x2) | (x3 ^ x4) | !x5");
+        const BooleanFunction b = parser.parse("x4 | (y1 & x1) | y2");
+        const BooleanFunction c = parser.parse("y1 ^ y2 ^ x5");
+        auto lookup = [&](const string &name) -> const BooleanFunction& {
+            if (name == "a") {
+                return a;
+            } else if (name == "b") {
+                return b;
+            } else if (name == "c") {
+                return c;
+            }
+            throw BooleanFunctionNotFoundException(name);
+        };
+
+        WHEN("Conditioned expressions are compiled with and without the pushdown") {
+            THEN("The results and their variables' order are the same") {
+                for (const string function : { "($a & $b)[x1 = 1]", "($a | !$c)[x5 = 0, y1 = 1]", "(!($a ^ $b) & $c)[x4 = 1, x1 = 0, y2 = 1]",
+                                               "(($a & $b)[x1 = 1] | $c)[y1 = 0]", "($a & $b)[x1 = 1, x1 = 0]", "(($a & x9)[x9 = 1] ^ $b)[x2 = 0]",
+                                               "($a & $b & $c)[x1 = 1, x2 = 1, x3 = 0, x4 = 1, x5 = 0, y1 = 1, y2 = 0]", "($a[3] | $b)[y1 = 1]",
+                                               "(($a == $b) | $c)[y2 = 0]", "(1 & $a)[x3 = 1]", "((x1 | 0) & $b)[x1 = 0]",
+                                               "(($a & $b) exists[x1, y1])[x4 = 1]", "($a | $c) forall[x5][x3 = 0, y2 = 1]" }) {
+                    const BooleanFunction optimized = parser.compile(function, lookup)->evaluate(EvaluationOptions());
+                    const BooleanFunction unoptimized = unoptimizedParser.compile(function, lookup)->evaluate(EvaluationOptions());
+                    REQUIRE(optimized == unoptimized);
+                    REQUIRE(optimized.hasTruthTable() == unoptimized.hasTruthTable());
+                    if (optimized.hasTruthTable()) {
+                        REQUIRE(optimized.getTruthTable().getVariables() == unoptimized.getTruthTable().getVariables());
+                    }
+                }
+            }
+
+            THEN("The conditions that fail still fail") {
+                for (const string function : { "($a & $b)[z = 1]", "($a == $b)[x1 = 1]", "($a[0] & 1)[x1 = 1]" }) {
+                    CHECK_THROWS(parser.parse(function, lookup));
+                    CHECK_THROWS(unoptimizedParser.parse(function, lookup));
+                }
+            }
+        }
+
+        WHEN("A conditioned expression is compiled") {
+            unique_ptr<Expression> optimized = parser.compile("(!$a & ($b ^ $c))[x1 = 1, y2 = 0]", lookup);
+            unique_ptr<Expression> unoptimized = unoptimizedParser.compile("(!$a & ($b ^ $c))[x1 = 1, y2 = 0]", lookup);
+
+            THEN("The leaves are conditioned on their own variables, which takes less work") {
+                const FusedOperatorExpression &root = dynamic_cast<const FusedOperatorExpression &>(*optimized);
+                REQUIRE(root.getOperands().size() == 3);
+                REQUIRE(root.getOperands()[0]->getDescription() == "Conditions[x1 = 1]");
+                REQUIRE(root.getOperands()[1]->getDescription() == "Conditions[x1 = 1, y2 = 0]");
+                REQUIRE(root.getOperands()[2]->getDescription() == "Conditions[y2 = 0]");
+                REQUIRE(optimized->getVariables() == unoptimized->getVariables());
+                REQUIRE(optimized->estimateTotalWork() < unoptimized->estimateTotalWork());
+            }
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <core/Profiler.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <core/ThreadPool.hpp>
+
+using namespace Logic;
+
+SCENARIO("Latency histograms estimate the percentiles", "[Profiler]") {
+    GIVEN("A histogram with the latencies 1 to 1000 ns") {
+        LatencyHistogram histogram;
+        for (uint64_t i = 1; i <= 1000; ++i) {
+            histogram.add(i);
+        }
+
+        THEN("The exact stats are kept, and the percentiles are within a bucket of the real ones") {
+            REQUIRE(histogram.getCount() == 1000);
+            REQUIRE(histogram.getTotal() == 500500);
+            REQUIRE(histogram.getMax() == 1000);
+            REQUIRE(histogram.getPercentile(50) >= 500);
+            REQUIRE(histogram.getPercentile(50) <= 500 * 1.19 + 1);
+            REQUIRE(histogram.getPercentile(99) >= 990);
+            REQUIRE(histogram.getPercentile(100) == 1000);
+        }
+    }
+
+    GIVEN("An empty histogram") {
+        LatencyHistogram histogram;
+
+        THEN("The percentiles are 0") {
+            REQUIRE(histogram.getPercentile(50) == 0);
+        }
+    }
+}
+
+SCENARIO("The profiler records the evaluated operators", "[Profiler]") {
+    GIVEN("A profiler in the evaluation options") {
+        Profiler profiler;
+        EvaluationOptions options;
+        options.profiler = &profiler;
+        options.fuseOperators = false;
+
+        WHEN("An expression is parsed for a statement") {
+            ProfileCounters counters;
+            {
+                ScopedProfileCounters scope(&counters);
+                BooleanFunctionParser(options).parse("!(a & b) | c");
+            }
+
+            THEN("Every operator is recorded with its rows and result size, which also count towards the statement") {
+                const map<string, ProfileEntry> operators = profiler.getOperators();
+                REQUIRE(operators.size() == 3);
+                // 2 + 2 operand rows, 4 result rows
+                REQUIRE(operators.at("And").latencies.getCount() == 1);
+                REQUIRE(operators.at("And").rows == 8);
+                REQUIRE(operators.at("And").resultBytes == 1);
+                REQUIRE(operators.at("Not").rows == 8);
+                // 4 + 2 operand rows, 8 result rows
+                REQUIRE(operators.at("Or").rows == 14);
+                REQUIRE(counters.rows == 30);
+                REQUIRE(counters.resultBytes == 3);
+                REQUIRE(Profiler::getCurrentCounters() == nullptr);
+            }
+        }
+
+        WHEN("The operators are fused") {
+            options.fuseOperators = true;
+            BooleanFunctionParser(options).parse("!(a & b) | c");
+
+            THEN("They're recorded as a single operator") {
+                const map<string, ProfileEntry> operators = profiler.getOperators();
+                REQUIRE(operators.size() == 1);
+                // 2 + 2 + 2 operand rows, 8 result rows
+                REQUIRE(operators.at("Or(Not(And), _)").rows == 14);
+            }
+        }
+
+        WHEN("The operands are evaluated concurrently") {
+            ThreadPool pool(2);
+            options.threadPool = &pool;
+            options.forkThreshold = 1;
+            ProfileCounters counters;
+            {
+                ScopedProfileCounters scope(&counters);
+                BooleanFunctionParser(options).parse("(a & b) ^ (c | d)");
+            }
+
+            THEN("The forked operators count towards the same statement") {
+                REQUIRE(profiler.getOperators().size() == 3);
+                // 8 + 8 rows for the operands, and 4 + 4 + 16 for the Xor
+                REQUIRE(counters.rows == 40);
+            }
+        }
+    }
+}
+
+SCENARIO("Hardware counter values are combined", "[Profiler]") {
+    GIVEN("Two readings of the counters, with the cache misses unavailable") {
+        HardwareCounterValues before;
+        HardwareCounterValues after;
+        for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+            before.available[i] = after.available[i] = i != CACHE_MISSES;
+            before.values[i] = 10;
+            after.values[i] = 25;
+        }
+
+        WHEN("They are subtracted and summed") {
+            HardwareCounterValues total;
+            REQUIRE(!total.any());
+            total += after - before;
+            total += after - before;
+
+            THEN("Only the available counters are counted") {
+                REQUIRE(total.any());
+                REQUIRE(total.values[CYCLES] == 30);
+                REQUIRE(total.values[BRANCH_MISSES] == 30);
+                REQUIRE(!total.available[CACHE_MISSES]);
+                REQUIRE(total.values[CACHE_MISSES] == 0);
+            }
+        }
+    }
+
+    GIVEN("A profiler using the hardware counters") {
+        Profiler profiler(true);
+        EvaluationOptions options;
+        options.profiler = &profiler;
+
+        THEN("Profiling works whether the counters are available or not") {
+            BooleanFunctionParser(options).parse("a & b");
+            const ProfileEntry entry = profiler.getOperators().at("And");
+            REQUIRE(entry.latencies.getCount() == 1);
+            REQUIRE(entry.counters.any() == HardwareCounters::forCurrentThread().isAvailable());
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <core/ThreadPool.hpp>
+#include <atomic>
+#include <vector>
+
+using namespace Logic;
+
+SCENARIO("A ThreadPool executes the submitted tasks", "[ThreadPool]") {
+    GIVEN("A ThreadPool with multiple threads") {
+        ThreadPool pool(4);
+        REQUIRE(pool.size() == 4);
+
+        WHEN("Tasks are submitted") {
+            atomic<int> counter(0);
+            vector<future<int>> results;
+            for (int i = 0; i < 100; ++i) {
+                results.push_back(pool.submit([i, &counter]() {
+                    ++counter;
+                    return i * i;
+                }));
+            }
+
+            THEN("Each task is executed once, and its result is available through the future") {
+                for (int i = 0; i < 100; ++i) {
+                    REQUIRE(results[(size_t) i].get() == i * i);
+                }
+                REQUIRE(counter == 100);
+            }
+        }
+
+        WHEN("A task throws") {
+            future<void> result = pool.submit([]() {
+                throw invalid_argument("bad task");
+            });
+
+            THEN("The exception is rethrown by the future") {
+                CHECK_THROWS_AS(result.get(), invalid_argument);
+            }
+        }
+
+        WHEN("A task blocks on the result of a task submitted before it") {
+            shared_future<int> first = pool.submit([]() { return 1; }).share();
+            future<int> second = pool.submit([first]() { return first.get() + 1; });
+
+            THEN("The result is correct") {
+                REQUIRE(second.get() == 2);
+            }
+        }
+    }
+
+    GIVEN("An attempt to create a ThreadPool without threads") {
+        THEN("invalid_argument is thrown") {
+            CHECK_THROWS_AS({ ThreadPool pool(0); }, invalid_argument);
+        }
+    }
+}
+
+SCENARIO("A ForkedTask is run by either the pool or the joining thread", "[ThreadPool]") {
+    GIVEN("A ThreadPool with a single thread") {
+        ThreadPool pool(1);
+
+        WHEN("Tasks are forked and joined from within a task running on the pool") {
+            future<int> result = pool.submit([&pool]() {
+                ForkedTask<int> first(pool, []() { return 1; });
+                ForkedTask<int> second(pool, []() { return 2; });
+                return first.join() + second.join();
+            });
+
+            THEN("The pool doesn't deadlock, and the results are correct") {
+                REQUIRE(result.get() == 3);
+            }
+        }
+
+        WHEN("A forked task is joined twice") {
+            ForkedTask<int> task(pool, []() { return 1; });
+            REQUIRE(task.join() == 1);
+
+            THEN("IllegalStateException is thrown") {
+                CHECK_THROWS_AS(task.join(), IllegalStateException);
+            }
+        }
+    }
+}
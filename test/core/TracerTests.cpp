@@ -0,0 +1,95 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <core/Tracer.hpp>
+#include <core/BooleanFunctionParser.hpp>
+#include <core/ThreadPool.hpp>
+
+using namespace Logic;
+
+SCENARIO("Tracers collect the spans of every thread", "[Tracer]") {
+    GIVEN("A tracer") {
+        Tracer tracer;
+
+        WHEN("Nested spans are recorded") {
+            {
+                TraceSpan outer(&tracer, "outer", "test");
+                TraceSpan inner(&tracer, "inner", "test");
+                inner.addArgument("rows", 4);
+                inner.addArgument("name", "x");
+            }
+
+            THEN("The inner span ends first, and lies within the outer one") {
+                const vector<TraceThread> threads = tracer.getThreads();
+                REQUIRE(threads.size() == 1);
+                REQUIRE(threads[0].events.size() == 2);
+                const TraceEvent &inner = threads[0].events[0];
+                const TraceEvent &outer = threads[0].events[1];
+                REQUIRE(inner.name == "inner");
+                REQUIRE(outer.name == "outer");
+                REQUIRE(inner.start >= outer.start);
+                REQUIRE(inner.start + inner.duration <= outer.start + outer.duration);
+                REQUIRE(inner.arguments.size() == 2);
+                REQUIRE(inner.arguments[0].isNumber);
+                REQUIRE(inner.arguments[0].value == "4");
+                REQUIRE(!inner.arguments[1].isNumber);
+            }
+        }
+
+        WHEN("Spans are recorded on other threads") {
+            ThreadPool pool(2);
+            {
+                TraceSpan span(&tracer, "main", "test");
+            }
+            pool.submit([&]() { TraceSpan span(&tracer, "worker", "test"); }).get();
+
+            THEN("Each thread has its own events") {
+                const vector<TraceThread> threads = tracer.getThreads();
+                REQUIRE(threads.size() == 2);
+                REQUIRE(threads[0].id != threads[1].id);
+                REQUIRE(threads[0].events.size() == 1);
+                REQUIRE(threads[1].events.size() == 1);
+                REQUIRE(threads[1].events[0].name == "worker");
+            }
+        }
+
+        WHEN("An expression is parsed with the tracer") {
+            EvaluationOptions options;
+            options.tracer = &tracer;
+            options.fuseOperators = false;
+            BooleanFunctionParser(options).parse("!(a & b)");
+
+            THEN("The parse and every operator are traced") {
+                const vector<TraceThread> threads = tracer.getThreads();
+                REQUIRE(threads.size() == 1);
+                vector<string> names;
+                for (const TraceEvent &event : threads[0].events) {
+                    names.push_back(event.name);
+                }
+                REQUIRE(names == vector<string>({ "And", "Not", "parse" }));
+            }
+        }
+    }
+
+    GIVEN("No tracer") {
+        THEN("The spans do nothing") {
+            TraceSpan span(nullptr, "nothing", "test");
+            span.addArgument("rows", 1);
+        }
+    }
+}
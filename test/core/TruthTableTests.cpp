@@ -173,6 +173,10 @@ SCENARIO("A TruthTable stores the variable and data properly", "[TruthTable, Tru
                 REQUIRE(minterms[1] == 4);
             }
 
+            THEN("The table counts the lines that are 1") {
+                REQUIRE(table.count() == 2);
+            }
+
             THEN("The table returns the correct maxterms") {
                 vector<TruthTableUInt> maxterms = table.getMaxterms();
                 REQUIRE(maxterms.size() == 6);
@@ -209,6 +213,18 @@ SCENARIO("A TruthTable stores the variable and data properly", "[TruthTable, Tru
             CHECK_THROWS_AS({ TruthTable({"x", "hello", "x"}); }, invalid_argument);
         }
     }
+
+    WHEN("You try to create a truthtable with duplicate variables that would be too large to allocate") {
+        THEN("invalid_argument exception is thrown before the table is allocated") {
+            vector<string> vars;
+            // 2^50 lines would take 128 TiB
+            for (size_t i = 0; i < 49; ++i) {
+                vars.push_back("x" + to_string(i));
+            }
+            vars.push_back("x0");
+            CHECK_THROWS_AS({ TruthTable x(vars); }, invalid_argument);
+        }
+    }
 }
 
 SCENARIO("A TruthTable equality operator works properly", "[TruthTable]") {
@@ -246,6 +262,105 @@ SCENARIO("A TruthTable equality operator works properly", "[TruthTable]") {
     }
 }
 
+SCENARIO("A TruthTable can be reordered", "[TruthTable]") {
+    GIVEN("A TruthTable of x & !z, with an unrelated y") {
+        TruthTable table({"x", "y", "z"});
+        table[1] = true;
+        table[3] = true;
+
+        WHEN("It is reordered") {
+            TruthTable reordered = table.reorder({"z", "x", "y"});
+
+            THEN("It has the new order of the variables, and the same function") {
+                REQUIRE(reordered.getVariables() == vector<string>({"z", "x", "y"}));
+                REQUIRE(reordered == table);
+                REQUIRE(reordered.getMinterms() == vector<TruthTableUInt>({2, 6}));
+            }
+        }
+
+        WHEN("It is reordered with different variables") {
+            THEN("It fails") {
+                REQUIRE_THROWS_AS(table.reorder({"x", "y", "w"}), invalid_argument);
+            }
+        }
+    }
+}
+
+SCENARIO("A TruthTable finds the variables it depends on", "[TruthTable]") {
+    GIVEN("A TruthTable of x & !z, with an unrelated y") {
+        TruthTable table({"x", "y", "z"});
+        table[1] = true;
+        table[3] = true;
+
+        THEN("Its support is x and z") {
+            REQUIRE(table.dependsOn(0));
+            REQUIRE_FALSE(table.dependsOn(1));
+            REQUIRE(table.dependsOn(2));
+            REQUIRE(table.getSupport() == vector<string>({"x", "z"}));
+            REQUIRE_THROWS_AS(table.dependsOn(3), out_of_range);
+        }
+    }
+
+    GIVEN("A TruthTable of many words that depends on variables within and across the words") {
+        vector<string> variables;
+        for (int i = 0; i < 10; ++i) {
+            variables.push_back("v" + to_string(i));
+        }
+        TruthTable table(variables);
+        for (TruthTableUInt i = 0; i < table.size(); ++i) {
+            table[i] = (((i >> 2) ^ (i >> 8)) & 1) == 1 || (i & 0x21) == 0x21;
+        }
+
+        THEN("The variables it depends on are the ones in its expression") {
+            REQUIRE(table.getSupport() == vector<string>({"v0", "v2", "v5", "v8"}));
+        }
+    }
+}
+
+SCENARIO("A TruthTable's cofactors are taken", "[TruthTable]") {
+    GIVEN("A TruthTable of many words") {
+        vector<string> variables;
+        for (int i = 0; i < 10; ++i) {
+            variables.push_back("v" + to_string(i));
+        }
+        TruthTable table(variables);
+        for (TruthTableUInt i = 0; i < table.size(); ++i) {
+            table[i] = ((i * 2654435761u) >> 7) & 1;
+        }
+
+        THEN("Every cofactor has the lines where the variable has the value") {
+            for (TruthTableVariablesUInt column = 0; column < 10; ++column) {
+                for (bool value : {false, true}) {
+                    TruthTable cofactor = table.getCofactor(column, value);
+                    vector<string> cofactorVariables(variables);
+                    cofactorVariables.erase(cofactorVariables.begin() + column);
+                    REQUIRE(cofactor.getVariables() == cofactorVariables);
+                    for (TruthTableUInt i = 0; i < cofactor.size(); ++i) {
+                        const TruthTableUInt low = i & ((1u << column) - 1);
+                        const TruthTableUInt line = ((i >> column) << (column + 1)) | ((TruthTableUInt) value << column) | low;
+                        REQUIRE(cofactor[i] == table[line]);
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("TruthTables of a few variables") {
+        TruthTable table({"x", "y"});
+        table[1] = true;
+        table[2] = true;
+
+        THEN("The cofactors fit in a word, and a single variable has none") {
+            TruthTable cofactor = table.getCofactor(0, true);
+            REQUIRE(cofactor.getVariables() == vector<string>({"y"}));
+            REQUIRE(cofactor[0]);
+            REQUIRE_FALSE(cofactor[1]);
+            REQUIRE_THROWS_AS(table.getCofactor(2, false), out_of_range);
+            REQUIRE_THROWS_AS(TruthTable({"x"}).getCofactor(0, false), invalid_argument);
+        }
+    }
+}
+
 SCENARIO("A TruthTableBuilder builds a TruthTable", "[TruthTableBuilder]") {
     GIVEN("A TruthTableBuilder") {
         TruthTableBuilder builder;
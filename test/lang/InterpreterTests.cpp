@@ -0,0 +1,410 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <lang/Interpreter.hpp>
+#include <lang/Exceptions.hpp>
+#include <core/ThreadPool.hpp>
+#include <sstream>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace Logic;
+
+class CommandCounter : public CommandObserver {
+public:
+    virtual void onCommandExecuted(const string &command, const chrono::steady_clock::duration &elapsed) override {
+        UNUSED(elapsed);
+        lock_guard<mutex> guard(lock);
+        commands.push_back(command);
+    }
+
+    mutex lock;
+    vector<string> commands;
+};
+
+static string execute(const string &code, ThreadPool *threadPool, Runtime &runtime) {
+    DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+    stringstream in(code);
+    stringstream out;
+    Interpreter interpreter(runtime, dispatchTable, in, out, false, threadPool);
+    interpreter.run();
+    return out.str();
+}
+
+SCENARIO("Concurrent execution of the independent statements matches the sequential execution", "[Interpreter]") {
+    GIVEN("A script with independent and dependent statements, and barriers") {
+        const string code = "let x = a & b;"
+                            "let y = c | d;"
+                            "let z = $x ^ $y;"
+                            "p $z;"
+                            "let x = $x | e;"
+                            "v $x;"
+                            "min $y;"
+                            "if $z[3] { let w = 1; } else { let w = 0; }"
+                            "p $w;"
+                            "let x = $x & $w;"
+                            "max $x;";
+
+        WHEN("It is executed sequentially and concurrently") {
+            Runtime sequentialRuntime;
+            const string sequentialOutput = execute(code, nullptr, sequentialRuntime);
+
+            ThreadPool pool(4);
+            Runtime concurrentRuntime;
+            const string concurrentOutput = execute(code, &pool, concurrentRuntime);
+
+            THEN("The output and the runtime state are the same") {
+                REQUIRE(concurrentOutput == sequentialOutput);
+                for (const string name : { "x", "y", "z", "w" }) {
+                    REQUIRE(concurrentRuntime.get(name) == sequentialRuntime.get(name));
+                }
+            }
+        }
+    }
+
+    GIVEN("A script with a failing statement") {
+        const string code = "let x = a & b;"
+                            "p $x[3];"
+                            "let y = $missing;"
+                            "let x = 1;"
+                            "p 0;";
+
+        WHEN("It is executed concurrently") {
+            ThreadPool pool(4);
+            Runtime runtime;
+            DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+            stringstream in(code);
+            stringstream out;
+            Interpreter interpreter(runtime, dispatchTable, in, out, false, &pool);
+
+            THEN("The statements before the failure are applied, and the ones after it aren't") {
+                CHECK_THROWS_AS(interpreter.run(), BooleanFunctionNotFoundException);
+                REQUIRE(out.str() == "1\n");
+                REQUIRE(runtime.get("x").hasTruthTable());
+                REQUIRE(!runtime.contains("y"));
+            }
+        }
+    }
+}
+
+SCENARIO("The command observer sees every executed statement", "[Interpreter]") {
+    GIVEN("A script with nested statements, and independent statements after a failing statement") {
+        const string code = "let x = a & b;"
+                            "if 1 { p $x; min $x; }"
+                            "let y = $missing;"
+                            "let z = a | b;"
+                            "p $x;";
+        const auto observe = [&code](ThreadPool *pool) {
+            Runtime runtime;
+            DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+            stringstream in(code);
+            stringstream out;
+            Interpreter interpreter(runtime, dispatchTable, in, out, false, pool);
+            CommandCounter counter;
+            interpreter.setCommandObserver(&counter);
+            REQUIRE_THROWS_AS(interpreter.run(), BooleanFunctionNotFoundException);
+            REQUIRE_FALSE(runtime.contains("z"));
+            return counter.commands;
+        };
+        const vector<string> expected({ "let", "print", "minterms", "if", "let" });
+
+        WHEN("It is executed sequentially") {
+            const vector<string> commands = observe(nullptr);
+
+            THEN("The nested and the failed statements are observed by their command names in order, but not the ones after the failure") {
+                REQUIRE(commands == expected);
+            }
+        }
+
+        WHEN("It is executed concurrently") {
+            ThreadPool pool(2);
+            const vector<string> commands = observe(&pool);
+
+            THEN("The same statements are observed in the same order, even if the ones after the failure already ran") {
+                REQUIRE(commands == expected);
+            }
+        }
+    }
+}
+
+SCENARIO("The workspace keeps track of its memory usage, and limits the evaluations to it", "[Interpreter]") {
+    GIVEN("A runtime with a memory limit") {
+        Runtime runtime;
+        runtime.setMaxMemory(64 * 1024);
+        DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+
+        WHEN("Functions are defined, redefined and deleted") {
+            stringstream in("let x = a & b & c & d & e & f & g & h & i & j;"
+                            "let y = a | b;"
+                            "let y = a | b | c;"
+                            "let z = 1;"
+                            "delete z;");
+            stringstream out;
+            Interpreter(runtime, dispatchTable, in, out, false).run();
+
+            THEN("The memory usage is the sum of the functions' usages") {
+                REQUIRE(runtime.getMemoryUsage() == runtime.get("x").getMemoryUsage() + runtime.get("y").getMemoryUsage());
+                REQUIRE(runtime.getAvailableMemory() == 64 * 1024 - runtime.getMemoryUsage());
+                const vector<pair<string, uint64_t>> functions = runtime.getFunctionsByMemoryUsage();
+                REQUIRE(functions.size() == 2);
+                REQUIRE(functions[0].first == "x");
+                REQUIRE(functions[1].first == "y");
+            }
+        }
+
+        WHEN("A statement would need more memory than is available, sequentially or concurrently") {
+            for (const bool concurrent : { false, true }) {
+                ThreadPool pool(2);
+                stringstream in("let x = a & b;"
+                                "let y = a0 & a1 & a2 & a3 & a4 & a5 & a6 & a7 & a8 & a9 & b0 & b1 & b2 & b3 & b4 & b5 & b6 & b7 & b8 & b9;"
+                                "let z = 1;");
+                stringstream out;
+                Interpreter interpreter(runtime, dispatchTable, in, out, false, concurrent ? &pool : nullptr);
+
+                THEN("It fails without changing the workspace") {
+                    CHECK_THROWS_AS(interpreter.run(), MemoryLimitExceededException);
+                    REQUIRE(runtime.contains("x"));
+                    REQUIRE(!runtime.contains("y"));
+                    REQUIRE(!runtime.contains("z"));
+                }
+            }
+        }
+
+        WHEN("Statements that each fit in the limit, but not all together, are executed with 1 and 4 threads") {
+            // Each of these takes 16 KiB, and needs as much to be evaluated
+            string conjunction = "v0";
+            for (int i = 1; i < 17; ++i) {
+                conjunction += " & v" + to_string(i);
+            }
+            const string code = "let x = " + conjunction + ";"
+                                "let y = " + conjunction + " | w0;"
+                                "p $x[0];"
+                                "let z = " + conjunction + " | w1;"
+                                "let w = 1;";
+
+            vector<string> outputs;
+            vector<string> errors;
+            vector<uint64_t> usages;
+            for (const size_t numThreads : vector<size_t>({ 1, 4 })) {
+                ThreadPool pool(numThreads);
+                Runtime limited;
+                limited.setMaxMemory(64 * 1024);
+                stringstream in(code);
+                stringstream out;
+                try {
+                    Interpreter(limited, dispatchTable, in, out, false, numThreads > 1 ? &pool : nullptr).run();
+                    errors.push_back("");
+                } catch (const MemoryLimitExceededException &ex) {
+                    errors.push_back(ex.what());
+                }
+                outputs.push_back(out.str());
+                usages.push_back(limited.getMemoryUsage());
+                REQUIRE(limited.getMemoryUsage() <= 64 * 1024);
+                REQUIRE(limited.contains("y"));
+                REQUIRE_FALSE(limited.contains("z"));
+                REQUIRE_FALSE(limited.contains("w"));
+            }
+
+            THEN("They fail at the same statement, and the workspace stays within the limit") {
+                REQUIRE_FALSE(errors[0].empty());
+                REQUIRE(errors[1] == errors[0]);
+                REQUIRE(outputs[1] == outputs[0]);
+                REQUIRE(usages[1] == usages[0]);
+            }
+        }
+    }
+}
+
+SCENARIO("Impossible evaluations are rejected before evaluating them", "[Interpreter]") {
+    GIVEN("A function of 50 variables") {
+        string function = "v0";
+        for (int i = 1; i < 50; ++i) {
+            function += " & v" + to_string(i);
+        }
+        Runtime runtime;
+        DispatchTable dispatchTable = createDispatchTableWithAllCommands();
+
+        WHEN("It is explained") {
+            stringstream in("explain " + function + ";");
+            stringstream out;
+            Interpreter(runtime, dispatchTable, in, out, false).run();
+
+            THEN("The plan lists every operand and the fused chain, and notes that it would fail") {
+                REQUIRE(out.str().find("51    And    ") != string::npos);
+                REQUIRE(out.str().find("Would fail") != string::npos);
+            }
+        }
+
+        WHEN("It is defined or printed, even without a memory limit") {
+            for (const string &statement : { "let f = " + function + ";", "print " + function + ";" }) {
+                stringstream in(statement);
+                stringstream out;
+                Interpreter interpreter(runtime, dispatchTable, in, out, false);
+
+                THEN("It fails right away") {
+                    CHECK_THROWS_AS(interpreter.run(), MemoryLimitExceededException);
+                    REQUIRE(!runtime.contains("f"));
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("The bitmap command evaluates a function over bitmap columns", "[Interpreter]") {
+    GIVEN("Two columns of 16 records") {
+        char directory[] = "/tmp/logic_bitmap_XXXXXX";
+        const string path = mkdtemp(directory);
+        // a is 1 at the records 0-7 and 12, b at the records 4-11
+        const vector<pair<string, string>> columns = {{path + "/a.bin", string("\xFF\x10", 2)}, {path + "/b.bin", string("\xF0\x0F", 2)}};
+        for (const pair<string, string> &column : columns) {
+            ofstream(column.first, ios::binary) << column.second;
+        }
+        const string statement = "bitmap " + path + "/out.bin = $x | !a with a = " + path + "/a.bin, b = " + path + "/b.bin;";
+        Runtime runtime;
+        execute("let x = a & !b;", nullptr, runtime);
+
+        WHEN("It is executed") {
+            const string output = execute(statement, nullptr, runtime);
+
+            THEN("It writes the result, and prints the number of records it's 1 at") {
+                REQUIRE(output == "12 of 16 records\n");
+                ifstream result(path + "/out.bin", ios::binary);
+                REQUIRE(string(istreambuf_iterator<char>(result), istreambuf_iterator<char>()) == string("\x0F\xFF", 2));
+            }
+        }
+
+        WHEN("It is executed with the JSON output") {
+            runtime.setOutputFormat(OutputFormat::Json);
+            const string output = execute(statement, nullptr, runtime);
+
+            THEN("It prints the output and the counts as JSON") {
+                REQUIRE(output == "{\"output\":\"" + path + "/out.bin\",\"records\":16,\"count\":12}\n");
+            }
+        }
+
+        WHEN("Its args are malformed") {
+            THEN("It throws") {
+                CHECK_THROWS_AS(execute("bitmap " + path + "/out.bin = a;", nullptr, runtime), BadCommandArgumentsException);
+                CHECK_THROWS_AS(execute("bitmap " + path + "/out.bin = a with a;", nullptr, runtime), BadCommandArgumentsException);
+                CHECK_THROWS_AS(execute("bitmap " + path + "/out.bin = a with a = x, a = y;", nullptr, runtime), BadCommandArgumentsException);
+            }
+        }
+
+        for (const char *file : { "/a.bin", "/b.bin", "/out.bin" }) {
+            remove((path + file).c_str());
+        }
+        rmdir(path.c_str());
+    }
+}
+
+SCENARIO("The emit command generates the code of a function", "[Interpreter]") {
+    GIVEN("A function in the workspace") {
+        Runtime runtime;
+        execute("let f = a & b;", nullptr, runtime);
+
+        WHEN("It is emitted in C by its reference, or as an expression") {
+            const string byReference = execute("emit c $f;", nullptr, runtime);
+            const string byExpression = execute("emit c $f | 0;", nullptr, runtime);
+
+            THEN("The generated function is named after it, or named 'function'") {
+                REQUIRE(byReference.find("static inline bool f(bool a, bool b) {") != string::npos);
+                REQUIRE(byExpression.find("static inline bool function(bool a, bool b) {") != string::npos);
+            }
+        }
+
+        WHEN("It is emitted in an unknown language") {
+            THEN("It throws") {
+                CHECK_THROWS_AS(execute("emit rust $f;", nullptr, runtime), BadCommandArgumentsException);
+                CHECK_THROWS_AS(execute("emit c;", nullptr, runtime), BadCommandArgumentsException);
+            }
+        }
+    }
+}
+
+SCENARIO("The count command counts the lines of a function that are 1", "[Interpreter]") {
+    GIVEN("A function in the workspace") {
+        Runtime runtime;
+        execute("let f = (a & b) | c;", nullptr, runtime);
+
+        WHEN("Its count is printed, as text and as JSON") {
+            const string text = execute("count $f; count $f & d;", nullptr, runtime);
+            runtime.setOutputFormat(OutputFormat::Json);
+            const string json = execute("count $f;", nullptr, runtime);
+
+            THEN("It's the number of its minterms") {
+                REQUIRE(text == "5\n5\n");
+                REQUIRE(json == "{\"count\":5,\"variables\":3}\n");
+            }
+        }
+    }
+}
+
+SCENARIO("The sat and taut commands find the first line that shows whether they hold", "[Interpreter]") {
+    GIVEN("A function in the workspace") {
+        Runtime runtime;
+        execute("let f = (a & b) | c;", nullptr, runtime);
+
+        WHEN("It's checked, as text and as JSON") {
+            const string text = execute("sat $f; taut $f; sat $f & !$f; taut $f | !c; sat 1;", nullptr, runtime);
+            runtime.setOutputFormat(OutputFormat::Json);
+            const string json = execute("sat $f; taut $f; taut 1;", nullptr, runtime);
+
+            THEN("The witness and the counterexample are the first lines with the values") {
+                REQUIRE(text == "1 [a = 1, b = 1, c = 0]\n0 [a = 0, b = 0, c = 0]\n0\n1\n1\n");
+                REQUIRE(json == "{\"satisfiable\":true,\"witness\":{\"a\":true,\"b\":true,\"c\":false}}\n"
+                                "{\"tautology\":false,\"counterexample\":{\"a\":false,\"b\":false,\"c\":false}}\n"
+                                "{\"tautology\":true}\n");
+            }
+        }
+    }
+}
+
+SCENARIO("The support command prints the variables a function depends on", "[Interpreter]") {
+    GIVEN("A function with a variable it doesn't depend on") {
+        Runtime runtime;
+        execute("let f = (a & b) | (a & !b) | c;", nullptr, runtime);
+
+        WHEN("Its support and variables are printed, as text and as JSON") {
+            const string text = execute("support $f; variables $f; support $f & !$f;", nullptr, runtime);
+            runtime.setOutputFormat(OutputFormat::Json);
+            const string json = execute("support $f;", nullptr, runtime);
+
+            THEN("The support doesn't have the variable") {
+                REQUIRE(text == "c, a\nc, b, a\n\n");
+                REQUIRE(json == "[\"a\",\"c\"]\n");
+            }
+        }
+
+        WHEN("The supports of the evaluated functions are reduced") {
+            EvaluationOptions options = runtime.getEvaluationOptions();
+            options.reduceSupport = true;
+            runtime.setEvaluationOptions(options);
+            const string text = execute("let g = $f; variables $g; let h = $g ^ (d | !d); variables $h; print $g & !$g;", nullptr, runtime);
+
+            THEN("They don't have the variables they don't depend on") {
+                REQUIRE(text == "c, a\nc, a\n0\n");
+            }
+        }
+    }
+}
+
@@ -0,0 +1,80 @@
+/**
+ Copyright 2016 Udey Rishi
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <catch.hpp>
+#include <lang/Json.hpp>
+
+using namespace Logic;
+
+SCENARIO("JSON objects are parsed", "[Json]") {
+    GIVEN("An object with strings, escapes, nested values and literals") {
+        const string json = "{ \"id\": [1, {\"a\": \"}\"}], \"script\": \"p \\\"x\\\";\\n\\u00e9\", \"n\": -1.5e3, \"t\": true }";
+
+        WHEN("It is parsed") {
+            const unordered_map<string, JsonMember> members = parseJsonObject(json);
+
+            THEN("The strings are decoded, and the raw JSON of the other values is kept") {
+                REQUIRE(members.size() == 4);
+                REQUIRE(members.at("script").isString);
+                REQUIRE(members.at("script").value == "p \"x\";\n\xc3\xa9");
+                REQUIRE(!members.at("id").isString);
+                REQUIRE(members.at("id").raw == "[1, {\"a\": \"}\"}]");
+                REQUIRE(members.at("n").raw == "-1.5e3");
+                REQUIRE(members.at("t").raw == "true");
+            }
+        }
+    }
+
+    GIVEN("Strings with the characters outside of the basic plane escaped as surrogate pairs") {
+        THEN("The pairs are decoded as single characters, and the surrogates without their pairs are rejected") {
+            REQUIRE(parseJsonObject("{\"a\": \"\\uD83D\\uDE00!\"}").at("a").value == "\xf0\x9f\x98\x80!");
+            REQUIRE(parseJsonObject("{\"a\": \"\\udbff\\udfff\"}").at("a").value == "\xf4\x8f\xbf\xbf");
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\uD83D\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\uD83Dx\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\uD83D\\u0041\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\uDE00\"}"), invalid_argument);
+        }
+    }
+
+    GIVEN("Malformed JSON") {
+        THEN("Parsing it throws") {
+            REQUIRE_THROWS_AS(parseJsonObject("[1]"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": }"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"b}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": 1} x"), invalid_argument);
+        }
+    }
+
+    GIVEN("Strings with every escape") {
+        THEN("The valid ones are decoded, and the unknown ones are rejected, also in the raw values") {
+            REQUIRE(parseJsonObject("{\"a\": \"\\\"\\\\\\/\\b\\f\\n\\r\\t\"}").at("a").value == "\"\\/\b\f\n\r\t");
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\q\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\x41\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"a\": \"\\'\"}"), invalid_argument);
+            REQUIRE_THROWS_AS(parseJsonObject("{\"id\": [\"\\q\"]}"), invalid_argument);
+        }
+    }
+}
+
+SCENARIO("Values are written as JSON", "[Json]") {
+    GIVEN("Strings and Boolean functions") {
+        THEN("They are escaped and encoded") {
+            REQUIRE(toJson(string("a\"b\\\n\x01")) == "\"a\\\"b\\\\\\n\\u0001\"");
+            REQUIRE(toJson(BooleanFunction(true)) == "{\"value\":1}");
+        }
+    }
+}